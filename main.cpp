@@ -4,8 +4,354 @@
 #include <ctime>
 #include <iomanip>
 #include <vector>
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <csignal>
+#include <cstring>
+#include <climits>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include <sstream>
+#include <string_view>
+#include <charconv>
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+#include <coroutine>
+#define COROUTINE_SESSIONS 1
+#else
+#define COROUTINE_SESSIONS 0
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
 using namespace std;
 
+// Instrumentation
+// Per-operation call counts and HDR-style latency histograms (8 log-spaced buckets per power
+// of two, ~12% precision). Each thread records into its own block, so the hot path never
+// contends. Compile with -DSTATS_ENABLED=0 to remove every probe.
+#ifndef STATS_ENABLED
+#define STATS_ENABLED 1
+#endif
+
+enum StatOp {
+    OP_COURSE_SEARCH,
+    OP_STUDENT_SEARCH,
+    OP_ENQUEUE,
+    OP_DEQUEUE,
+    OP_CANCEL_REQUEST,
+    OP_LOAD_STUDENTS,
+    OP_LOAD_COURSES,
+    OP_LOAD_REQUESTS,
+    OP_SAVE_STUDENTS,
+    OP_SAVE_COURSES,
+    OP_SAVE_REQUESTS,
+    OP_SERVER_REQUEST,
+    OP_COUNT
+};
+
+const char* statOpNames[OP_COUNT] = {
+    "courseTree.search", "studentTree.search", "regQueue.enqueue", "regQueue.dequeue",
+    "markRequestAsCancelled", "loadStudents", "loadCourses", "loadPendingRequests",
+    "saveStudents", "saveCourses", "savePendingRequests", "serverCommand"
+};
+
+const int HISTOGRAM_BUCKETS = 496;
+
+struct OpStats {
+    atomic<unsigned long long> count;
+    atomic<unsigned long long> totalNs;
+    atomic<unsigned long long> maxNs;
+    atomic<unsigned long long> buckets[HISTOGRAM_BUCKETS];
+};
+
+// One per thread, linked into a global list so a report can sum them
+struct StatsBlock {
+    OpStats ops[OP_COUNT];
+    StatsBlock* nextBlock;
+};
+
+atomic<StatsBlock*> statsBlocks(NULL);
+
+int histogramBucket(unsigned long long ns) {
+    if (ns < 8) return ns;
+    int msb = 63 - __builtin_clzll(ns);
+    return (msb - 2) * 8 + ((ns >> (msb - 3)) & 7);
+}
+
+// Largest value that falls into bucket b
+unsigned long long histogramBucketLimit(int b) {
+    if (b < 8) return b;
+    int shift = b / 8 - 1;
+    return ((unsigned long long)(8 + b % 8 + 1) << shift) - 1;
+}
+
+StatsBlock* localStatsBlock() {
+    static thread_local StatsBlock* block = NULL;
+    if (block == NULL) {
+        block = new StatsBlock();
+        for (int op = 0; op < OP_COUNT; op++) {
+            block->ops[op].count = block->ops[op].totalNs = block->ops[op].maxNs = 0;
+            for (int b = 0; b < HISTOGRAM_BUCKETS; b++) block->ops[op].buckets[b] = 0;
+        }
+        block->nextBlock = statsBlocks.load();
+        while (!statsBlocks.compare_exchange_weak(block->nextBlock, block)) {}
+    }
+    return block;
+}
+
+// Only the owning thread writes a block, so plain relaxed load/store pairs are enough
+inline void bumpStat(atomic<unsigned long long>& counter, unsigned long long by) {
+    counter.store(counter.load(memory_order_relaxed) + by, memory_order_relaxed);
+}
+
+void recordLatency(StatOp op, unsigned long long ns) {
+    OpStats& s = localStatsBlock()->ops[op];
+    bumpStat(s.count, 1);
+    bumpStat(s.totalNs, ns);
+    if (ns > s.maxNs.load(memory_order_relaxed)) s.maxNs.store(ns, memory_order_relaxed);
+    bumpStat(s.buckets[histogramBucket(ns)], 1);
+}
+
+class ScopedLatency {
+private:
+    StatOp op;
+    chrono::steady_clock::time_point start;
+
+public:
+    ScopedLatency(StatOp o) : op(o), start(chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        recordLatency(op, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    }
+};
+
+#define STAT_CONCAT2(a, b) a##b
+#define STAT_CONCAT(a, b) STAT_CONCAT2(a, b)
+
+#if STATS_ENABLED
+#define STAT_SCOPE(op) ScopedLatency STAT_CONCAT(statScope, __LINE__)(op)
+#else
+#define STAT_SCOPE(op)
+#endif
+
+// Event Tracing
+// Scoped spans write begin/end events into a per-thread ring buffer (single writer, no locks)
+// that is dumped in Chrome trace format for chrome://tracing or Perfetto. Only one in
+// traceSampleEvery spans per thread is recorded. Compile with -DTRACE_ENABLED=0 to remove.
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+enum TraceEvent {
+    TRACE_LOAD,
+    TRACE_SAVE,
+    TRACE_DRAIN,
+    TRACE_APPROVE,
+    TRACE_REJECT,
+    TRACE_REGISTER,
+    TRACE_DROP,
+    TRACE_RETRACT,
+    TRACE_EVENT_COUNT
+};
+
+const char* traceEventNames[TRACE_EVENT_COUNT] = {
+    "load", "save", "drain", "approve", "reject", "register", "drop", "retract"
+};
+
+const int TRACE_CAPACITY = 1 << 16; // events per thread; older events are overwritten
+
+struct TraceRecord {
+    long long timestampNs;
+    const char* detail;
+    unsigned short event;
+    char phase; // 'B' or 'E'
+};
+
+struct TraceBuffer {
+    TraceRecord records[TRACE_CAPACITY];
+    atomic<unsigned long long> head;
+    unsigned sampleCounter;
+    int threadId;
+    TraceBuffer* nextBuffer;
+};
+
+atomic<TraceBuffer*> traceBuffers(NULL);
+atomic<int> traceThreadCount(0);
+bool tracingEnabled = false;
+unsigned traceSampleEvery = 1;
+string traceFileName = "";
+chrono::steady_clock::time_point traceEpoch = chrono::steady_clock::now();
+
+TraceBuffer* localTraceBuffer() {
+    static thread_local TraceBuffer* buffer = NULL;
+    if (buffer == NULL) {
+        buffer = new TraceBuffer();
+        buffer->head = 0;
+        buffer->sampleCounter = 0;
+        buffer->threadId = ++traceThreadCount;
+        buffer->nextBuffer = traceBuffers.load();
+        while (!traceBuffers.compare_exchange_weak(buffer->nextBuffer, buffer)) {}
+    }
+    return buffer;
+}
+
+inline void traceRecord(TraceBuffer* buffer, unsigned short event, char phase, const char* detail) {
+    unsigned long long h = buffer->head.load(memory_order_relaxed);
+    TraceRecord& r = buffer->records[h & (TRACE_CAPACITY - 1)];
+    r.timestampNs = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - traceEpoch).count();
+    r.detail = detail;
+    r.event = event;
+    r.phase = phase;
+    buffer->head.store(h + 1, memory_order_release);
+}
+
+class TraceSpan {
+private:
+    TraceBuffer* buffer; // NULL when this span is not sampled
+    unsigned short event;
+    const char* detail;
+
+public:
+    TraceSpan(TraceEvent e, const char* d) : buffer(NULL), event(e), detail(d) {
+        if (!tracingEnabled) return;
+        TraceBuffer* b = localTraceBuffer();
+        if (b->sampleCounter++ % traceSampleEvery != 0) return;
+        buffer = b;
+        traceRecord(buffer, event, 'B', detail);
+    }
+
+    ~TraceSpan() {
+        if (buffer != NULL) traceRecord(buffer, event, 'E', detail);
+    }
+};
+
+#if TRACE_ENABLED
+#define TRACE_SPAN(event, detail) TraceSpan STAT_CONCAT(traceSpan, __LINE__)(event, detail)
+#else
+#define TRACE_SPAN(event, detail)
+#endif
+
+// Operation Log
+// With replication on, every change to students, courses and the queue is appended here as one
+// tab-separated line, in the order it was applied. A replica applies the same lines in the same
+// order to the same starting data, logging them again as it goes, so any node can take over.
+struct LoggedOp {
+    string op;
+    long long loggedUs; // steady clock when the primary first logged it
+};
+
+vector<LoggedOp> opLog;
+bool opLogging = false;
+
+long long steadyMicros() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void logOp(const string& op) {
+    LoggedOp entry = { op, steadyMicros() };
+    opLog.push_back(entry);
+}
+
+// Packed Keys
+// Matric numbers and course codes are short, so a key packs the first 15 bytes of the string
+// big-endian into two integers, with the length (capped at 16) in the last byte. Comparing the
+// integers orders keys exactly like comparing the strings; only two keys longer than 15 bytes
+// that share those 15 bytes tie, and then the strings decide.
+struct PackedKey {
+    unsigned long long hi;
+    unsigned long long lo;
+
+    PackedKey() : hi(0), lo(0) {}
+
+    explicit PackedKey(const string& text) {
+        unsigned char bytes[16] = { 0 };
+        memcpy(bytes, text.data(), text.size() < 15 ? text.size() : 15);
+        bytes[15] = text.size() < 16 ? text.size() : 16;
+        hi = lo = 0;
+        for (int i = 0; i < 8; i++) {
+            hi = (hi << 8) | bytes[i];
+            lo = (lo << 8) | bytes[8 + i];
+        }
+    }
+
+    bool truncated() const { return (lo & 0xFF) == 16; }
+};
+
+// Three-way comparison of two keys; the strings are only read on a tie between truncated keys
+inline int compareKeys(const PackedKey& a, const string& aText, const PackedKey& b, const string& bText) {
+    if (a.hi != b.hi) return a.hi < b.hi ? -1 : 1;
+    if (a.lo != b.lo) return a.lo < b.lo ? -1 : 1;
+    return a.truncated() ? aText.compare(bText) : 0;
+}
+
+inline size_t packedKeyHash(const PackedKey& key) {
+    unsigned long long h = key.hi * 0x9E3779B97F4A7C15ULL ^ key.lo;
+    return h ^ (h >> 29);
+}
+
+inline bool sameKey(const PackedKey& a, const string& aText, const PackedKey& b, const string& bText) {
+    return a.hi == b.hi && a.lo == b.lo && (!a.truncated() || aText == bText);
+}
+
+// Index of the first key in keys[0..n) whose packed value equals target, or n if there is none.
+// Tests four keys per step, two per vector compare (SSE2) or 64-bit compare (AVX2).
+size_t scanPackedKeys(const PackedKey* keys, size_t n, const PackedKey& target) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i wanted = _mm256_set_epi64x(target.lo, target.hi, target.lo, target.hi);
+    for (; i + 4 <= n; i += 4) {
+        // One bit per 64-bit word: a key matches when both of its words do
+        int front = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(keys + i)), wanted)));
+        int back = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(keys + i + 2)), wanted)));
+        int hits = ((front & 3) == 3) | ((front >> 2) == 3) << 1 | ((back & 3) == 3) << 2 | ((back >> 2) == 3) << 3;
+        if (hits != 0) return i + __builtin_ctz(hits);
+    }
+#elif defined(__SSE2__)
+    __m128i wanted = _mm_set_epi64x(target.lo, target.hi);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        // XOR with the target, then OR each key's two words together: a key matches when its result is 0
+        __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), wanted);
+        __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i + 1)), wanted);
+        __m128i c = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i + 2)), wanted);
+        __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i + 3)), wanted);
+        __m128i ab = _mm_or_si128(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+        __m128i cd = _mm_or_si128(_mm_unpacklo_epi64(c, d), _mm_unpackhi_epi64(c, d));
+        int front = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(ab, zero)));
+        int back = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(cd, zero)));
+        int hits = ((front & 3) == 3) | ((front >> 2) == 3) << 1 | ((back & 3) == 3) << 2 | ((back >> 2) == 3) << 3;
+        if (hits != 0) return i + __builtin_ctz(hits);
+    }
+#endif
+    for (; i < n; i++) {
+        if (keys[i].hi == target.hi && keys[i].lo == target.lo) return i;
+    }
+    return n;
+}
+
 struct Student;
 struct Course;
 struct StudentNode;
@@ -60,55 +406,194 @@ public:
     }
 };
 
+// Record Pools
+// Hot records are carved out of 64 KB blocks, so they sit densely in memory with no allocator
+// headers between them. Freed records are reused. Only the main thread creates and frees records.
+template <class T>
+class RecordPool {
+private:
+    static const size_t PER_BLOCK = 65536 / sizeof(T);
+    vector<char*> blocks;
+    void* freeList;
+    size_t used; // records handed out from the newest block
+
+public:
+    RecordPool() : freeList(NULL), used(PER_BLOCK) {}
+
+    void* allocate() {
+        if (freeList != NULL) {
+            void* record = freeList;
+            freeList = *(void**)record;
+            return record;
+        }
+        if (used == PER_BLOCK) {
+            blocks.push_back((char*)::operator new(PER_BLOCK * sizeof(T), align_val_t(alignof(T))));
+            used = 0;
+        }
+        return blocks.back() + sizeof(T) * used++;
+    }
+
+    void release(void* record) {
+        *(void**)record = freeList;
+        freeList = record;
+    }
+
+    // Blocks stay allocated until exit: records may still be freed during static destruction
+};
+
 // Student structure
-struct Student {
+// Split in two: the Student record is one cache line with what tree walks, admission checks and
+// the queue drain read; names, program, notifications and index links live in its profile.
+struct StudentProfile {
     string name;
     string matricNo;
-    int maxCredit;
-    int currentCredit;
     int year;
     string program;
-    CourseNode* courseList;
     NotificationStack notifications;
+    Student* headroomPrev; // neighbours in the student index headroom bucket
+    Student* headroomNext;
+
+    StudentProfile(const string& _name, const string& _matricNo, int _year, const string& _program)
+    : name(_name), matricNo(_matricNo), year(_year), program(_program), notifications(), headroomPrev(NULL), headroomNext(NULL) {}
+};
+
+struct alignas(64) Student {
+    PackedKey matricKey;
     Student* left;
     Student* right;
+    int maxCredit;
+    int currentCredit;  // approvedCredit + pendingCredit
+    int approvedCredit;
+    int pendingCredit;
+    CourseNode* courseList;
+    StudentProfile* profile;
 
     Student(string _name, string _matricNo, int _maxCredit, int _currentCredit, int _year, string _program) 
-    : name(_name), matricNo(_matricNo), maxCredit(_maxCredit), currentCredit(_currentCredit), year(_year), program(_program), courseList(NULL), notifications(), left(NULL), right(NULL) {}
+    : matricKey(_matricNo), left(NULL), right(NULL), maxCredit(_maxCredit), currentCredit(_currentCredit), approvedCredit(0), pendingCredit(_currentCredit), courseList(NULL), profile(new StudentProfile(_name, _matricNo, _year, _program)) {}
+
+    Student(const Student&) = delete;
+    Student& operator=(const Student&) = delete;
+    ~Student() { delete profile; }
+
+    static void* operator new(size_t size);
+    static void operator delete(void* record);
 };
 
 // Course structure
-struct Course {
+// Same split: the Course record holds the key, tree links and seat counts, its details the strings
+struct CourseDetails {
     string courseCode;
     string courseName;
     string lecturerName;
+};
+
+struct alignas(64) Course {
+    PackedKey codeKey;
+    Course* left;
+    Course* right;
     int credit;
     int capacity;
-    int currentCapacity;
+    atomic<int> currentCapacity; // seats taken; read without locks through the course catalog
     StudentNode* studentList;
-    Course* left;
-    Course* right;
+    CourseDetails* details;
 
     Course(string _courseCode, string _courseName, string _lecturerName, int _credit, int _capacity, int _currentCapacity) 
-    : courseCode(_courseCode), courseName(_courseName), lecturerName(_lecturerName), credit(_credit), capacity(_capacity), currentCapacity(_currentCapacity), studentList(NULL), left(NULL), right(NULL) {}
+    : codeKey(_courseCode), left(NULL), right(NULL), credit(_credit), capacity(_capacity), currentCapacity(_currentCapacity), studentList(NULL), details(new CourseDetails()) {
+        details->courseCode = _courseCode;
+        details->courseName = _courseName;
+        details->lecturerName = _lecturerName;
+    }
+
+    ~Course() { delete details; }
+
+    static void* operator new(size_t size);
+    static void operator delete(void* record);
 };
 
+static_assert(sizeof(Student) == 64 && sizeof(Course) == 64, "hot records should fill one cache line");
+
+RecordPool<Student> studentPool;
+RecordPool<Course> coursePool;
+
+void* Student::operator new(size_t) { return studentPool.allocate(); }
+void Student::operator delete(void* record) { studentPool.release(record); }
+void* Course::operator new(size_t) { return coursePool.allocate(); }
+void Course::operator delete(void* record) { coursePool.release(record); }
+
 // Student Node in Linked List (for course's student list)
 struct StudentNode {
     string matricNo;
+    PackedKey key;
     string name;
     StudentNode* next;
     
-    StudentNode(string m, string n) : matricNo(m), name(n), next(NULL) {}
+    StudentNode(string m, string n) : matricNo(m), key(matricNo), name(n), next(NULL) {}
 };
 
 // Course Node in Linked List (for student's course list)
 struct CourseNode {
     string courseCode;
+    PackedKey key;
     string status; // "Pending" or "Approved"
     CourseNode* next;
     
-    CourseNode(string code, string stat) : courseCode(code), status(stat), next(NULL) {}
+    CourseNode(string code, string stat) : courseCode(code), key(courseCode), status(stat), next(NULL) {}
+};
+
+// Buffered Output
+// Collects formatted text and writes it to the stream in large chunks,
+// instead of one unbuffered << chain per field.
+class OutputBuffer {
+private:
+    ostream& out;
+    string buffer;
+    size_t limit;
+
+public:
+    OutputBuffer(ostream& o, size_t lim = 64 * 1024) : out(o), limit(lim) {
+        buffer.reserve(lim);
+    }
+
+    OutputBuffer& operator<<(const string& text) {
+        buffer += text;
+        if (buffer.size() >= limit) flush();
+        return *this;
+    }
+
+    OutputBuffer& operator<<(const char* text) {
+        buffer += text;
+        if (buffer.size() >= limit) flush();
+        return *this;
+    }
+
+    OutputBuffer& operator<<(char c) {
+        buffer += c;
+        if (buffer.size() >= limit) flush();
+        return *this;
+    }
+
+    OutputBuffer& operator<<(long value) {
+        char digits[24];
+        int len = snprintf(digits, sizeof(digits), "%ld", value);
+        buffer.append(digits, len);
+        if (buffer.size() >= limit) flush();
+        return *this;
+    }
+
+    OutputBuffer& operator<<(int value) {
+        return *this << (long)value;
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+
+    ~OutputBuffer() {
+        flush();
+    }
 };
 
 // Registration Request for Queue
@@ -117,42 +602,274 @@ struct RegistrationRequest {
     string studentName;
     string courseCode;
     string courseName;
+    PackedKey matricKey;
+    PackedKey courseKey;
     int credit;
     time_t timestamp;
     bool isCancelled;
     RegistrationRequest* next;
+    RegistrationRequest* prev;
+    RegistrationRequest* package;   // the other courses of a package request; they never enter the queue themselves
+    RegistrationRequest* owner;     // the queued request this course belongs to (itself unless a package course)
+    RegistrationRequest* laneNext;  // neighbours among the live requests for the same course
+    RegistrationRequest* lanePrev;
+    int rankSlot;                   // arrival slot in the queue's rank index (queued requests only)
+    int laneSlot;                   // arrival slot in its course lane's rank index
     
     RegistrationRequest(string matric, string sName, string cCode, string cName, int cred) 
     : matricNo(matric), studentName(sName), courseCode(cCode), courseName(cName),
-      credit(cred), timestamp(time(0)), isCancelled(false), next(NULL) {}
+      matricKey(matricNo), courseKey(courseCode), credit(cred), timestamp(time(0)), isCancelled(false), next(NULL), prev(NULL),
+      package(NULL), owner(this), laneNext(NULL), lanePrev(NULL), rankSlot(0), laneSlot(0) {}
+
+    ~RegistrationRequest() { delete package; }
+
+    // Every course code in the request, joined with '+' for a package
+    string allCodes() const {
+        string codes = courseCode;
+        for (RegistrationRequest* member = package; member != NULL; member = member->package) codes += "+" + member->courseCode;
+        return codes;
+    }
+};
+
+// Rank Index
+// A Fenwick tree over arrival slots, 1 while the item in the slot is live and 0 once it is gone,
+// so an item's place among the live ones is a prefix sum in O(log n). When the slots run out
+// and at most half are live, the owner renumbers its live items and calls reset() instead of growing.
+class RankIndex {
+private:
+    vector<char> live;
+    vector<int> tree; // tree[i] sums the slots (i - lowbit(i), i], 1-based
+    int used;
+    int liveCount;
+
+    void rebuild(int capacity) {
+        live.resize(capacity, 0);
+        tree.assign(capacity + 1, 0);
+        for (int i = 1; i <= capacity; i++) {
+            tree[i] += live[i - 1];
+            int parent = i + (i & -i);
+            if (parent <= capacity) tree[parent] += tree[i];
+        }
+    }
+
+public:
+    RankIndex() : used(0), liveCount(0) {}
+
+    bool needsRenumber() const {
+        return used > 0 && used == (int)live.size() && liveCount * 2 <= used;
+    }
+
+    // Starts over with count live items in slots 0..count-1
+    void reset(int count) {
+        live.assign(count, 1);
+        used = liveCount = count;
+        rebuild(max(8, count * 2));
+    }
+
+    // Hands out the next slot, live
+    int add() {
+        if (used == (int)live.size()) rebuild(max(8, used * 2));
+        live[used] = 1;
+        for (int i = used + 1; i < (int)tree.size(); i += i & -i) tree[i]++;
+        liveCount++;
+        return used++;
+    }
+
+    void remove(int slot) {
+        if (!live[slot]) return;
+        live[slot] = 0;
+        for (int i = slot + 1; i < (int)tree.size(); i += i & -i) tree[i]--;
+        liveCount--;
+    }
+
+    // 1-based place of a live slot among the live slots
+    int rank(int slot) const {
+        int sum = 0;
+        for (int i = slot + 1; i > 0; i -= i & -i) sum += tree[i];
+        return sum;
+    }
+};
+
+// A student's live request for one course, for finding it without walking the queue
+struct StudentCourseKey {
+    PackedKey matric;
+    PackedKey course;
+
+    bool operator==(const StudentCourseKey& other) const {
+        return matric.hi == other.matric.hi && matric.lo == other.matric.lo &&
+               course.hi == other.course.hi && course.lo == other.course.lo;
+    }
+};
+
+struct StudentCourseHash {
+    size_t operator()(const StudentCourseKey& key) const {
+        unsigned long long h = key.matric.hi * 0x9E3779B97F4A7C15ULL ^ key.matric.lo;
+        h = (h ^ key.course.hi) * 0x9E3779B97F4A7C15ULL ^ key.course.lo;
+        return h ^ (h >> 29);
+    }
 };
 
 // Queue for Registration Requests
+// One first-come-first-served list, plus a lane per course threading that course's live requests
+// in the same order, so one course's requests can be counted and drained without walking the rest.
+struct CourseLane {
+    RegistrationRequest* head;
+    RegistrationRequest* tail;
+    int count;
+    RankIndex ranks;
+
+    CourseLane() : head(NULL), tail(NULL), count(0) {}
+};
+
 class RegistrationQueue {
 private:
     RegistrationRequest* front;
     RegistrationRequest* rear;
+    int liveCount;
+    int length;
+    unordered_map<string, CourseLane> lanes;
+    RankIndex ranks;
+    unordered_multimap<StudentCourseKey, RegistrationRequest*, StudentCourseHash> byStudent;
+
+    static StudentCourseKey studentCourse(RegistrationRequest* req) {
+        StudentCourseKey key = { req->matricKey, req->courseKey };
+        return key;
+    }
+
+    void forgetStudentCourse(RegistrationRequest* req) {
+        typedef unordered_multimap<StudentCourseKey, RegistrationRequest*, StudentCourseHash>::iterator Iter;
+        pair<Iter, Iter> range = byStudent.equal_range(studentCourse(req));
+        for (Iter it = range.first; it != range.second; ++it) {
+            if (it->second == req) {
+                byStudent.erase(it);
+                return;
+            }
+        }
+    }
+
+    // Gives the live requests slots 0..n-1 in queue order
+    void renumber() {
+        int slot = 0;
+        for (RegistrationRequest* req = front; req != NULL; req = req->next) {
+            if (!req->isCancelled) req->rankSlot = slot++;
+        }
+        ranks.reset(slot);
+    }
+
+    void laneLink(RegistrationRequest* req) {
+        CourseLane& lane = lanes[req->courseCode];
+        req->lanePrev = lane.tail;
+        req->laneNext = NULL;
+        if (lane.tail != NULL) lane.tail->laneNext = req;
+        else lane.head = req;
+        lane.tail = req;
+        lane.count++;
+        if (lane.ranks.needsRenumber()) {
+            int slot = 0;
+            for (RegistrationRequest* entry = lane.head; entry != req; entry = entry->laneNext) entry->laneSlot = slot++;
+            lane.ranks.reset(slot);
+        }
+        req->laneSlot = lane.ranks.add();
+        byStudent.insert(make_pair(studentCourse(req), req));
+    }
+
+    void laneUnlink(RegistrationRequest* req) {
+        unordered_map<string, CourseLane>::iterator it = lanes.find(req->courseCode);
+        CourseLane& lane = it->second;
+        if (req->lanePrev != NULL) req->lanePrev->laneNext = req->laneNext;
+        else lane.head = req->laneNext;
+        if (req->laneNext != NULL) req->laneNext->lanePrev = req->lanePrev;
+        else lane.tail = req->lanePrev;
+        req->laneNext = req->lanePrev = NULL;
+        lane.ranks.remove(req->laneSlot);
+        forgetStudentCourse(req);
+        if (--lane.count == 0) lanes.erase(it);
+    }
+
+    // Puts replacement in old's place in old's lane
+    void laneReplace(RegistrationRequest* old, RegistrationRequest* replacement) {
+        CourseLane& lane = lanes[old->courseCode];
+        replacement->lanePrev = old->lanePrev;
+        replacement->laneNext = old->laneNext;
+        if (old->lanePrev != NULL) old->lanePrev->laneNext = replacement;
+        else lane.head = replacement;
+        if (old->laneNext != NULL) old->laneNext->lanePrev = replacement;
+        else lane.tail = replacement;
+        old->laneNext = old->lanePrev = NULL;
+        replacement->laneSlot = old->laneSlot;
+        forgetStudentCourse(old);
+        byStudent.insert(make_pair(studentCourse(old), replacement));
+    }
+
+    void unlinkLanes(RegistrationRequest* req) {
+        for (RegistrationRequest* member = req; member != NULL; member = member->package) laneUnlink(member);
+    }
     
 public:
-    RegistrationQueue() : front(NULL), rear(NULL) {}
+    RegistrationQueue() : front(NULL), rear(NULL), liveCount(0), length(0) {}
 
     void enqueue(string matric, string sName, string code, string cName, int cred) {
+        STAT_SCOPE(OP_ENQUEUE);
         RegistrationRequest* newReq = new RegistrationRequest(matric, sName, code, cName, cred);
+        if (ranks.needsRenumber()) renumber();
+        newReq->rankSlot = ranks.add();
         if (rear == NULL) {
             front = rear = newReq;
         } else {
+            newReq->prev = rear;
             rear->next = newReq;
             rear = newReq;
         }
+        laneLink(newReq);
+        liveCount++;
+        length++;
+    }
+
+    // Adds another course to the request at the rear, making it a package that is decided all or nothing
+    void extendRear(string code, string cName, int cred) {
+        RegistrationRequest* member = new RegistrationRequest(rear->matricNo, rear->studentName, code, cName, cred);
+        member->timestamp = rear->timestamp;
+        member->owner = rear;
+        RegistrationRequest* last = rear;
+        while (last->package != NULL) last = last->package;
+        last->package = member;
+        if (!rear->isCancelled) laneLink(member);
     }
     
     RegistrationRequest* dequeue() {
+        STAT_SCOPE(OP_DEQUEUE);
         if (front == NULL) return NULL;
         RegistrationRequest* temp = front;
         front = front->next;
         if (front == NULL) rear = NULL;
+        else front->prev = NULL;
+        temp->next = NULL;
+        if (!temp->isCancelled) {
+            if (opLogging) logOp("TAKE\t" + temp->matricNo + "\t" + temp->courseCode);
+            ranks.remove(temp->rankSlot);
+            unlinkLanes(temp);
+            liveCount--;
+        }
+        length--;
         return temp;
     }
+
+    // Takes a request out of the queue wherever it is, for deciding requests out of order.
+    // The caller owns it afterwards.
+    void remove(RegistrationRequest* req) {
+        if (req->prev != NULL) req->prev->next = req->next;
+        else front = req->next;
+        if (req->next != NULL) req->next->prev = req->prev;
+        else rear = req->prev;
+        req->next = req->prev = NULL;
+        if (!req->isCancelled) {
+            if (opLogging) logOp("TAKE\t" + req->matricNo + "\t" + req->courseCode);
+            ranks.remove(req->rankSlot);
+            unlinkLanes(req);
+            liveCount--;
+        }
+        length--;
+    }
     
     RegistrationRequest* getFront() {
         return front;
@@ -166,21 +883,137 @@ public:
         return front == NULL;
     }
     
-    void display() {
-        if (front == NULL) {
+    void cancel(RegistrationRequest* req) {
+        if (req->isCancelled) return;
+        req->isCancelled = true;
+        ranks.remove(req->rankSlot);
+        unlinkLanes(req);
+        liveCount--;
+    }
+
+    // Takes one course out of a live request. A package keeps its other courses; a request left
+    // with no course is cancelled. Returns false if the request does not hold the course.
+    bool cancelCourse(RegistrationRequest* req, const PackedKey& key, const string& code) {
+        if (req->isCancelled) return false;
+        if (sameKey(req->courseKey, req->courseCode, key, code)) {
+            RegistrationRequest* member = req->package;
+            if (member == NULL) {
+                cancel(req);
+                return true;
+            }
+            // The next course takes the dropped one's place at the head, keeping the queue position
+            laneUnlink(req);
+            laneReplace(member, req);
+            req->courseCode = member->courseCode;
+            req->courseName = member->courseName;
+            req->courseKey = member->courseKey;
+            req->credit = member->credit;
+            req->package = member->package;
+            member->package = NULL;
+            delete member;
+            return true;
+        }
+        for (RegistrationRequest* prev = req; prev->package != NULL; prev = prev->package) {
+            RegistrationRequest* member = prev->package;
+            if (sameKey(member->courseKey, member->courseCode, key, code)) {
+                laneUnlink(member);
+                prev->package = member->package;
+                member->package = NULL;
+                delete member;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Number of requests that have not been cancelled
+    int getLiveCount() {
+        return liveCount;
+    }
+
+    // Number of requests in the queue, including cancelled ones not yet skipped
+    int getLength() {
+        return length;
+    }
+
+    // Live requests that include the course, packages included
+    int getPendingFor(const string& code) {
+        unordered_map<string, CourseLane>::iterator it = lanes.find(code);
+        return it == lanes.end() ? 0 : it->second.count;
+    }
+
+    // The oldest live request that includes the course, or NULL
+    RegistrationRequest* firstFor(const string& code) {
+        unordered_map<string, CourseLane>::iterator it = lanes.find(code);
+        return it == lanes.end() ? NULL : it->second.head->owner;
+    }
+
+    // The live entry holding the student's request for the course: the queued request itself,
+    // or the package course inside one. NULL if there is none.
+    RegistrationRequest* findPending(const string& matric, const string& code) {
+        StudentCourseKey key = { PackedKey(matric), PackedKey(code) };
+        typedef unordered_multimap<StudentCourseKey, RegistrationRequest*, StudentCourseHash>::iterator Iter;
+        pair<Iter, Iter> range = byStudent.equal_range(key);
+        for (Iter it = range.first; it != range.second; ++it) {
+            RegistrationRequest* entry = it->second;
+            if (sameKey(entry->matricKey, entry->matricNo, key.matric, matric) && sameKey(entry->courseKey, entry->courseCode, key.course, code)) {
+                return entry;
+            }
+        }
+        return NULL;
+    }
+
+    // 1-based place of a live entry's request among all live requests
+    int positionOf(RegistrationRequest* entry) {
+        return ranks.rank(entry->owner->rankSlot);
+    }
+
+    // 1-based place of a live entry among the live requests for its course
+    int positionInCourse(RegistrationRequest* entry) {
+        return lanes.find(entry->courseCode)->second.ranks.rank(entry->laneSlot);
+    }
+
+    // Shows the first limit live requests for one course
+    void displayFor(const string& code, int limit) {
+        int pending = getPendingFor(code);
+        if (pending == 0) {
+            cout << "No pending requests for " << code << ".\n";
+            return;
+        }
+        OutputBuffer out(cout);
+        int count = 1;
+        for (RegistrationRequest* lane = lanes[code].head; lane != NULL && count <= limit; lane = lane->laneNext) {
+            RegistrationRequest* temp = lane->owner;
+            out << count++ << ". " << temp->studentName << " (" << temp->matricNo << ")";
+            if (temp->package != NULL) out << " - package " << temp->allCodes();
+            out << "\n";
+        }
+        if (pending > limit) {
+            out << "... and " << pending - limit << " more pending request(s)\n";
+        }
+    }
+
+    // Shows the first limit live requests; the rest are only counted
+    void display(int limit) {
+        if (liveCount == 0) {
             cout << "No pending requests.\n";
             return;
         }
         
+        OutputBuffer out(cout);
         RegistrationRequest* temp = front;
         int count = 1;
-        while (temp != NULL) {
+        while (temp != NULL && count <= limit) {
             if (!temp->isCancelled) {
-                cout << count++ << ". " << temp->studentName << " (" << temp->matricNo 
-                     << ") - " << temp->courseCode << " " << temp->courseName << "\n";
+                out << count++ << ". " << temp->studentName << " (" << temp->matricNo << ") - ";
+                if (temp->package == NULL) out << temp->courseCode << " " << temp->courseName << "\n";
+                else out << temp->allCodes() << " (package, all or none)\n";
             }
             temp = temp->next;
         }
+        if (liveCount > limit) {
+            out << "... and " << liveCount - limit << " more pending request(s)\n";
+        }
     }
 
     ~RegistrationQueue() {
@@ -191,1571 +1024,9746 @@ public:
     }
 };
 
-// Course BST
-class CourseBST {
+// In-order Cursor over a BST
+// Walks the tree with an explicit stack, so listings never recurse and can resume from any key.
+inline const string& nodeKey(Course* course) { return course->details->courseCode; }
+inline const string& nodeKey(Student* student) { return student->profile->matricNo; }
+
+template <class Node>
+class TreeCursor {
 private:
-    Course* root;
-    
-    Course* insertRec(Course* node, Course* newCourse) {
-        if (node == NULL) return newCourse;
-        
-        if (newCourse->courseCode < node->courseCode)
-            node->left = insertRec(node->left, newCourse);
-        else if (newCourse->courseCode > node->courseCode)
-            node->right = insertRec(node->right, newCourse);
-            
-        return node;
-    }
-    
-    Course* searchRec(Course* node, string code) {
-        if (node == NULL || node->courseCode == code)
-            return node;
-            
-        if (code < node->courseCode)
-            return searchRec(node->left, code);
-        return searchRec(node->right, code);
-    }
-    
-    void inorderRec(Course* node) {
-        if (node != NULL) {
-            inorderRec(node->left);
-            cout << node->courseCode << " | " << node->courseName << " | " 
-                 << node->credit << " credit(s) | " << node->currentCapacity 
-                 << "/" << node->capacity << " students\n";
-            inorderRec(node->right);
+    vector<Node*> stack;
+
+    void pushLeft(Node* node) {
+        while (node != NULL) {
+            stack.push_back(node);
+            node = node->left;
         }
     }
-    
-    Course* deleteRec(Course* node, string code) {
-        if (!node) return nullptr;
 
-        if (code < node->courseCode) {
-            node->left = deleteRec(node->left, code);
-        }
-        else if (code > node->courseCode) {
-            node->right = deleteRec(node->right, code);
-        }
-        else {
-            // Case 1: no left child
-            if (!node->left) {
-                Course* temp = node->right;
-                node->left = node->right = nullptr;
-                delete node;
-                return temp;
-            }
-            // Case 2: no right child
-            else if (!node->right) {
-                Course* temp = node->left;
-                node->left = node->right = nullptr;
-                delete node;
-                return temp;
+public:
+    // Positions the cursor at the first node whose key is >= fromKey
+    TreeCursor(Node* root, const string& fromKey = "") {
+        Node* cur = root;
+        while (cur != NULL) {
+            if (nodeKey(cur) >= fromKey) {
+                stack.push_back(cur);
+                cur = cur->left;
+            } else {
+                cur = cur->right;
             }
-
-            // Case 3: two children
-            Course* successor = minValueNode(node->right);
-            node->courseCode = successor->courseCode;
-            node->courseName = successor->courseName;
-            node->lecturerName = successor->lecturerName;
-            node->credit = successor->credit;
-            node->capacity = successor->capacity;
-            node->currentCapacity = successor->currentCapacity;
-            node->studentList = successor->studentList;
-            successor->studentList = nullptr;
-            node->right = deleteRec(node->right, successor->courseCode);
         }
-        return node;
     }
 
-    
-    Course* minValueNode(Course* node) {
-        Course* current = node;
-        while (current && current->left != NULL)
-            current = current->left;
-        return current;
+    bool hasNext() {
+        return !stack.empty();
     }
 
-    void destroyCourseTree(Course* node) {
-    if (!node) return;
+    Node* next() {
+        Node* node = stack.back();
+        stack.pop_back();
+        pushLeft(node->right);
+        return node;
+    }
+};
 
-    destroyCourseTree(node->left);
-    destroyCourseTree(node->right);
+// Course BST
+// All walks are iterative, so even a degenerate (sorted-insert) tree cannot overflow the call stack.
+class CourseBST {
+private:
+    Course* root;
+    Course* maxNode; // rightmost node, for O(1) appends of increasing codes
+    
+    // Returns the link (root, or a parent's left/right) that points at code's node, or at NULL where it would go
+    Course** findLink(const string& code) {
+        PackedKey key(code);
+        Course** link = &root;
+        int order;
+        while (*link != NULL && (order = compareKeys(key, code, (*link)->codeKey, (*link)->details->courseCode)) != 0) {
+            link = order < 0 ? &(*link)->left : &(*link)->right;
+        }
+        return link;
+    }
 
-    StudentNode* cur = node->studentList;
-    while (cur) {
-        StudentNode* temp = cur;
-        cur = cur->next;
-        delete temp;
+    Course* rightmost() {
+        Course* current = root;
+        while (current != NULL && current->right != NULL)
+            current = current->right;
+        return current;
     }
 
-    delete node;
-}
+    // Flattens left subtrees into the right spine with rotations while freeing nodes: O(n) time, O(1) space
+    void destroyCourseTree(Course* node) {
+        while (node != NULL) {
+            if (node->left != NULL) {
+                Course* left = node->left;
+                node->left = left->right;
+                left->right = node;
+                node = left;
+                continue;
+            }
+
+            Course* next = node->right;
+            StudentNode* cur = node->studentList;
+            while (cur) {
+                StudentNode* temp = cur;
+                cur = cur->next;
+                delete temp;
+            }
+            delete node;
+            node = next;
+        }
+    }
     
 public:
-    CourseBST() : root(NULL) {}
+    CourseBST() : root(NULL), maxNode(NULL) {}
     
     void insert(Course* newCourse) {
-        root = insertRec(root, newCourse);
+        newCourse->left = newCourse->right = NULL;
+        // Codes arriving in increasing order attach straight under the rightmost node
+        if (maxNode != NULL && compareKeys(newCourse->codeKey, newCourse->details->courseCode, maxNode->codeKey, maxNode->details->courseCode) > 0) {
+            maxNode->right = newCourse;
+            maxNode = newCourse;
+            return;
+        }
+        Course** link = findLink(newCourse->details->courseCode);
+        if (*link != NULL) return;
+        *link = newCourse;
+        if (maxNode == NULL) maxNode = newCourse;
+    }
+
+    // Builds a height-balanced tree from courses sorted by code. The tree must be empty.
+    void buildBalanced(vector<Course*>& nodes) {
+        struct Range { int lo; int hi; Course** link; };
+        vector<Range> stack;
+        Range first = { 0, (int)nodes.size() - 1, &root };
+        stack.push_back(first);
+        while (!stack.empty()) {
+            Range r = stack.back();
+            stack.pop_back();
+            if (r.lo > r.hi) {
+                *r.link = NULL;
+                continue;
+            }
+            int mid = r.lo + (r.hi - r.lo) / 2;
+            Course* node = nodes[mid];
+            *r.link = node;
+            Range left = { r.lo, mid - 1, &node->left };
+            Range right = { mid + 1, r.hi, &node->right };
+            stack.push_back(left);
+            stack.push_back(right);
+        }
+        maxNode = nodes.empty() ? NULL : nodes.back();
     }
     
     Course* search(string code) {
-        return searchRec(root, code);
+        STAT_SCOPE(OP_COURSE_SEARCH);
+        return *findLink(code);
     }
     
-    void displayAll() {
-        if (root == NULL) {
-            cout << "No courses available.\n";
-            return;
+    // Prints up to pageSize courses starting at the first code >= fromKey.
+    // Returns the code to resume from, or "" when the listing is complete.
+    string displayPage(const string& fromKey, int pageSize) {
+        OutputBuffer out(cout);
+        TreeCursor<Course> cursor(root, fromKey);
+        for (int i = 0; i < pageSize && cursor.hasNext(); i++) {
+            Course* node = cursor.next();
+            out << node->details->courseCode << " | " << node->details->courseName << " | "
+                << node->credit << " credit(s) | " << node->currentCapacity
+                << "/" << node->capacity << " students\n";
         }
-        cout << "\n=== All Courses ===\n";
-        inorderRec(root);
+        return cursor.hasNext() ? cursor.next()->details->courseCode : "";
     }
     
     void deleteCourse(string code) {
-        root = deleteRec(root, code);
+        delete detachCourse(code);
+    }
+
+    // Unlinks a course from the tree and returns it (or NULL) without freeing it
+    Course* detachCourse(string code) {
+        Course** link = findLink(code);
+        Course* node = *link;
+        if (node == NULL) return NULL;
+
+        // Case 1 and 2: at most one child
+        if (node->left == NULL) {
+            *link = node->right;
+        } else if (node->right == NULL) {
+            *link = node->left;
+        } else {
+            // Case 3: two children
+            // Splice the successor node into this position rather than copying its fields,
+            // so Course pointers held by the search index stay valid.
+            Course* parent = node;
+            Course* successor = node->right;
+            while (successor->left != NULL) {
+                parent = successor;
+                successor = successor->left;
+            }
+            if (parent != node) {
+                parent->left = successor->right;
+                successor->right = node->right;
+            }
+            successor->left = node->left;
+            *link = successor;
+        }
+
+        bool wasMax = (node == maxNode);
+        node->left = node->right = nullptr;
+        if (wasMax) maxNode = rightmost();
+        return node;
+    }
+
+    // Number of levels, counted breadth-first
+    int height() {
+        int levels = 0;
+        vector<Course*> level, next;
+        if (root != NULL) level.push_back(root);
+        while (!level.empty()) {
+            levels++;
+            next.clear();
+            for (size_t i = 0; i < level.size(); i++) {
+                if (level[i]->left != NULL) next.push_back(level[i]->left);
+                if (level[i]->right != NULL) next.push_back(level[i]->right);
+            }
+            level.swap(next);
+        }
+        return levels;
+    }
+
+    void clear() {
+        destroyCourseTree(root);
+        root = maxNode = NULL;
     }
     
     Course* getRoot() { return root; }
     
     ~CourseBST() {
-        destroyCourseTree(root);
-        root = NULL;
+        clear();
     }
 };
 
-// Student BST
-class StudentBST {
-    private:
-        Student* root;
-        
-        Student* insertRec(Student* node, Student* newStudent) {
-            if (node == NULL) return newStudent;
-            
-            if (newStudent->matricNo < node->matricNo)
-                node->left = insertRec(node->left, newStudent);
-            else if (newStudent->matricNo > node->matricNo)
-                node->right = insertRec(node->right, newStudent);
-                
-            return node;
-        }
-        
-        Student* searchRec(Student* node, string matric) {
-            if (node == NULL || node->matricNo == matric)
-                return node;
-                
-            if (matric < node->matricNo)
-                return searchRec(node->left, matric);
-            return searchRec(node->right, matric);
+// Trie Node for course code prefixes (first-child / next-sibling, siblings kept sorted)
+struct CodeTrieNode {
+    char ch;
+    vector<Course*> courses; // codes ending here, which differ only in case, in code order
+    CodeTrieNode* child;
+    CodeTrieNode* sibling;
+
+    CodeTrieNode(char c) : ch(c), child(NULL), sibling(NULL) {}
+};
+
+string toUpperCopy(string s) {
+    for (size_t i = 0; i < s.size(); i++) s[i] = toupper((unsigned char)s[i]);
+    return s;
+}
+
+string toLowerCopy(string s) {
+    for (size_t i = 0; i < s.size(); i++) s[i] = tolower((unsigned char)s[i]);
+    return s;
+}
+
+// Search Index for courses
+// A trie over courseCode answers prefix queries; a trigram inverted index over
+// courseCode, courseName and lecturerName answers substring and typo-tolerant queries.
+class CourseSearchIndex {
+private:
+    struct Entry {
+        Course* course;
+        string text; // lower-cased "code|name|lecturer", fields separated by '\1'
+    };
+
+    CodeTrieNode* trieRoot;
+    vector<Entry> entries;
+    vector<int> freeEntries;
+    unordered_map<Course*, int> entryOf;
+    unordered_map<unsigned, vector<int> > postings;
+    vector<int> sharedCount; // scratch for fuzzy search, indexed by entry
+
+    static unsigned trigramKey(const string& s, int i) {
+        return ((unsigned char)s[i] << 16) | ((unsigned char)s[i + 1] << 8) | (unsigned char)s[i + 2];
+    }
+
+    static void collectTrigrams(const string& text, vector<unsigned>& keys) {
+        for (int i = 0; i + 3 <= (int)text.size(); i++) {
+            if (text[i] == '\1' || text[i + 1] == '\1' || text[i + 2] == '\1') continue;
+            keys.push_back(trigramKey(text, i));
         }
-        
-        void inorderRec(Student* node) {
-            if (node != NULL) {
-                inorderRec(node->left);
-                cout << node->name << " | " << node->matricNo << " | Year " 
-                    << node->year << " | " << node->program << " | " 
-                    << node->currentCredit << "/" << node->maxCredit << " credits\n";
-                inorderRec(node->right);
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    }
+
+    static void eraseFrom(vector<int>& list, int id) {
+        for (size_t i = 0; i < list.size(); i++) {
+            if (list[i] == id) {
+                list[i] = list.back();
+                list.pop_back();
+                return;
             }
         }
-        
-        Student* deleteRec(Student* node, string matric) {
-            if (!node) return nullptr;
-
-            if (matric < node->matricNo) {
-                node->left = deleteRec(node->left, matric);
-            }
-            else if (matric > node->matricNo) {
-                node->right = deleteRec(node->right, matric);
-            }
-            else {
-                // Case 1: no left child
-                if (!node->left) {
-                    Student* temp = node->right;
-                    node->left = node->right = nullptr;
-                    delete node;
-                    return temp;
-                }
-                // Case 2: no right child
-                else if (!node->right) {
-                    Student* temp = node->left;
-                    node->left = node->right = nullptr;
-                    delete node;
-                    return temp;
-                }
+    }
+
+    CodeTrieNode* findChild(CodeTrieNode* node, char c, bool create) {
+        CodeTrieNode* prev = NULL;
+        CodeTrieNode* cur = node->child;
+        while (cur != NULL && cur->ch < c) {
+            prev = cur;
+            cur = cur->sibling;
+        }
+        if (cur != NULL && cur->ch == c) return cur;
+        if (!create) return NULL;
+
+        CodeTrieNode* newNode = new CodeTrieNode(c);
+        newNode->sibling = cur;
+        if (prev == NULL) node->child = newNode;
+        else prev->sibling = newNode;
+        return newNode;
+    }
+
+    static void takeCourses(CodeTrieNode* node, vector<Course*>& out, int limit) {
+        for (size_t i = 0; i < node->courses.size() && out.size() < (size_t)limit; i++) out.push_back(node->courses[i]);
+    }
+
+    void collectPrefix(CodeTrieNode* node, vector<Course*>& out, int limit) {
+        // Explicit stack keeps the walk in code order without recursion
+        vector<CodeTrieNode*> stack;
+        takeCourses(node, out, limit);
+        if (node->child != NULL) stack.push_back(node->child);
+        while (!stack.empty() && out.size() < (size_t)limit) {
+            CodeTrieNode* cur = stack.back();
+            stack.pop_back();
+            if (cur->sibling != NULL) stack.push_back(cur->sibling);
+            takeCourses(cur, out, limit);
+            if (cur->child != NULL) stack.push_back(cur->child);
+        }
+    }
+
+    // Deletes node, a child of parent left with no courses and no children
+    static void unlinkChild(CodeTrieNode* parent, CodeTrieNode* node) {
+        CodeTrieNode** link = &parent->child;
+        while (*link != node) link = &(*link)->sibling;
+        *link = node->sibling;
+        delete node;
+    }
+
+    void destroyTrie(CodeTrieNode* node) {
+        vector<CodeTrieNode*> stack;
+        if (node != NULL) stack.push_back(node);
+        while (!stack.empty()) {
+            CodeTrieNode* cur = stack.back();
+            stack.pop_back();
+            if (cur->child != NULL) stack.push_back(cur->child);
+            if (cur->sibling != NULL) stack.push_back(cur->sibling);
+            delete cur;
+        }
+    }
 
-                // Case 3: two children
-                Student* successor = minValueNode(node->right);
-                node->name = successor->name;
-                node->matricNo = successor->matricNo;
-                node->maxCredit = successor->maxCredit;
-                node->currentCredit = successor->currentCredit;
-                node->year = successor->year;
-                node->program = successor->program;
-                node->courseList = successor->courseList;
-                node->notifications = successor->notifications;
-                successor->courseList = nullptr;
-                successor->notifications.clear();
-                node->right = deleteRec(node->right, successor->matricNo);
+    // Smallest edit distance between pattern and any substring of text, counting an
+    // adjacent transposition as one edit (Sellers' algorithm with the OSA extension)
+    static int substringDistance(const string& pattern, const string& text, int cutoff) {
+        int m = pattern.size();
+        vector<int> prev2(m + 1), prev(m + 1), col(m + 1);
+        for (int i = 0; i <= m; i++) prev[i] = i;
+        int best = prev[m];
+        for (size_t j = 0; j < text.size() && best > 0; j++) {
+            col[0] = 0;
+            for (int i = 1; i <= m; i++) {
+                int cost = (pattern[i - 1] == text[j]) ? 0 : 1;
+                col[i] = min(min(prev[i] + 1, col[i - 1] + 1), prev[i - 1] + cost);
+                if (i > 1 && j > 0 && pattern[i - 1] == text[j - 1] && pattern[i - 2] == text[j])
+                    col[i] = min(col[i], prev2[i - 2] + 1);
             }
-            return node;
+            if (col[m] < best) best = col[m];
+            prev2.swap(prev);
+            prev.swap(col);
         }
+        return best <= cutoff ? best : cutoff + 1;
+    }
 
-        
-        Student* minValueNode(Student* node) {
-            Student* current = node;
-            while (current && current->left != NULL)
-                current = current->left;
-            return current;
+    void sortByCode(vector<Course*>& list) {
+        sort(list.begin(), list.end(), [](Course* a, Course* b) { return a->details->courseCode < b->details->courseCode; });
+    }
+
+public:
+    CourseSearchIndex() : trieRoot(new CodeTrieNode('\0')) {}
+
+    void add(Course* course) {
+        CodeTrieNode* node = trieRoot;
+        string code = toUpperCopy(course->details->courseCode);
+        for (size_t i = 0; i < code.size(); i++) node = findChild(node, code[i], true);
+        vector<Course*>& here = node->courses;
+        vector<Course*>::iterator at = here.begin();
+        while (at != here.end() && (*at)->details->courseCode < course->details->courseCode) ++at;
+        here.insert(at, course);
+
+        int id;
+        if (!freeEntries.empty()) {
+            id = freeEntries.back();
+            freeEntries.pop_back();
+        } else {
+            id = entries.size();
+            entries.push_back(Entry());
+            sharedCount.push_back(0);
         }
+        entries[id].course = course;
+        entries[id].text = toLowerCopy(course->details->courseCode + '\1' + course->details->courseName + '\1' + course->details->lecturerName);
+        entryOf[course] = id;
 
-        void destroyStudentTree(Student* node) {
-        if (!node) return;
+        vector<unsigned> keys;
+        collectTrigrams(entries[id].text, keys);
+        for (size_t i = 0; i < keys.size(); i++) postings[keys[i]].push_back(id);
+    }
 
-        destroyStudentTree(node->left);
-        destroyStudentTree(node->right);
+    // Must be called before the course's strings change or the course is deleted
+    void remove(Course* course) {
+        unordered_map<Course*, int>::iterator found = entryOf.find(course);
+        if (found == entryOf.end()) return;
+        int id = found->second;
+        entryOf.erase(found);
 
-        CourseNode* cur = node->courseList;
-        while (cur) {
-            CourseNode* temp = cur;
-            cur = cur->next;
-            delete temp;
+        vector<CodeTrieNode*> path(1, trieRoot);
+        string code = toUpperCopy(course->details->courseCode);
+        for (size_t i = 0; i < code.size() && path.back() != NULL; i++) path.push_back(findChild(path.back(), code[i], false));
+        if (path.back() != NULL) {
+            vector<Course*>& here = path.back()->courses;
+            vector<Course*>::iterator it = find(here.begin(), here.end(), course);
+            if (it != here.end()) here.erase(it);
+            // Drop the nodes that no longer lead to any course
+            for (size_t i = path.size() - 1; i > 0 && path[i]->courses.empty() && path[i]->child == NULL; i--) {
+                unlinkChild(path[i - 1], path[i]);
+            }
         }
 
-        node->notifications.clear();
+        vector<unsigned> keys;
+        collectTrigrams(entries[id].text, keys);
+        for (size_t i = 0; i < keys.size(); i++) {
+            unordered_map<unsigned, vector<int> >::iterator it = postings.find(keys[i]);
+            if (it == postings.end()) continue;
+            eraseFrom(it->second, id);
+            if (it->second.empty()) postings.erase(it);
+        }
+        entries[id].course = NULL;
+        entries[id].text.clear();
+        freeEntries.push_back(id);
+    }
 
-        delete node;
+    // Courses whose code starts with prefix, in code order
+    vector<Course*> searchPrefix(string prefix, int limit) {
+        vector<Course*> out;
+        CodeTrieNode* node = trieRoot;
+        prefix = toUpperCopy(prefix);
+        for (size_t i = 0; i < prefix.size() && node != NULL; i++) node = findChild(node, prefix[i], false);
+        if (node != NULL) collectPrefix(node, out, limit);
+        return out;
     }
-        
-    public:
-        StudentBST() : root(NULL) {}
-        
-        void insert(Student* newStudent) {
-            root = insertRec(root, newStudent);
+
+    // Courses whose code, name or lecturer contains query (case-insensitive), in code order
+    vector<Course*> searchSubstring(string query, int limit) {
+        vector<Course*> out;
+        string q = toLowerCopy(query);
+        if (q.empty()) return out;
+
+        if (q.size() < 3) {
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (entries[i].course != NULL && entries[i].text.find(q) != string::npos) out.push_back(entries[i].course);
+            }
+        } else {
+            // Verify candidates from the rarest trigram of the query
+            vector<int>* rarest = NULL;
+            for (int i = 0; i + 3 <= (int)q.size(); i++) {
+                unordered_map<unsigned, vector<int> >::iterator it = postings.find(trigramKey(q, i));
+                if (it == postings.end()) return out;
+                if (rarest == NULL || it->second.size() < rarest->size()) rarest = &it->second;
+            }
+            for (size_t i = 0; i < rarest->size(); i++) {
+                Entry& e = entries[(*rarest)[i]];
+                if (e.text.find(q) != string::npos) out.push_back(e.course);
+            }
         }
-        
-        Student* search(string matric) {
-            return searchRec(root, matric);
+        sortByCode(out);
+        if (out.size() > (size_t)limit) out.resize(limit);
+        return out;
+    }
+
+    // Courses with a field within a small edit distance of query, closest first
+    vector<Course*> searchFuzzy(string query, int limit) {
+        vector<Course*> out;
+        string q = toLowerCopy(query);
+        if (q.size() < 3) return out;
+
+        int maxTypos = q.size() <= 7 ? 1 : 2;
+        int trigrams = q.size() - 2;
+        int minShared = trigrams - 3 * maxTypos;
+        if (minShared < 1) minShared = 1;
+
+        // q-gram filter: a close match must share enough trigrams with the query
+        vector<int> touched;
+        for (int i = 0; i < trigrams; i++) {
+            unordered_map<unsigned, vector<int> >::iterator it = postings.find(trigramKey(q, i));
+            if (it == postings.end()) continue;
+            for (size_t k = 0; k < it->second.size(); k++) {
+                int id = it->second[k];
+                if (sharedCount[id]++ == 0) touched.push_back(id);
+            }
         }
-        
-        void displayAll() {
-            if (root == NULL) {
-                cout << "No students in system.\n";
-                return;
+
+        // Verify the candidates sharing the most trigrams first, up to a fixed budget
+        vector<vector<int> > buckets(trigrams + 1);
+        for (size_t i = 0; i < touched.size(); i++) {
+            int id = touched[i];
+            if (sharedCount[id] >= minShared) buckets[sharedCount[id]].push_back(id);
+            sharedCount[id] = 0;
+        }
+
+        const int maxCandidates = 256;
+        int checked = 0;
+        vector<pair<int, Course*> > ranked;
+        for (int b = trigrams; b >= minShared && checked < maxCandidates; b--) {
+            for (size_t i = 0; i < buckets[b].size() && checked < maxCandidates; i++, checked++) {
+                int id = buckets[b][i];
+                int d = substringDistance(q, entries[id].text, maxTypos);
+                if (d <= maxTypos) ranked.push_back(make_pair(d, entries[id].course));
             }
-            cout << "\n=== All Students ===\n";
-            inorderRec(root);
         }
-        
-        Student* getRoot() { return root; }
+        sort(ranked.begin(), ranked.end(), [](const pair<int, Course*>& a, const pair<int, Course*>& b) {
+            if (a.first != b.first) return a.first < b.first;
+            return a.second->details->courseCode < b.second->details->courseCode;
+        });
+        for (size_t i = 0; i < ranked.size() && i < (size_t)limit; i++) out.push_back(ranked[i].second);
+        return out;
+    }
 
-        ~StudentBST() {
-            destroyStudentTree(root);
-            root = NULL;
+    int size() { return entryOf.size(); }
+
+    void clear() {
+        destroyTrie(trieRoot);
+        trieRoot = new CodeTrieNode('\0');
+        entries.clear();
+        freeEntries.clear();
+        entryOf.clear();
+        postings.clear();
+        sharedCount.clear();
+    }
+
+    ~CourseSearchIndex() {
+        destroyTrie(trieRoot);
+    }
+};
+
+// Course Catalog
+// Read-mostly copy of the course details that any thread can read without taking a lock.
+// A writer builds a new immutable snapshot and swaps it in atomically. A reader pins the current
+// epoch while it holds a snapshot, and a replaced snapshot is freed once no reader is pinned at an
+// epoch from before the swap. Entries of unchanged courses are shared between snapshots, and seat
+// counts are not copied at all: every entry reads the live atomic counter.
+struct CatalogEntry {
+    string courseCode;
+    string courseName;
+    string lecturerName;
+    int credit;
+    int capacity;
+    const atomic<int>* seats; // the course's currentCapacity
+
+    int seatsTaken() const { return seats->load(memory_order_relaxed); }
+};
+
+struct CatalogSnapshot {
+    vector<const CatalogEntry*> entries; // in course code order
+    vector<PackedKey> keys;              // entries[i]'s code packed, searched without touching the entries
+    vector<const CatalogEntry*> dropped; // entries the next snapshot no longer shares, freed with this one
+    vector<Course*> removed;             // deleted courses still referenced here, freed with this one
+    long long version;
+    long long retiredAt;          // epoch at which a newer snapshot replaced this one
+
+    // Index of the first entry whose code is >= code
+    size_t lowerBound(const string& code) const {
+        return lowerBound(PackedKey(code), code, 0, entries.size());
+    }
+
+    size_t lowerBound(const PackedKey& key, const string& code, size_t lo, size_t hi) const {
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (compareKeys(keys[mid], entries[mid]->courseCode, key, code) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Binary search on the packed keys down to a short run, then one vector scan of the run
+    const CatalogEntry* find(const string& code) const {
+        PackedKey key(code);
+        size_t lo = 0, hi = entries.size();
+        if (key.truncated()) {
+            lo = lowerBound(key, code, lo, hi); // long codes need the string tie-break
+        } else {
+            while (hi - lo > 16) {
+                size_t mid = (lo + hi) / 2;
+                if (keys[mid].hi < key.hi || (keys[mid].hi == key.hi && keys[mid].lo < key.lo)) lo = mid + 1;
+                else hi = mid;
+            }
+            lo += scanPackedKeys(&keys[lo], hi - lo, key);
         }
+        return lo < entries.size() && entries[lo]->courseCode == code ? entries[lo] : NULL;
+    }
 };
 
-// Staff structure
-struct Staff {
-    string name;
-    string staffID;
+const int CATALOG_READER_SLOTS = 128;
+
+struct alignas(64) CatalogReaderSlot {
+    atomic<long long> epoch; // pinned epoch, 0 while not reading
+    atomic<bool> taken;      // owned by a thread
 };
 
-// Global variables
-StudentBST studentTree;
-CourseBST courseTree;
-vector<Staff> staffList;
-RegistrationQueue regQueue;
+class CourseCatalog {
+private:
+    atomic<CatalogSnapshot*> current;
+    atomic<long long> epoch;
+    CatalogReaderSlot slots[CATALOG_READER_SLOTS];
+    mutex writerLock; // writers are rare and simply take turns
+    vector<CatalogSnapshot*> retired;
 
-// Function prototypes
-void loadStudents();
-void loadCourses();
-void loadStaff();
-void loadPendingRequests();
-void saveStudents();
-void saveCourses();
-void savePendingRequests();
-void saveAllData();
-void saveStudentRec(Student* node, ofstream& file);
-void saveCourseRec(Course* node, ofstream& file);
-void studentMenu(Student* student);
-void staffMenu(Staff* staff);
-void viewAllCourses();
-void searchCourse();
-void registerCourse(Student* student);
-void viewRegisteredCourses(Student* student);
-void deleteCourse(Student* student);
-void viewNotifications(Student* student);
-void viewRegistrationSlip(Student* student);
-void viewStudentsInCourse(Student* student);
-void staffViewRequests();
-void staffViewAllStudents();
-void staffSearchStudent();
-void staffInsertStudent();
-void staffUpdateCourse();
-void staffInsertCourse();
-void staffDeleteCourse();
-void staffViewStudentListInCourse();
-void staffViewAllCourses();
-void staffRetractCourse();
-void staffInsertCourseForStudent();
-void insertStudentInCourseList(Course* course, string matric, string name);
-void removeStudentFromCourseList(Course* course, string matric);
-void markRequestAsCancelled(string matric, string courseCode);
-void addCourseToStudent(Student* student, string courseCode, string status);
-void removeCourseFromStudent(Student* student, string courseCode);
-CourseNode* findCourseInStudent(Student* student, string courseCode);
-int countStudentCourses(Student* student);
-string getCurrentTimestamp(time_t t = 0);
-void easterEgg();
+    // Frees every retired snapshot no reader can still hold. Called with writerLock held.
+    void reclaim() {
+        long long oldest = LLONG_MAX;
+        for (int i = 0; i < CATALOG_READER_SLOTS; i++) {
+            long long pinned = slots[i].epoch.load();
+            if (pinned != 0 && pinned < oldest) oldest = pinned;
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); i++) {
+            if (retired[i]->retiredAt <= oldest) freeSnapshot(retired[i]);
+            else retired[kept++] = retired[i];
+        }
+        retired.resize(kept);
+    }
 
-void addCourseToStudent(Student* student, string courseCode, string status) {
-    CourseNode* newNode = new CourseNode(courseCode, status);
-    newNode->next = student->courseList;
-    student->courseList = newNode;
-}
+    static void freeSnapshot(CatalogSnapshot* snapshot) {
+        for (size_t i = 0; i < snapshot->dropped.size(); i++) delete snapshot->dropped[i];
+        for (size_t i = 0; i < snapshot->removed.size(); i++) delete snapshot->removed[i];
+        delete snapshot;
+    }
 
-void removeCourseFromStudent(Student* student, string courseCode) {
-    if (student->courseList == NULL) return;
-    
-    if (student->courseList->courseCode == courseCode) {
-        CourseNode* temp = student->courseList;
-        student->courseList = student->courseList->next;
-        delete temp;
-        return;
+    static CatalogEntry* newEntry(Course* course) {
+        CatalogEntry* entry = new CatalogEntry();
+        entry->courseCode = course->details->courseCode;
+        entry->courseName = course->details->courseName;
+        entry->lecturerName = course->details->lecturerName;
+        entry->credit = course->credit;
+        entry->capacity = course->capacity;
+        entry->seats = &course->currentCapacity;
+        return entry;
     }
-    
-    CourseNode* current = student->courseList;
-    while (current->next != NULL && current->next->courseCode != courseCode) {
-        current = current->next;
+
+    // Makes next current and retires previous. Called with writerLock held.
+    void swapIn(CatalogSnapshot* previous, CatalogSnapshot* next) {
+        next->version = previous->version + 1;
+        current.store(next);
+        previous->retiredAt = epoch.fetch_add(1) + 1;
+        retired.push_back(previous);
+        reclaim();
     }
-    
-    if (current->next != NULL) {
-        CourseNode* temp = current->next;
-        current->next = current->next->next;
-        delete temp;
+
+public:
+    CourseCatalog() : current(new CatalogSnapshot()), epoch(1) {
+        current.load()->version = 0;
+        for (int i = 0; i < CATALOG_READER_SLOTS; i++) {
+            slots[i].epoch.store(0);
+            slots[i].taken.store(false);
+        }
     }
-}
 
-CourseNode* findCourseInStudent(Student* student, string courseCode) {
-    CourseNode* current = student->courseList;
-    while (current != NULL) {
-        if (current->courseCode == courseCode) {
-            return current;
+    ~CourseCatalog() {
+        for (size_t i = 0; i < retired.size(); i++) freeSnapshot(retired[i]);
+        CatalogSnapshot* last = current.load();
+        last->dropped.insert(last->dropped.end(), last->entries.begin(), last->entries.end());
+        freeSnapshot(last);
+    }
+
+    // Claims a reader slot for the calling thread, waiting if every slot is in use
+    CatalogReaderSlot* acquireSlot() {
+        while (true) {
+            for (int i = 0; i < CATALOG_READER_SLOTS; i++) {
+                bool expected = false;
+                if (!slots[i].taken.load(memory_order_relaxed) && slots[i].taken.compare_exchange_strong(expected, true)) {
+                    return &slots[i];
+                }
+            }
+            this_thread::yield();
         }
-        current = current->next;
     }
-    return NULL;
-}
 
-int countStudentCourses(Student* student) {
-    int count = 0;
-    CourseNode* current = student->courseList;
-    while (current != NULL) {
-        count++;
-        current = current->next;
+    void releaseSlot(CatalogReaderSlot* slot) {
+        slot->epoch.store(0);
+        slot->taken.store(false, memory_order_release);
     }
-    return count;
-}
 
-int main() {
-    loadStudents();
-    loadCourses();
-    loadStaff();
-    loadPendingRequests();
-    
-    while (true) {
-        cout << "\n========================================\n";
-        cout << "   COURSE REGISTRATION SYSTEM\n";
-        cout << "========================================\n";
-        cout << "1. Student\n";
-        cout << "2. Staff\n";
-        cout << "3. Exit\n";
-        cout << "Select role: ";
-        
-        int choice;
-        cin >> choice;
-        cin.ignore();
-        easterEgg();
-        if (choice == 1) {
-            cout << "Enter Matric No: ";
-            string matric;
-            getline(cin, matric);
-            
-            Student* student = studentTree.search(matric);
-            if (student == NULL) {
-                cout << "You are not eligible for course registration.\n";
-            } else {
-                studentMenu(student);
-            }
-        } else if (choice == 2) {
-            cout << "Enter Staff ID: ";
-            string staffID;
-            getline(cin, staffID);
-            
-            Staff* foundStaff = NULL;
-            for (int i = 0; i < staffList.size(); i++) {
-                if (staffList[i].staffID == staffID) {
-                    foundStaff = &staffList[i];
-                    break;
-                }
-            }
-            
-            if (foundStaff == NULL) {
-                cout << "Prohibited access.\n";
-            } else {
-                cout << "Welcome " << foundStaff->name << "!\n";
-                staffMenu(foundStaff);
+    // The epoch is published before the snapshot is loaded, so a writer that swaps the snapshot
+    // afterwards sees this reader and keeps the old one alive
+    const CatalogSnapshot* pin(CatalogReaderSlot* slot) {
+        slot->epoch.store(epoch.load());
+        return current.load();
+    }
+
+    // Only valid while the caller already has an epoch pinned
+    const CatalogSnapshot* latest() {
+        return current.load();
+    }
+
+    void unpin(CatalogReaderSlot* slot) {
+        slot->epoch.store(0, memory_order_release);
+    }
+
+    // Replaces the whole snapshot with the current contents of the course tree
+    void publish(CourseBST& tree) {
+        lock_guard<mutex> guard(writerLock);
+        CatalogSnapshot* previous = current.load();
+        CatalogSnapshot* next = new CatalogSnapshot();
+        for (TreeCursor<Course> cursor(tree.getRoot()); cursor.hasNext();) {
+            Course* course = cursor.next();
+            next->entries.push_back(newEntry(course));
+            next->keys.push_back(course->codeKey);
+        }
+        previous->dropped.insert(previous->dropped.end(), previous->entries.begin(), previous->entries.end());
+        swapIn(previous, next);
+    }
+
+    // Republishes one course after it was inserted or edited, or after it was detached from the
+    // tree (course NULL, the detached course passed as removedCourse to be freed once unseen).
+    // Every other entry is shared with the previous snapshot.
+    void publishCourse(const string& code, Course* course, Course* removedCourse = NULL) {
+        lock_guard<mutex> guard(writerLock);
+        CatalogSnapshot* previous = current.load();
+        CatalogSnapshot* next = new CatalogSnapshot();
+        next->entries = previous->entries;
+        next->keys = previous->keys;
+        size_t i = previous->lowerBound(code);
+        bool exists = i < previous->entries.size() && previous->entries[i]->courseCode == code;
+        if (exists) previous->dropped.push_back(previous->entries[i]);
+        if (course == NULL) {
+            if (exists) {
+                next->entries.erase(next->entries.begin() + i);
+                next->keys.erase(next->keys.begin() + i);
             }
-        } else if (choice == 3) {
-            saveAllData();
-            cout << "Thank you for using the system!\n";
-            break;
+        } else if (exists) {
+            next->entries[i] = newEntry(course);
         } else {
-            cout << "Invalid choice.\n";
+            next->entries.insert(next->entries.begin() + i, newEntry(course));
+            next->keys.insert(next->keys.begin() + i, course->codeKey);
         }
+        if (removedCourse != NULL) previous->removed.push_back(removedCourse);
+        swapIn(previous, next);
     }
-    
-    return 0;
-}
 
-void loadStudents() {
-    ifstream file("students.txt");
-    if (!file) {
-        cout << "Students file not found. Starting with empty student list.\n";
-        return;
+    long long getVersion() {
+        return current.load()->version;
     }
-    
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue;
-        int pos = 0;
-        int tabPos = line.find('\t');
-        
-        string studentName;
-        studentName = line.substr(pos, tabPos - pos);
-        pos = tabPos + 1;
-        
-        string matricNo;
-        tabPos = line.find('\t', pos);
-        matricNo = line.substr(pos, tabPos - pos);
-        pos = tabPos + 1;
-        
-        int maxCredit;
-        tabPos = line.find('\t', pos);
-        maxCredit = atoi(line.substr(pos, tabPos - pos).c_str());
-        pos = tabPos + 1;
-        
-        int currentCredit;
-        tabPos = line.find('\t', pos);
-        currentCredit = atoi(line.substr(pos, tabPos - pos).c_str());
-        pos = tabPos + 1;
+
+    // Snapshots replaced but not yet freed
+    size_t retiredCount() {
+        lock_guard<mutex> guard(writerLock);
+        reclaim();
+        return retired.size();
+    }
+};
+
+CourseCatalog courseCatalog;
+
+// Each thread keeps its reader slot until it exits
+struct CatalogThreadSlot {
+    CatalogReaderSlot* slot;
+    int depth; // nested CatalogRead guards pin only once
+
+    CatalogThreadSlot() : slot(NULL), depth(0) {}
+    ~CatalogThreadSlot() {
+        if (slot != NULL) courseCatalog.releaseSlot(slot);
+    }
+};
+
+thread_local CatalogThreadSlot catalogThreadSlot;
+
+// Pins the current catalog snapshot for as long as the guard lives
+class CatalogRead {
+private:
+    const CatalogSnapshot* snapshot;
+
+public:
+    CatalogRead() {
+        CatalogThreadSlot& mine = catalogThreadSlot;
+        if (mine.slot == NULL) mine.slot = courseCatalog.acquireSlot();
+        // An inner guard keeps the outer pin: moving the epoch forward would expose the outer snapshot
+        snapshot = mine.depth++ == 0 ? courseCatalog.pin(mine.slot) : courseCatalog.latest();
+    }
+    ~CatalogRead() {
+        if (--catalogThreadSlot.depth == 0) courseCatalog.unpin(catalogThreadSlot.slot);
+    }
+
+    const CatalogSnapshot* operator->() const { return snapshot; }
+    const CatalogSnapshot& operator*() const { return *snapshot; }
+};
+
+// Student BST
+// All walks are iterative, so even a degenerate (sorted-insert) tree cannot overflow the call stack.
+// With --lazy-students the tree holds only the records paged in so far; search asks the pager for the rest
+bool lazyStudents = false;
+Student* lazyStudentLookup(const string& matric, Student* resident);
+
+class StudentBST {
+    private:
+        Student* root;
+        Student* maxNode; // rightmost node, for O(1) appends of increasing matric numbers
         
-        int year;
-        tabPos = line.find('\t', pos);
-        year = atoi(line.substr(pos, tabPos - pos).c_str());
-        pos = tabPos + 1;
+        // Returns the link (root, or a parent's left/right) that points at matric's node, or at NULL where it would go
+        Student** findLink(const string& matric) {
+            PackedKey key(matric);
+            Student** link = &root;
+            int order;
+            while (*link != NULL && (order = compareKeys(key, matric, (*link)->matricKey, (*link)->profile->matricNo)) != 0) {
+                link = order < 0 ? &(*link)->left : &(*link)->right;
+            }
+            return link;
+        }
+
+        Student* rightmost() {
+            Student* current = root;
+            while (current != NULL && current->right != NULL)
+                current = current->right;
+            return current;
+        }
+
+        // Flattens left subtrees into the right spine with rotations while freeing nodes: O(n) time, O(1) space
+        void destroyStudentTree(Student* node) {
+            while (node != NULL) {
+                if (node->left != NULL) {
+                    Student* left = node->left;
+                    node->left = left->right;
+                    left->right = node;
+                    node = left;
+                    continue;
+                }
+
+                Student* next = node->right;
+                CourseNode* cur = node->courseList;
+                while (cur) {
+                    CourseNode* temp = cur;
+                    cur = cur->next;
+                    delete temp;
+                }
+                node->profile->notifications.clear();
+                delete node;
+                node = next;
+            }
+        }
         
-        string program;
-        tabPos = line.find('\t', pos);
-        program = line.substr(pos, tabPos - pos);
-        pos = tabPos + 1;
-        Student* newStudent = new Student(studentName, matricNo, maxCredit, currentCredit, year, program);
-        // Number of courses
-        int numCourses = atoi(line.substr(pos).c_str());
+    public:
+        StudentBST() : root(NULL), maxNode(NULL) {}
         
-        // Read registered courses from following lines
-        for (int i = 0; i < numCourses; i++) {
-            if (getline(file, line)) {
-                // Parse: CourseCode\tStatus
-                tabPos = line.find('\t');
-                if (tabPos != string::npos) {
-                    string courseCode = line.substr(0, tabPos);
-                    string status = line.substr(tabPos + 1);
-                    addCourseToStudent(newStudent, courseCode, status);
+        void insert(Student* newStudent) {
+            newStudent->left = newStudent->right = NULL;
+            // Matric numbers arriving in increasing order attach straight under the rightmost node
+            if (maxNode != NULL && compareKeys(newStudent->matricKey, newStudent->profile->matricNo, maxNode->matricKey, maxNode->profile->matricNo) > 0) {
+                maxNode->right = newStudent;
+                maxNode = newStudent;
+                return;
+            }
+            Student** link = findLink(newStudent->profile->matricNo);
+            if (*link != NULL) return;
+            *link = newStudent;
+            if (maxNode == NULL) maxNode = newStudent;
+        }
+
+        // Builds a height-balanced tree from students sorted by matric no. The tree must be empty.
+        void buildBalanced(vector<Student*>& nodes) {
+            struct Range { int lo; int hi; Student** link; };
+            vector<Range> stack;
+            Range first = { 0, (int)nodes.size() - 1, &root };
+            stack.push_back(first);
+            while (!stack.empty()) {
+                Range r = stack.back();
+                stack.pop_back();
+                if (r.lo > r.hi) {
+                    *r.link = NULL;
+                    continue;
                 }
+                int mid = r.lo + (r.hi - r.lo) / 2;
+                Student* node = nodes[mid];
+                *r.link = node;
+                Range left = { r.lo, mid - 1, &node->left };
+                Range right = { mid + 1, r.hi, &node->right };
+                stack.push_back(left);
+                stack.push_back(right);
             }
+            maxNode = nodes.empty() ? NULL : nodes.back();
         }
         
-        studentTree.insert(newStudent);
-    }
-    
-    file.close();
-    cout << "Students loaded successfully.\n";
-}
+        Student* search(string matric) {
+            STAT_SCOPE(OP_STUDENT_SEARCH);
+            Student* found = *findLink(matric);
+            return lazyStudents ? lazyStudentLookup(matric, found) : found;
+        }
 
-void loadCourses() {
-    ifstream file("courses.txt");
-    if (!file) {
-        cout << "Courses file not found. Starting with empty course list.\n";
-        return;
-    }
-    
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue;
-        
-        string courseCode, courseName, lecturerName;
-        int credit, capacity, currentCapacity;
-        
-        int pos = 0;
-        int tabPos = line.find('\t');
-        
-        // CourseCode
-        courseCode = line.substr(pos, tabPos - pos);
-        pos = tabPos + 1;
-        
-        // CourseName
-        tabPos = line.find('\t', pos);
-        courseName = line.substr(pos, tabPos - pos);
-        pos = tabPos + 1;
-        
-        // LecturerName
-        tabPos = line.find('\t', pos);
-        lecturerName = line.substr(pos, tabPos - pos);
-        pos = tabPos + 1;
-        
-        // Credit
-        tabPos = line.find('\t', pos);
-        credit = atoi(line.substr(pos, tabPos - pos).c_str());
-        pos = tabPos + 1;
-        
-        // Capacity
-        tabPos = line.find('\t', pos);
-        capacity = atoi(line.substr(pos, tabPos - pos).c_str());
-        pos = tabPos + 1;
-        
-        // CurrentCapacity
-        tabPos = line.find('\t', pos);
-        currentCapacity = atoi(line.substr(pos, tabPos - pos).c_str());
-        pos = tabPos + 1;
-        // Number of students
-        int numStudents = atoi(line.substr(pos).c_str());
-        Course* newCourse = new Course(courseCode, courseName, lecturerName, credit, capacity, currentCapacity);
-        
-        // Read students from following lines
-        for (int i = 0; i < numStudents; i++) {
-            if (getline(file, line)) {
-                // Parse: MatricNo\tName
-                tabPos = line.find('\t');
-                if (tabPos != string::npos) {
-                    string matric = line.substr(0, tabPos);
-                    string name = line.substr(tabPos + 1);
-                    insertStudentInCourseList(newCourse, matric, name);
+        void deleteStudent(string matric) {
+            Student** link = findLink(matric);
+            Student* node = *link;
+            if (node == NULL) return;
+
+            if (node->left == NULL) {
+                *link = node->right;
+            } else if (node->right == NULL) {
+                *link = node->left;
+            } else {
+                // Splice the successor node into this position so Student pointers stay valid
+                Student* parent = node;
+                Student* successor = node->right;
+                while (successor->left != NULL) {
+                    parent = successor;
+                    successor = successor->left;
                 }
+                if (parent != node) {
+                    parent->left = successor->right;
+                    successor->right = node->right;
+                }
+                successor->left = node->left;
+                *link = successor;
             }
+
+            bool wasMax = (node == maxNode);
+            node->left = node->right = nullptr;
+            delete node;
+            if (wasMax) maxNode = rightmost();
         }
         
-        courseTree.insert(newCourse);
-    }
-    
-    file.close();
-    cout << "Courses loaded successfully.\n";
-}
+        // Prints up to pageSize students starting at the first matric no >= fromKey.
+        // Returns the matric no to resume from, or "" when the listing is complete.
+        string displayPage(const string& fromKey, int pageSize) {
+            OutputBuffer out(cout);
+            TreeCursor<Student> cursor(root, fromKey);
+            for (int i = 0; i < pageSize && cursor.hasNext(); i++) {
+                Student* node = cursor.next();
+                out << node->profile->name << " | " << node->profile->matricNo << " | Year "
+                    << node->profile->year << " | " << node->profile->program << " | "
+                    << node->currentCredit << "/" << node->maxCredit << " credits\n";
+            }
+            return cursor.hasNext() ? cursor.next()->profile->matricNo : "";
+        }
 
-void loadStaff() {
-    ifstream file("staff.txt");
-    if (!file) {
-        cout << "Staff file not found.\n";
-        return;
-    }
-    
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue;
-        
-        Staff newStaff;
-        
-        // Parse tab-separated values
-        int tabPos = line.find('\t');
-        newStaff.name = line.substr(0, tabPos);
-        newStaff.staffID = line.substr(tabPos + 1);
+        // Number of levels, counted breadth-first
+        int height() {
+            int levels = 0;
+            vector<Student*> level, next;
+            if (root != NULL) level.push_back(root);
+            while (!level.empty()) {
+                levels++;
+                next.clear();
+                for (size_t i = 0; i < level.size(); i++) {
+                    if (level[i]->left != NULL) next.push_back(level[i]->left);
+                    if (level[i]->right != NULL) next.push_back(level[i]->right);
+                }
+                level.swap(next);
+            }
+            return levels;
+        }
+
+        void clear() {
+            destroyStudentTree(root);
+            root = maxNode = NULL;
+        }
         
-        staffList.push_back(newStaff);
-    }
-    
-    file.close();
-    cout << "Staff loaded successfully.\n";
-}
+        Student* getRoot() { return root; }
 
-void loadPendingRequests() {
-    ifstream file("pending_requests.txt");
-    if (!file) return;
+        ~StudentBST() {
+            clear();
+        }
+};
 
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue;
-
-        string matric, sName, cCode, cName;
-        int credit;
-        time_t timestamp;
-
-        int pos = 0, tab;
-        tab = line.find('\t');
-        matric = line.substr(pos, tab - pos);
-        pos = tab + 1;
-        tab = line.find('\t', pos);
-        sName = line.substr(pos, tab - pos);
-        pos = tab + 1;
-        tab = line.find('\t', pos);
-        cCode = line.substr(pos, tab - pos);
-        pos = tab + 1;
-        tab = line.find('\t', pos);
-        cName = line.substr(pos, tab - pos);
-        pos = tab + 1;
-        tab = line.find('\t', pos);
-        credit = atoi(line.substr(pos, tab - pos).c_str());
-        pos = tab + 1;
-        timestamp = atol(line.substr(pos).c_str());
-        regQueue.enqueue(matric, sName, cCode, cName, credit);
-        regQueue.getRear()->timestamp = timestamp;
+// Filter for student index queries; empty program or zero bounds mean "any"
+struct StudentFilter {
+    string program;
+    int minYear;
+    int maxYear;
+    int minHeadroom;
+
+    StudentFilter() : program(""), minYear(0), maxYear(0), minHeadroom(0) {}
+};
+
+// Secondary Indexes for students
+// Students are bucketed by program and year (each bucket in matric order) and by remaining
+// credit headroom (maxCredit - currentCredit) in intrusive lists, so a credit change moves
+// a student between headroom buckets in O(1).
+class StudentIndex {
+private:
+    static const int MAX_HEADROOM = 40;
+
+    map<string, map<int, vector<Student*> > > byProgramYear;
+    Student* headroomHead[MAX_HEADROOM + 1];
+    int headroomCount[MAX_HEADROOM + 1];
+
+    static int bucketOf(Student* student) {
+        int headroom = student->maxCredit - student->currentCredit;
+        if (headroom < 0) return 0;
+        if (headroom > MAX_HEADROOM) return MAX_HEADROOM;
+        return headroom;
     }
 
-    file.close();
-}
+    static bool byMatric(Student* a, Student* b) {
+        return a->profile->matricNo < b->profile->matricNo;
+    }
 
-void saveStudentRec(Student* node, ofstream& file) {
-    if (node == NULL) return;
-    
-    saveStudentRec(node->left, file);
-    
-    file << node->name << "\t";
-    file << node->matricNo << "\t";
-    file << node->maxCredit << "\t";
-    file << node->currentCredit << "\t";
-    file << node->year << "\t";
-    file << node->program << "\t";
-    file << countStudentCourses(node);
-    
-    CourseNode* current = node->courseList;
-    while (current != NULL) {
-        file << "\n" << current->courseCode << "\t" << current->status;
-        current = current->next;
+    bool matches(Student* s, const StudentFilter& f) {
+        if (!f.program.empty() && s->profile->program != f.program) return false;
+        if (f.minYear > 0 && s->profile->year < f.minYear) return false;
+        if (f.maxYear > 0 && s->profile->year > f.maxYear) return false;
+        if (s->maxCredit - s->currentCredit < f.minHeadroom) return false;
+        return true;
     }
-    file << "\n";
-    
-    saveStudentRec(node->right, file);
-}
 
-void saveCourseRec(Course* node, ofstream& file) {
-    if (node == NULL) return;
-    
-    saveCourseRec(node->left, file);
-    
-    // Count students in list
-    int count = 0;
-    StudentNode* temp = node->studentList;
-    while (temp != NULL) {
-        count++;
-        temp = temp->next;
+    // Collects the (program, year) buckets a filter can touch. Returns their total size.
+    int programYearBuckets(const StudentFilter& f, vector<vector<Student*>*>& buckets) {
+        int total = 0;
+        map<string, map<int, vector<Student*> > >::iterator p = f.program.empty() ? byProgramYear.begin() : byProgramYear.find(f.program);
+        for (; p != byProgramYear.end(); ++p) {
+            map<int, vector<Student*> >::iterator y = f.minYear > 0 ? p->second.lower_bound(f.minYear) : p->second.begin();
+            for (; y != p->second.end() && (f.maxYear <= 0 || y->first <= f.maxYear); ++y) {
+                buckets.push_back(&y->second);
+                total += y->second.size();
+            }
+            if (!f.program.empty()) break;
+        }
+        return total;
     }
-    
-    file << node->courseCode << "\t";
-    file << node->courseName << "\t";
-    file << node->lecturerName << "\t";
-    file << node->credit << "\t";
-    file << node->capacity << "\t";
-    file << node->currentCapacity << "\t";
-    file << count;
-    
-    // Write student list
-    temp = node->studentList;
-    while (temp != NULL) {
-        file << "\n" << temp->matricNo << "\t" << temp->name;
-        temp = temp->next;
+
+public:
+    StudentIndex() {
+        for (int i = 0; i <= MAX_HEADROOM; i++) {
+            headroomHead[i] = NULL;
+            headroomCount[i] = 0;
+        }
     }
-    file << "\n";
-    
-    saveCourseRec(node->right, file);
-}
 
-void saveStudents() {
-    ofstream file("students.txt");
-    if (!file) {
-        cout << "Error saving students.\n";
-        return;
+    void add(Student* student) {
+        vector<Student*>& bucket = byProgramYear[student->profile->program][student->profile->year];
+        bucket.insert(lower_bound(bucket.begin(), bucket.end(), student, byMatric), student);
+        linkHeadroom(student);
     }
-    
-    Student* root = studentTree.getRoot();
-    saveStudentRec(root, file);
-    file.close();
-}
 
-void saveCourses() {
-    ofstream file("courses.txt");
-    if (!file) {
-        cout << "Error saving courses.\n";
-        return;
+    void remove(Student* student) {
+        vector<Student*>& bucket = byProgramYear[student->profile->program][student->profile->year];
+        vector<Student*>::iterator it = lower_bound(bucket.begin(), bucket.end(), student, byMatric);
+        if (it != bucket.end() && *it == student) bucket.erase(it);
+        unlinkHeadroom(student);
     }
-    
-    Course* root = courseTree.getRoot();
-    saveCourseRec(root, file);
-    file.close();
-}
 
-void savePendingRequests() {
-    ofstream file("pending_requests.txt");
-    if (!file) {
-        cout << "Error saving pending requests.\n";
-        return;
+    // Headroom bucket maintenance; use adjustStudentCredit rather than calling these directly
+    void linkHeadroom(Student* student) {
+        int b = bucketOf(student);
+        student->profile->headroomPrev = NULL;
+        student->profile->headroomNext = headroomHead[b];
+        if (headroomHead[b] != NULL) headroomHead[b]->profile->headroomPrev = student;
+        headroomHead[b] = student;
+        headroomCount[b]++;
     }
-    
-    RegistrationRequest* temp = regQueue.getFront();
-    while (temp != NULL) {
-        if (!temp->isCancelled) {
-            file << temp->matricNo << "\t";
-            file << temp->studentName << "\t";
-            file << temp->courseCode << "\t";
-            file << temp->courseName << "\t";
-            file << temp->credit << "\t";
-            file << temp->timestamp << "\n";
-        }
-        temp = temp->next;
+
+    void unlinkHeadroom(Student* student) {
+        int b = bucketOf(student);
+        if (student->profile->headroomPrev != NULL) student->profile->headroomPrev->profile->headroomNext = student->profile->headroomNext;
+        else headroomHead[b] = student->profile->headroomNext;
+        if (student->profile->headroomNext != NULL) student->profile->headroomNext->profile->headroomPrev = student->profile->headroomPrev;
+        student->profile->headroomPrev = student->profile->headroomNext = NULL;
+        headroomCount[b]--;
     }
-    
-    file.close();
-}
 
-void saveAllData() {
-    cout << "\nSaving all data...\n";
-    saveStudents();
-    saveCourses();
-    savePendingRequests();
-    cout << "All data saved successfully.\n";
-}
+    // Fills page with matches [offset, offset + limit) in matric order. Returns the total number of matches.
+    int query(const StudentFilter& f, int offset, int limit, vector<Student*>& page) {
+        vector<vector<Student*>*> buckets;
+        int bucketTotal = programYearBuckets(f, buckets);
 
-void markRequestAsCancelled(string matric, string courseCode) {
-    RegistrationRequest* temp = regQueue.getFront();
-    while (temp != NULL) {
-        if (temp->matricNo == matric && temp->courseCode == courseCode) {
-            temp->isCancelled = true;
-            return;
+        int minBucket = f.minHeadroom < 0 ? 0 : (f.minHeadroom > MAX_HEADROOM ? MAX_HEADROOM : f.minHeadroom);
+        int headroomTotal = 0;
+        for (int b = minBucket; b <= MAX_HEADROOM; b++) headroomTotal += headroomCount[b];
+
+        // Scan whichever index narrows the candidates more
+        vector<Student*> found;
+        if (bucketTotal <= headroomTotal) {
+            for (size_t i = 0; i < buckets.size(); i++) {
+                vector<Student*>& bucket = *buckets[i];
+                for (size_t k = 0; k < bucket.size(); k++) {
+                    if (matches(bucket[k], f)) found.push_back(bucket[k]);
+                }
+            }
+        } else {
+            for (int b = minBucket; b <= MAX_HEADROOM; b++) {
+                for (Student* s = headroomHead[b]; s != NULL; s = s->profile->headroomNext) {
+                    if (matches(s, f)) found.push_back(s);
+                }
+            }
         }
-        temp = temp->next;
+
+        page.clear();
+        if (offset < (int)found.size()) {
+            int end = min((int)found.size(), offset + limit);
+            // Only the requested page needs to be in order
+            if (buckets.size() != 1 || bucketTotal > headroomTotal) {
+                partial_sort(found.begin(), found.begin() + end, found.end(), byMatric);
+            }
+            page.assign(found.begin() + offset, found.begin() + end);
+        }
+        return found.size();
     }
-}
 
-void studentMenu(Student* student) {
-    while (true) {
-        cout << "\n========================================\n";
-        cout << "   STUDENT MENU\n";
-        cout << "========================================\n";
-        cout << "Name: " << student->name << "\n";
-        cout << "Matric No: " << student->matricNo << "\n";
-        cout << "Program: " << student->program << " (Year " << student->year << ")\n";
-        cout << "Credits: " << student->currentCredit << "/" << student->maxCredit << "\n";
-        cout << "========================================\n";
-        cout << "1. View All Courses\n";
-        cout << "2. Search Course\n";
-        cout << "3. Register Course\n";
-        cout << "4. View Registered Courses\n";
-        cout << "5. Delete Course\n";
-        cout << "6. View Notifications\n";
-        cout << "7. View Registration Slip\n";
-        cout << "8. View Students in Course\n";
-        cout << "9. Back to Main Menu\n";
-        cout << "Choice: ";
-        
-        int choice;
-        cin >> choice;
-        cin.ignore();
-        
-        switch (choice) {
-            case 1: viewAllCourses(); break;
-            case 2: searchCourse(); break;
-            case 3: registerCourse(student); break;
-            case 4: viewRegisteredCourses(student); break;
-            case 5: deleteCourse(student); break;
-            case 6: viewNotifications(student); break;
-            case 7: viewRegistrationSlip(student); break;
-            case 8: viewStudentsInCourse(student); break;
-            case 9: saveAllData(); return;
-            default: cout << "Invalid choice.\n";
+    void clear() {
+        byProgramYear.clear();
+        for (int i = 0; i <= MAX_HEADROOM; i++) {
+            headroomHead[i] = NULL;
+            headroomCount[i] = 0;
         }
     }
-}
 
-void staffMenu(Staff* staff) {
-    while (true) {
-        cout << "\n========================================\n";
-        cout << "   STAFF MENU\n";
-        cout << "========================================\n";
-        cout << "1. View All Student Requests\n";
-        cout << "2. View All Students\n";
-        cout << "3. Search Student\n";
-        cout << "4. Insert Student\n";
-        cout << "5. Update Course Details\n";
-        cout << "6. Insert New Course\n";
-        cout << "7. Delete Course\n";
-        cout << "8. View Student List in Course\n";
-        cout << "9. View All Courses\n";
-        cout << "10. Retract Course from Student\n";
-        cout << "11. Insert Course for Student\n";
-        cout << "12. Back to Main Menu\n";
-        cout << "Choice: ";
-        
-        int choice;
-        cin >> choice;
-        cin.ignore();
-        
-        switch (choice) {
-            case 1: staffViewRequests(); break;
-            case 2: staffViewAllStudents(); break;
-            case 3: staffSearchStudent(); break;
-            case 4: staffInsertStudent(); break;
-            case 5: staffUpdateCourse(); break;
-            case 6: staffInsertCourse(); break;
-            case 7: staffDeleteCourse(); break;
-            case 8: staffViewStudentListInCourse(); break;
-            case 9: staffViewAllCourses(); break;
-            case 10: staffRetractCourse(); break;
-            case 11: staffInsertCourseForStudent(); break;
-            case 12: saveAllData(); return;
-            default: cout << "Invalid choice.\n";
+    // Distinct programs with their student counts
+    vector<pair<string, int> > programs() {
+        vector<pair<string, int> > result;
+        map<string, map<int, vector<Student*> > >::iterator p;
+        for (p = byProgramYear.begin(); p != byProgramYear.end(); ++p) {
+            int count = 0;
+            map<int, vector<Student*> >::iterator y;
+            for (y = p->second.begin(); y != p->second.end(); ++y) count += y->second.size();
+            result.push_back(make_pair(p->first, count));
         }
+        return result;
     }
+};
+
+// Outcome of a registration attempt
+enum RegisterResult { REGISTER_OK, REGISTER_DUPLICATE, REGISTER_OVER_CREDIT, REGISTER_FULL };
+
+// Staff structure
+struct Staff {
+    string name;
+    string staffID;
+};
+
+// Record Schemas
+// Every record in the data files is one tab-separated line. Each kind is declared once below as a row of
+// fields, and RecordSchema generates its parser and formatter from that list, so a loader and its saver
+// cannot drift apart. Parsing checks the field count and that numbers are whole numbers, and leaves text
+// fields as views into the line, so it allocates nothing. Formatting appends to a caller's buffer.
+inline bool parseField(string_view text, string_view& value) {
+    value = text;
+    return true;
 }
 
-void viewAllCourses() {
-    courseTree.displayAll();
+inline bool parseField(string_view text, int& value) {
+    const char* end = text.data() + text.size();
+    from_chars_result result = from_chars(text.data(), end, value);
+    return !text.empty() && result.ec == errc() && result.ptr == end;
 }
 
-void searchCourse() {
-    cout << "Enter Course Code: ";
-    string code;
-    getline(cin, code);
-    
-    Course* course = courseTree.search(code);
-    if (course == NULL) {
-        cout << "Course not found.\n";
-    } else {
-        cout << "\n=== Course Details ===\n";
-        cout << "Code: " << course->courseCode << "\n";
-        cout << "Name: " << course->courseName << "\n";
-        cout << "Credit: " << course->credit << "\n";
-        cout << "Students: " << course->currentCapacity << "/" << course->capacity << "\n";
+inline bool parseField(string_view text, long long& value) {
+    const char* end = text.data() + text.size();
+    from_chars_result result = from_chars(text.data(), end, value);
+    return !text.empty() && result.ec == errc() && result.ptr == end;
+}
+
+// Tabs and line breaks inside text would split the record, so they are written as spaces
+inline void formatField(string& out, string_view value) {
+    size_t start = out.size();
+    out.append(value.data(), value.size());
+    if (value.find_first_of("\t\n\r") == string_view::npos) return;
+    for (size_t i = start; i < out.size(); i++) {
+        if (out[i] == '\t' || out[i] == '\n' || out[i] == '\r') out[i] = ' ';
     }
 }
 
-void registerCourse(Student* student) {
-    cout << "Enter Course Code: ";
-    string code;
-    getline(cin, code);
-    
-    Course* course = courseTree.search(code);
-    if (course == NULL) {
-        cout << "Course not found.\n";
-        return;
+inline void formatField(string& out, int value) {
+    char digits[16];
+    out.append(digits, to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+inline void formatField(string& out, long long value) {
+    char digits[24];
+    out.append(digits, to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+template <class Row, auto... Members>
+struct RecordSchema {
+    static const int FIELDS = sizeof...(Members);
+
+    // Reads the fields from the front of line. On success line holds whatever followed the last field
+    // (empty for a well-formed record), and row's text fields point into the original line.
+    static bool parse(string_view& line, Row& row) {
+        bool more = true;
+        return (takeField(line, more, row.*Members) && ...);
     }
-    
-    if (findCourseInStudent(student, code) != NULL) {
-        cout << "You have already registered for this course.\n";
-        return;
+
+    static void format(const Row& row, string& out) {
+        int column = 0;
+        (appendField(out, column, row.*Members), ...);
     }
-    
-    if (student->currentCredit + course->credit > student->maxCredit) {
-        cout << "Registration failed: Exceeds maximum credit limit.\n";
-        return;
+
+    static bool equal(const Row& a, const Row& b) {
+        return ((a.*Members == b.*Members) && ...);
     }
-    
-    if (course->currentCapacity >= course->capacity) {
-        cout << "Course is already full.\n";
-        return;
+
+    template <class Visitor>
+    static void visit(Row& row, Visitor apply) {
+        (apply(row.*Members), ...);
     }
-    
-    regQueue.enqueue(student->matricNo, student->name, course->courseCode, 
-                     course->courseName, course->credit);
-    addCourseToStudent(student, code, "Pending");
-    student->currentCredit += course->credit;
-    cout << "Registration request submitted successfully (Status: Pending).\n";
+
+private:
+    template <class T>
+    static bool takeField(string_view& line, bool& more, T& value) {
+        if (!more) return false;
+        size_t tab = line.find('\t');
+        more = tab != string_view::npos;
+        string_view text = line.substr(0, tab);
+        line = more ? line.substr(tab + 1) : string_view();
+        return parseField(text, value);
+    }
+
+    template <class T>
+    static void appendField(string& out, int& column, const T& value) {
+        if (column++ > 0) out += '\t';
+        formatField(out, value);
+    }
+};
+
+// students.txt: a student line, then one enrollment line per registered course
+struct StudentRow {
+    string_view name;
+    string_view matricNo;
+    int maxCredit;
+    int currentCredit;
+    int year;
+    string_view program;
+    int courses;
+};
+typedef RecordSchema<StudentRow, &StudentRow::name, &StudentRow::matricNo, &StudentRow::maxCredit,
+                     &StudentRow::currentCredit, &StudentRow::year, &StudentRow::program, &StudentRow::courses> StudentSchema;
+
+struct EnrollmentRow {
+    string_view courseCode;
+    string_view status;
+};
+typedef RecordSchema<EnrollmentRow, &EnrollmentRow::courseCode, &EnrollmentRow::status> EnrollmentSchema;
+
+// courses.txt: a course line, then one line per student on its list
+struct CourseRow {
+    string_view courseCode;
+    string_view courseName;
+    string_view lecturerName;
+    int credit;
+    int capacity;
+    int seatsTaken;
+    int students;
+};
+typedef RecordSchema<CourseRow, &CourseRow::courseCode, &CourseRow::courseName, &CourseRow::lecturerName,
+                     &CourseRow::credit, &CourseRow::capacity, &CourseRow::seatsTaken, &CourseRow::students> CourseSchema;
+
+struct RosterRow {
+    string_view matricNo;
+    string_view name;
+};
+typedef RecordSchema<RosterRow, &RosterRow::matricNo, &RosterRow::name> RosterSchema;
+
+// staff.txt
+struct StaffRow {
+    string_view name;
+    string_view staffID;
+};
+typedef RecordSchema<StaffRow, &StaffRow::name, &StaffRow::staffID> StaffSchema;
+
+// pending_requests.txt: one line per course; a trailing "+" field joins it to the package on the line before
+struct RequestRow {
+    string_view matricNo;
+    string_view studentName;
+    string_view courseCode;
+    string_view courseName;
+    int credit;
+    long long timestamp;
+};
+typedef RecordSchema<RequestRow, &RequestRow::matricNo, &RequestRow::studentName, &RequestRow::courseCode,
+                     &RequestRow::courseName, &RequestRow::credit, &RequestRow::timestamp> RequestSchema;
+
+// A data file line without the '\r' a file saved on Windows leaves at the end
+inline string_view recordLine(const string& line) {
+    string_view text = line;
+    if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+    return text;
 }
 
-void viewRegisteredCourses(Student* student) {
-    if (student->courseList == NULL) {
-        cout << "No courses registered.\n";
-        return;
+// Lines a loader could not read. They are appended to <file>.rejected as they were, so the next save
+// can rewrite the data file from what was loaded without losing them.
+struct RejectedLines {
+    vector<string> lines;
+
+    void add(const string& line) {
+        lines.push_back(line);
     }
-    
-    cout << "\n=== Registered Courses ===\n";
-    int count = 1;
-    CourseNode* current = student->courseList;
-    while (current != NULL) {
-        Course* course = courseTree.search(current->courseCode);
-        if (course != NULL) {
-            cout << count++ << ". " << course->courseCode << " - " 
-                 << course->courseName << " (" << course->credit 
-                 << " credits) [" << current->status << "]\n";
-        }
-        current = current->next;
+
+    void keep(const string& filename) {
+        if (lines.empty()) return;
+        string rejectedFile = filename + ".rejected";
+        ofstream out(rejectedFile.c_str(), ios::app);
+        for (size_t i = 0; i < lines.size(); i++) out << lines[i] << "\n";
+        cout << "Skipped " << lines.size() << " malformed line(s) in " << filename << "; "
+             << (out ? "copied them to " + rejectedFile : "could not copy them to " + rejectedFile) << ".\n";
     }
+};
+
+// Global variables
+StudentBST studentTree;
+StudentIndex studentIndex;
+CourseBST courseTree;
+CourseSearchIndex courseIndex;
+vector<Staff> staffList;
+RegistrationQueue regQueue;
+const int LIST_PAGE_SIZE = 25;
+int shardCount = 0; // set in a shard worker, which holds only the courses shardOf() gives its index
+int shardIndex = 0;
+const char* PAGE_PROMPT = "\nPress Enter for next page, type a key to jump to, or q to quit: ";
+
+// Which of count shards owns a course code (or is a matric number's home), by FNV-1a hash
+int shardOf(const string& key, int count) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < key.size(); i++) hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+    return hash % count;
 }
 
-void deleteCourse(Student* student) {
-    viewRegisteredCourses(student);
-    
+// Function prototypes
+void loadStudents(const char* filename = "students.txt");
+void loadCourses(const char* filename = "courses.txt");
+void loadStaff();
+Staff* findStaff(const string& staffID);
+void loadPendingRequests();
+void saveStudents(const char* filename = "students.txt");
+void saveCourses(const char* filename = "courses.txt");
+void savePendingRequests();
+void saveAllData();
+void saveStudentRecords(Student* root, ofstream& file);
+Student* readStudentRecord(istream& file, const string& line, RejectedLines& rejected);
+void writeStudentRecord(Student* student, string& out, bool keepOrder = false);
+bool allStudentsLoaded();
+void saveCourseRecords(Course* root, ofstream& file);
+void studentMenu(Student* student);
+void staffMenu(Staff* staff);
+void printMainMenu();
+void printStudentMenu(Student* student);
+void printStaffMenu();
+string nextPageKey(const string& nextKey, const string& input);
+string displayCatalogPage(const string& fromKey, int pageSize);
+void searchCourseQuery(const string& query);
+void registerCourseCode(Student* student, const string& code);
+void deleteCourseCode(Student* student, const string& code);
+bool showLatestNotification(Student* student);
+bool applyNotificationChoice(Student* student, int choice);
+void downloadRegistrationSlip(Student* student, const string& slip);
+void viewStudentsInCourseCode(Student* student, const string& code);
+void showStudentDetails(const string& matric);
+Course* showCourseStudentList(const string& code);
+void downloadCourseStudentList(Course* course);
+RegistrationRequest* showNextRequest();
+void printRequestChoice(RegistrationRequest* req);
+void staffProcessCourseRequests();
+bool decideRequest(RegistrationRequest* req, int choice, const string& reason);
+bool requestNeedsReason(RegistrationRequest* req);
+bool decideFrontRequest(RegistrationRequest* req, int choice, const string& reason);
+void viewAllCourses();
+string askNextPage(const string& nextKey);
+void searchCourse();
+void printCourseLine(Course* course);
+void registerCourse(Student* student);
+void viewRegisteredCourses(Student* student);
+void deleteCourse(Student* student);
+void viewNotifications(Student* student);
+void viewRegistrationSlip(Student* student);
+string renderRegistrationSlip(Student* student);
+void appendRegistrationSlip(string& slip, Student* student);
+void appendCourseRoster(string& out, Course* course);
+void viewStudentsInCourse(Student* student);
+void staffViewRequests();
+void staffViewAllStudents();
+void staffSearchStudent();
+void staffInsertStudent();
+void staffFilterStudents();
+string selectProgram();
+void staffBlockRegister();
+void printStudentLine(Student* student);
+void staffUpdateCourse();
+void staffInsertCourse();
+void staffDeleteCourse();
+void staffViewStudentListInCourse();
+void staffViewAllCourses();
+void staffRetractCourse();
+void retractStudentCourse(Student* student, CourseNode* courseNode);
+void updateCourseLecturer(Course* course, const string& lecturer);
+void updateCourseCapacity(Course* course, int capacity);
+Course* insertCourseRecord(const string& code, const string& name, const string& lecturer, int credit, int capacity);
+bool deleteCourseRecord(Course* course);
+void staffInsertCourseForStudent();
+void staffBatchAllocate();
+void staffBulkExport();
+void staffAnalytics();
+void printPerformanceStats();
+int writeTraceFile(string filename);
+void staffWriteTrace();
+void insertStudentInCourseList(Course* course, string matric, string name);
+void removeStudentFromCourseList(Course* course, string matric);
+void markRequestAsCancelled(string matric, string courseCode);
+RegisterResult submitRegistration(Student* student, Course* course);
+void queueRegistration(Student* student, Course* course);
+RegisterResult submitPackage(Student* student, const vector<Course*>& courses, int& failed);
+void registerPackageCodes(Student* student, const vector<string>& codes);
+vector<string> splitCodes(const string& text);
+RegisterResult checkRegistration(Student* student, Course* course);
+void dropRegisteredCourse(Student* student, CourseNode* courseNode, Course* course, RegistrationRequest* req);
+bool approveRequest(RegistrationRequest* req, Student* student, Course* course);
+bool approvePackage(RegistrationRequest* req, Student* student);
+int releasePackage(RegistrationRequest* req, Student* student);
+int takeSeats(Course* const* courses, int n);
+void releaseSeats(Course* const* courses, int n);
+bool rejectRequest(RegistrationRequest* req, Student* student, string reason);
+void addCourseToStudent(Student* student, string courseCode, string status);
+void adjustStudentCredit(Student* student, int pendingDelta, int approvedDelta);
+void initCreditTotals();
+void splitCreditTotals(Student* student);
+void removeCourseFromStudent(Student* student, string courseCode);
+CourseNode* findCourseInStudent(Student* student, string courseCode);
+CourseNode* findCourseInStudent(Student* student, const PackedKey& key, const string& courseCode);
+int countStudentCourses(Student* student);
+string getCurrentTimestamp(time_t t = 0);
+void easterEgg();
+int runCommandLine(int argc, char* argv[]);
+void benchAllocation(int numStudents, int numCourses);
+void benchSearch(int numCourses);
+void benchCatalog(int numCourses);
+void benchStudentIndex(int numStudents);
+void benchDrain(int numStudents, int numCourses);
+void benchPackages(int numStudents, int numCourses);
+void benchCohort(int numStudents);
+void benchCourseQueue(int numStudents, int numCourses);
+void benchQueuePosition(int numStudents, int numCourses);
+void benchPackedKeys(int numStudents);
+void benchListing(int numStudents);
+void stressDeepTrees(int n);
+void benchTrace();
+void benchExport(int numStudents, int threads);
+void benchAnalytics(int numStudents, int numCourses);
+void benchLazyStudents(int numStudents, int cacheSize);
+int fuzzRecords(int iterations, unsigned seed);
+void benchRecords(int n);
+void benchChangeFeed(int mutations, int capacity);
+long long residentBytes();
+void shuffleIndices(vector<int>& v);
+double elapsedMs(chrono::steady_clock::time_point start);
+
+// All credit changes go through here so the pending/approved totals and the headroom index stay current
+void adjustStudentCredit(Student* student, int pendingDelta, int approvedDelta) {
+    studentIndex.unlinkHeadroom(student);
+    student->pendingCredit += pendingDelta;
+    student->approvedCredit += approvedDelta;
+    student->currentCredit += pendingDelta + approvedDelta;
+    studentIndex.linkHeadroom(student);
+}
+
+// The data file only stores currentCredit, so split it once after students and courses are loaded.
+// Anything not accounted for by approved courses is treated as pending.
+void initCreditTotals() {
+    TreeCursor<Student> cursor(studentTree.getRoot());
+    while (cursor.hasNext()) splitCreditTotals(cursor.next());
+}
+
+void splitCreditTotals(Student* student) {
+    int approved = 0;
+    for (CourseNode* cur = student->courseList; cur != NULL; cur = cur->next) {
+        if (cur->status != "Approved") continue;
+        Course* course = courseTree.search(cur->courseCode);
+        if (course != NULL) approved += course->credit;
+    }
+    student->approvedCredit = approved;
+    student->pendingCredit = student->currentCredit - approved;
+}
+
+void addCourseToStudent(Student* student, string courseCode, string status) {
+    CourseNode* newNode = new CourseNode(courseCode, status);
+    newNode->next = student->courseList;
+    student->courseList = newNode;
+}
+
+void removeCourseFromStudent(Student* student, string courseCode) {
     if (student->courseList == NULL) return;
+    PackedKey key(courseCode);
     
-    cout << "Enter Course Code to delete: ";
-    string code;
-    getline(cin, code);
-    
-    CourseNode* courseNode = findCourseInStudent(student, code);
-    if (courseNode == NULL) {
-        cout << "Course not found in your registered courses.\n";
+    if (sameKey(student->courseList->key, student->courseList->courseCode, key, courseCode)) {
+        CourseNode* temp = student->courseList;
+        student->courseList = student->courseList->next;
+        delete temp;
         return;
     }
     
-    Course* course = courseTree.search(code);
-    if (course != NULL) {
-        if (courseNode->status == "Pending") {
-            student->currentCredit -= course->credit;
-            markRequestAsCancelled(student->matricNo, code);
-        } else {
-            student->currentCredit -= course->credit;
-            course->currentCapacity--;
-            removeStudentFromCourseList(course, student->matricNo);
-        }
+    CourseNode* current = student->courseList;
+    while (current->next != NULL && !sameKey(current->next->key, current->next->courseCode, key, courseCode)) {
+        current = current->next;
     }
     
-    removeCourseFromStudent(student, code);
-    
-    cout << "Course deleted successfully.\n";
+    if (current->next != NULL) {
+        CourseNode* temp = current->next;
+        current->next = current->next->next;
+        delete temp;
+    }
 }
 
-void viewNotifications(Student* student) {
-    while (true) {
-        if (student->notifications.isEmpty()) {
-            cout << "No notifications.\n";
-            return;
-        }
-        
-        Notification* notif = student->notifications.getTop();
-        cout << "\n=== Latest Notification ===\n";
-        cout << notif->message << "\n";
-        cout << "Time: " << getCurrentTimestamp(notif->timestamp) << "\n";
-        
-        cout << "\n1. Mark as Unread (Stop)\n";
-        cout << "2. Mark as Read (Next)\n";
-        cout << "3. Mark All as Read\n";
-        cout << "Choice: ";
-        
-        int choice;
-        cin >> choice;
-        cin.ignore();
-        
-        if (choice == 1) {
-            return;
-        } else if (choice == 2) {
-            student->notifications.pop();
-        } else if (choice == 3) {
-            student->notifications.clear();
-            cout << "All notifications marked as read.\n";
-            return;
-        }
-    }
+CourseNode* findCourseInStudent(Student* student, string courseCode) {
+    return findCourseInStudent(student, PackedKey(courseCode), courseCode);
 }
 
-void viewRegistrationSlip(Student* student) {
-    cout << "\n========================================\n";
-    cout << "      COURSE REGISTRATION SLIP\n";
-    cout << "========================================\n";
-    cout << "Name: " << student->name << "\n";
-    cout << "Matric No: " << student->matricNo << "\n";
-    cout << "Program: " << student->program << "\n";
-    cout << "Year: " << student->year << "\n";
-    cout << "========================================\n";
-    cout << "APPROVED COURSES:\n";
-    
-    bool hasApproved = false;
+// Lookup with a key the caller already holds, so admission checks and the queue drain
+// do not copy the code or touch the course's details
+CourseNode* findCourseInStudent(Student* student, const PackedKey& key, const string& courseCode) {
     CourseNode* current = student->courseList;
     while (current != NULL) {
-        if (current->status == "Approved") {
-            Course* course = courseTree.search(current->courseCode);
-            if (course != NULL) {
-                cout << course->courseCode << " | " << course->courseName 
-                     << " | " << course->credit << " credit(s)\n";
-                hasApproved = true;
-            }
+        if (sameKey(current->key, current->courseCode, key, courseCode)) {
+            return current;
         }
         current = current->next;
     }
-    
-    if (!hasApproved) {
-        cout << "No approved courses yet.\n";
+    return NULL;
+}
+
+int countStudentCourses(Student* student) {
+    int count = 0;
+    CourseNode* current = student->courseList;
+    while (current != NULL) {
+        count++;
+        current = current->next;
     }
-    int approvedCredit = 0;
-    CourseNode* cur = student->courseList;
-    while (cur) {
-        if (cur->status == "Approved") {
-            Course* c = courseTree.search(cur->courseCode);
-            if (c) approvedCredit += c->credit;
+    return count;
+}
+
+// Lazy Student Records
+// With --lazy-students N, only an offset table of students.txt is kept in memory. studentTree.search reads a
+// record in the first time it is asked for, and at most about N records stay resident, least recently used
+// out first. A record that changed while resident is written to a side file when it is evicted, and
+// saveStudents merges everything back into students.txt.
+struct StudentPage {
+    string matricNo;
+    long long offset;      // where the record starts: in the data file, or the spill file once spilled
+    int length;
+    bool spilled;
+    long long notesOffset; // notifications kept in the spill file while evicted, or -1
+    int notesLength;
+    size_t digest;         // hash of the record when it was paged in; a different hash on eviction means dirty
+    int pins;              // evicted only when 0
+    Student* resident;
+    StudentPage* newer;    // LRU neighbours while resident
+    StudentPage* older;
+};
+
+class StudentPager {
+private:
+    string dataFile;
+    string spillFile;
+    ifstream data;
+    fstream spill;
+    long long spillEnd;
+    deque<StudentPage> pages;       // stable addresses; byMatric keeps them in matric order
+    vector<StudentPage*> byMatric;
+    unordered_map<Student*, StudentPage*> residentPages;
+    StudentPage* newest;
+    StudentPage* oldest;
+    size_t limit;
+    long long hits;
+    long long pageIns;
+    long long writeBacks;
+
+    static bool pageBefore(StudentPage* page, const string& matric) {
+        return page->matricNo < matric;
+    }
+
+    size_t lowerBound(const string& matric) {
+        return lower_bound(byMatric.begin(), byMatric.end(), matric, pageBefore) - byMatric.begin();
+    }
+
+    StudentPage* find(const string& matric) {
+        size_t i = lowerBound(matric);
+        return i < byMatric.size() && byMatric[i]->matricNo == matric ? byMatric[i] : NULL;
+    }
+
+    StudentPage* newPage(const string& matric, long long offset, int length) {
+        StudentPage page = { matric, offset, length, false, -1, 0, 0, 0, NULL, NULL, NULL };
+        pages.push_back(page);
+        return &pages.back();
+    }
+
+    void linkNewest(StudentPage* page) {
+        page->older = newest;
+        page->newer = NULL;
+        if (newest != NULL) newest->newer = page;
+        newest = page;
+        if (oldest == NULL) oldest = page;
+    }
+
+    void unlink(StudentPage* page) {
+        if (page->newer != NULL) page->newer->older = page->older;
+        else newest = page->older;
+        if (page->older != NULL) page->older->newer = page->newer;
+        else oldest = page->newer;
+        page->newer = page->older = NULL;
+    }
+
+    static string readRange(istream& file, long long offset, int length) {
+        string text(length, '\0');
+        file.clear();
+        file.seekg(offset);
+        file.read(&text[0], length);
+        text.resize(file.gcount());
+        return text;
+    }
+
+    long long appendSpill(const string& text) {
+        long long offset = spillEnd;
+        spill.clear();
+        spill.seekp(offset);
+        spill.write(text.data(), text.size());
+        spillEnd += text.size();
+        return offset;
+    }
+
+    string recordText(Student* student) {
+        string out;
+        writeStudentRecord(student, out, true);
+        return out;
+    }
+
+    // The record as it stands on disk, ending in a newline
+    string storedRecord(StudentPage* page) {
+        string text = readRange(page->spilled ? (istream&)spill : (istream&)data, page->offset, page->length);
+        if (text.empty() || text[text.size() - 1] != '\n') text += '\n';
+        return text;
+    }
+
+    Student* pageIn(StudentPage* page) {
+        string text = storedRecord(page);
+        text.erase(remove(text.begin(), text.end(), '\r'), text.end());
+        istringstream in(text);
+        string line;
+        getline(in, line);
+        RejectedLines rejected;
+        Student* student = readStudentRecord(in, line, rejected);
+        rejected.keep(dataFile);
+        if (student == NULL) return NULL;
+        splitCreditTotals(student);
+        if (page->notesOffset >= 0) {
+            // Oldest first, so pushing them back leaves the newest on top
+            istringstream notes(readRange(spill, page->notesOffset, page->notesLength));
+            while (getline(notes, line)) {
+                size_t tab = line.find('\t');
+                if (tab == string::npos) continue;
+                student->profile->notifications.push(line.substr(tab + 1));
+                student->profile->notifications.getTop()->timestamp = atol(line.substr(0, tab).c_str());
+            }
         }
-        cur = cur->next;
+        // A record that dropped an unreadable line is written back clean on eviction, so the line is copied out once
+        page->digest = rejected.lines.empty() ? hash<string>()(recordText(student)) : 0;
+        page->resident = student;
+        residentPages[student] = page;
+        linkNewest(page);
+        studentTree.insert(student);
+        studentIndex.add(student);
+        pageIns++;
+        return student;
     }
-    cout << "========================================\n";
-    cout << "Total Approved Credits: " << approvedCredit << "/" << student->maxCredit << "\n";
-    
-    cout << "\nDownload slip? (y/n): ";
-    char choice;
-    cin >> choice;
-    cin.ignore();
+
+    void evict(StudentPage* page) {
+        Student* student = page->resident;
+        string record = recordText(student);
+        if (page->offset < 0 || hash<string>()(record) != page->digest) {
+            page->offset = appendSpill(record);
+            page->length = record.size();
+            page->spilled = true;
+            writeBacks++;
+        }
+        page->notesOffset = -1;
+        if (!student->profile->notifications.isEmpty()) {
+            vector<Notification*> stack;
+            for (Notification* n = student->profile->notifications.getTop(); n != NULL; n = n->next) stack.push_back(n);
+            string notes;
+            for (int i = (int)stack.size() - 1; i >= 0; i--) notes += to_string((long long)stack[i]->timestamp) + "\t" + stack[i]->message + "\n";
+            page->notesOffset = appendSpill(notes);
+            page->notesLength = notes.size();
+        }
+
+        unlink(page);
+        residentPages.erase(student);
+        page->resident = NULL;
+        studentIndex.remove(student);
+        while (student->courseList != NULL) {
+            CourseNode* next = student->courseList->next;
+            delete student->courseList;
+            student->courseList = next;
+        }
+        studentTree.deleteStudent(page->matricNo);
+    }
+
+public:
+    StudentPager() : spillEnd(0), newest(NULL), oldest(NULL), limit(0), hits(0), pageIns(0), writeBacks(0) {}
+
+    // Builds the offset table of filename. Records are read later, on demand.
+    void open(const char* filename, size_t cacheLimit) {
+        STAT_SCOPE(OP_LOAD_STUDENTS);
+        TRACE_SPAN(TRACE_LOAD, "students");
+        dataFile = filename;
+        spillFile = dataFile + ".pages";
+        limit = cacheLimit > 0 ? cacheLimit : 1;
+        lazyStudents = true;
+        spill.open(spillFile.c_str(), ios::in | ios::out | ios::trunc | ios::binary);
+        data.open(filename, ios::binary);
+        if (!data) {
+            cout << "Students file not found. Starting with empty student list.\n";
+            return;
+        }
+
+        // Only the student line of each record is parsed here; its enrollment lines are skipped
+        RejectedLines rejected;
+        string line;
+        long long offset = 0;
+        while (getline(data, line)) {
+            long long start = offset;
+            offset += line.size() + 1;
+            string_view text = recordLine(line);
+            if (text.empty()) continue;
+            StudentRow row;
+            if (!StudentSchema::parse(text, row) || !text.empty() || row.courses < 0) {
+                rejected.add(line);
+                continue;
+            }
+            string matric(row.matricNo);
+            for (int i = 0; i < row.courses && getline(data, line); i++) offset += line.size() + 1;
+            byMatric.push_back(newPage(matric, start, offset - start));
+        }
+        data.clear();
+
+        // Like loadStudents, the first record wins if a matric number repeats
+        stable_sort(byMatric.begin(), byMatric.end(), [](StudentPage* a, StudentPage* b) { return a->matricNo < b->matricNo; });
+        byMatric.erase(unique(byMatric.begin(), byMatric.end(), [](StudentPage* a, StudentPage* b) { return a->matricNo == b->matricNo; }), byMatric.end());
+        rejected.keep(dataFile);
+        cout << "Students indexed successfully (" << byMatric.size() << " records, up to " << limit << " in memory).\n";
+    }
+
+    // Called by studentTree.search with whatever the tree already holds
+    Student* lookup(const string& matric, Student* resident) {
+        if (resident != NULL) {
+            unordered_map<Student*, StudentPage*>::iterator it = residentPages.find(resident);
+            if (it != residentPages.end()) {
+                unlink(it->second);
+                linkNewest(it->second);
+            }
+            hits++;
+            return resident;
+        }
+        StudentPage* page = find(matric);
+        return page == NULL ? NULL : pageIn(page);
+    }
+
+    // A student created this run; it stays dirty until saved
+    void adopt(Student* student) {
+        StudentPage* page = newPage(student->profile->matricNo, -1, 0);
+        byMatric.insert(byMatric.begin() + lowerBound(page->matricNo), page);
+        page->resident = student;
+        residentPages[student] = page;
+        linkNewest(page);
+    }
+
+    // A pinned record is never evicted, e.g. the student logged in at the console. No-ops unless paging.
+    void pin(Student* student) {
+        unordered_map<Student*, StudentPage*>::iterator it = residentPages.find(student);
+        if (it != residentPages.end()) it->second->pins++;
+    }
+
+    void unpin(Student* student) {
+        unordered_map<Student*, StudentPage*>::iterator it = residentPages.find(student);
+        if (it != residentPages.end()) it->second->pins--;
+    }
+
+    // Evicts least recently used records down to the limit. Callers must not hold Student pointers
+    // across this (except pinned ones), so it runs between menu choices rather than inside search.
+    void trim() {
+        StudentPage* page = oldest;
+        while (residentPages.size() > limit && page != NULL) {
+            StudentPage* next = page->newer;
+            if (page->pins == 0) evict(page);
+            page = next;
+        }
+    }
+
+    bool empty() {
+        return byMatric.empty();
+    }
+
+    // Same listing as studentTree.displayPage, paging in one page of records first
+    string displayPage(const string& fromKey, int pageSize) {
+        trim();
+        size_t i = lowerBound(fromKey);
+        for (size_t end = min(byMatric.size(), i + pageSize + 1); i < end; i++) studentTree.search(byMatric[i]->matricNo);
+        return studentTree.displayPage(fromKey, pageSize);
+    }
+
+    // Writes every record in matric order: resident ones as they are now, the rest copied from disk
+    bool save(const char* filename) {
+        string temp = string(filename) + ".tmp";
+        ofstream out(temp.c_str(), ios::binary);
+        if (!out) return false;
+        vector<long long> offsets(byMatric.size());
+        long long position = 0;
+        for (size_t i = 0; i < byMatric.size(); i++) {
+            StudentPage* page = byMatric[i];
+            string record = page->resident != NULL ? recordText(page->resident) : storedRecord(page);
+            out << record;
+            offsets[i] = position;
+            position += record.size();
+        }
+        out.close();
+        if (!out) return false;
+
+        bool ownFile = dataFile == filename;
+        if (ownFile) data.close();
+        remove(filename);
+        if (rename(temp.c_str(), filename) != 0) return false;
+        if (!ownFile) return true;
+
+        // Every record now lives in the new file, so nothing resident is dirty any more
+        data.open(filename, ios::binary);
+        for (size_t i = 0; i < byMatric.size(); i++) {
+            StudentPage* page = byMatric[i];
+            long long end = i + 1 < byMatric.size() ? offsets[i + 1] : position;
+            page->offset = offsets[i];
+            page->length = end - offsets[i];
+            page->spilled = false;
+            if (page->resident != NULL) page->digest = hash<string>()(recordText(page->resident));
+        }
+        return true;
+    }
+
+    void printStats() {
+        long long lookups = hits + pageIns;
+        ostringstream out;
+        out << fixed << setprecision(1);
+        out << "Student cache: " << residentPages.size() << " of " << byMatric.size() << " records resident (limit "
+            << limit << "), hit rate " << (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "% ("
+            << hits << " hits, " << pageIns << " page-ins, " << writeBacks << " write-backs)\n";
+        out << "Resident memory: " << residentBytes() / 1048576.0 << " MB\n";
+        cout << out.str();
+    }
+
+    // Drops the side file; records it held are lost unless saved first
+    void close() {
+        if (spill.is_open()) {
+            spill.close();
+            remove(spillFile.c_str());
+        }
+    }
+
+    ~StudentPager() {
+        close();
+    }
+};
+
+StudentPager studentPager;
+
+Student* lazyStudentLookup(const string& matric, Student* resident) {
+    return studentPager.lookup(matric, resident);
+}
+
+// Options that walk every student need them all in memory
+bool allStudentsLoaded() {
+    if (!lazyStudents) return true;
+    cout << "This option needs every student record in memory. Restart without --lazy-students to use it.\n";
+    return false;
+}
+
+// Change Feed
+// With --change-feed, every change to a student's courses is published as a fixed-size event into a bounded
+// ring. A publisher claims a slot with one compare-and-swap and never waits: if the ring is full the event is
+// dropped and counted, and readers see the gap in the sequence numbers. One feed thread drains the ring in
+// batches and hands each batch to the sinks (an append-only file, local socket subscribers).
+enum ChangeKind {
+    CHANGE_REGISTERED,
+    CHANGE_APPROVED,
+    CHANGE_REJECTED,
+    CHANGE_DROPPED,
+    CHANGE_RETRACTED,
+    CHANGE_ENROLLED, // put straight into a course by staff
+    CHANGE_KIND_COUNT
+};
+
+const char* changeKindNames[CHANGE_KIND_COUNT] = {
+    "REGISTERED", "APPROVED", "REJECTED", "DROPPED", "RETRACTED", "ENROLLED"
+};
+
+struct ChangeEvent {
+    long long seq;
+    long long timeUs; // wall clock
+    int kind;
+    int credit;
+    bool truncated; // a key was longer than its field and was cut short
+    char matricNo[24];
+    char courseCode[24];
+};
+
+// Feed lines: one event per line
+struct ChangeRow {
+    long long seq;
+    long long timeUs;
+    string_view kind;
+    string_view matricNo;
+    string_view courseCode;
+    int credit;
+};
+typedef RecordSchema<ChangeRow, &ChangeRow::seq, &ChangeRow::timeUs, &ChangeRow::kind,
+                     &ChangeRow::matricNo, &ChangeRow::courseCode, &ChangeRow::credit> ChangeSchema;
+
+struct ChangeSlot {
+    atomic<unsigned long long> turn; // == position while free, position + 1 once written
+    ChangeEvent event;
+};
+
+// Bounded ring for any number of publishers and one reader (per-slot turn counters, as in Vyukov's queue)
+class ChangeRing {
+private:
+    ChangeSlot* slots;
+    unsigned long long capacity;
+    alignas(64) atomic<unsigned long long> tail; // next position to claim
+    alignas(64) unsigned long long head;         // next position to read; feed thread only
+
+public:
+    // capacity must be a power of two
+    explicit ChangeRing(int size) : slots(new ChangeSlot[size]), capacity(size), tail(0), head(0) {
+        for (int i = 0; i < size; i++) slots[i].turn.store(i, memory_order_relaxed);
+    }
+
+    ~ChangeRing() {
+        delete[] slots;
+    }
+
+    // Returns false without waiting if the ring is full
+    bool push(const ChangeEvent& event) {
+        unsigned long long pos = tail.load(memory_order_relaxed);
+        while (true) {
+            ChangeSlot& slot = slots[pos & (capacity - 1)];
+            unsigned long long turn = slot.turn.load(memory_order_acquire);
+            if (turn == pos) {
+                if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    slot.event = event;
+                    slot.turn.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (turn < pos) {
+                return false; // still holds the event from one lap ago
+            } else {
+                pos = tail.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Moves up to max events into out, oldest first
+    int pop(ChangeEvent* out, int max) {
+        int n = 0;
+        while (n < max) {
+            ChangeSlot& slot = slots[head & (capacity - 1)];
+            if (slot.turn.load(memory_order_acquire) != head + 1) break;
+            out[n++] = slot.event;
+            slot.turn.store(head + capacity, memory_order_release);
+            head++;
+        }
+        return n;
+    }
+};
+
+// Where batches go. Sinks run on the feed thread and must not block for long: the ring fills meanwhile.
+class ChangeSink {
+public:
+    virtual ~ChangeSink() {}
+    virtual void write(const string& lines, int events) = 0;
+    virtual void poll() {} // after every batch and while the feed is idle
+    virtual void printStats(ostream& out) = 0;
+};
+
+// Appends every batch to a file with one write
+class FileChangeSink : public ChangeSink {
+private:
+    FILE* file;
+    string path;
+    long long bytes;
+    long long written; // events
+
+public:
+    FileChangeSink() : file(NULL), bytes(0), written(0) {}
+
+    bool open(const string& filename) {
+        path = filename;
+        file = fopen(filename.c_str(), "a");
+        return file != NULL;
+    }
+
+    void write(const string& lines, int events) {
+        fwrite(lines.data(), 1, lines.size(), file);
+        fflush(file);
+        bytes += lines.size();
+        written += events;
+    }
+
+    void printStats(ostream& out) {
+        out << "  " << path << ": " << written << " events (" << bytes << " bytes) appended\n";
+    }
+
+    ~FileChangeSink() {
+        if (file != NULL) fclose(file);
+    }
+};
+
+#ifdef __linux__
+struct ChangeSubscriber {
+    int fd;
+    string backlog; // lines the socket has not taken yet
+};
+
+// Streams every batch to whoever is connected to 127.0.0.1:port. A subscriber sees events from when it
+// connects, and one that falls more than SUBSCRIBER_BACKLOG bytes behind is disconnected rather than waited for.
+class SocketChangeSink : public ChangeSink {
+private:
+    static const size_t SUBSCRIBER_BACKLOG = 4 << 20;
+    int listener;
+    int boundPort;
+    vector<ChangeSubscriber> subscribers;
+    long long accepted;
+    long long tooSlow;
+    long long queued; // events handed to subscribers, counted once per subscriber
+
+    // Sends what each socket will take now; returns false for a subscriber to drop
+    bool flush(ChangeSubscriber& s) {
+        while (!s.backlog.empty()) {
+            ssize_t n = send(s.fd, s.backlog.data(), s.backlog.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) return false;
+            s.backlog.erase(0, n);
+        }
+        if (s.backlog.size() <= SUBSCRIBER_BACKLOG) return true;
+        tooSlow++;
+        return false;
+    }
+
+    void flushAll() {
+        size_t kept = 0;
+        for (size_t i = 0; i < subscribers.size(); i++) {
+            if (flush(subscribers[i])) subscribers[kept++] = subscribers[i];
+            else ::close(subscribers[i].fd);
+        }
+        subscribers.resize(kept);
+    }
+
+public:
+    SocketChangeSink() : listener(-1), boundPort(0), accepted(0), tooSlow(0), queued(0) {}
+
+    // Port 0 picks a free port; port() then says which
+    bool listen(int port) {
+        listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int yes = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        socklen_t length = sizeof(address);
+        if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(listener, SOMAXCONN) < 0 ||
+            getsockname(listener, (sockaddr*)&address, &length) < 0) {
+            cout << "Cannot listen for change feed subscribers on port " << port << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        boundPort = ntohs(address.sin_port);
+        return true;
+    }
+
+    int port() {
+        return boundPort;
+    }
+
+    void write(const string& lines, int events) {
+        for (size_t i = 0; i < subscribers.size(); i++) subscribers[i].backlog += lines;
+        queued += (long long)events * subscribers.size();
+    }
+
+    void poll() {
+        int fd;
+        while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+            ChangeSubscriber s = { fd, "" };
+            subscribers.push_back(s);
+            accepted++;
+        }
+        flushAll();
+    }
+
+    void printStats(ostream& out) {
+        out << "  port " << boundPort << ": " << queued << " events queued for subscribers, " << subscribers.size() << " subscriber(s) still connected, "
+             << accepted << " accepted, " << tooSlow << " disconnected for falling behind\n";
+    }
+
+    // Gives slow subscribers up to a second to take the last lines
+    ~SocketChangeSink() {
+        for (int i = 0; i < 100; i++) {
+            flushAll();
+            bool pending = false;
+            for (size_t k = 0; k < subscribers.size(); k++) pending = pending || !subscribers[k].backlog.empty();
+            if (!pending) break;
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        for (size_t i = 0; i < subscribers.size(); i++) ::close(subscribers[i].fd);
+        if (listener >= 0) ::close(listener);
+    }
+};
+#endif
+
+class ChangeFeed {
+private:
+    static const int BATCH = 512;
+    static const int KEY_LENGTH = sizeof(ChangeEvent::matricNo) - 1;
+    ChangeRing* ring;
+    vector<ChangeSink*> sinks;
+    thread worker;
+    atomic<bool> stopping;
+    atomic<long long> nextSeq;
+    atomic<long long> droppedEvents;
+    atomic<long long> truncatedEvents;
+    atomic<long long> deliveredEvents;
+    atomic<long long> batches;
+    bool started;
+    string sinkStats; // what the sinks reported when they were closed
+
+    void run() {
+        vector<ChangeEvent> batch(BATCH);
+        string lines;
+        while (true) {
+            int n = ring->pop(batch.data(), BATCH);
+            if (n == 0) {
+                // Publishers have finished by the time stop() is called, so an empty ring then is the end
+                if (stopping.load(memory_order_acquire)) break;
+                for (size_t s = 0; s < sinks.size(); s++) sinks[s]->poll();
+                this_thread::sleep_for(chrono::microseconds(500));
+                continue;
+            }
+            lines.clear();
+            for (int i = 0; i < n; i++) {
+                const ChangeEvent& e = batch[i];
+                ChangeRow row = { e.seq, e.timeUs, changeKindNames[e.kind], e.matricNo, e.courseCode, e.credit };
+                ChangeSchema::format(row, lines);
+                if (e.truncated) lines += "\tTRUNCATED";
+                lines += '\n';
+            }
+            for (size_t s = 0; s < sinks.size(); s++) {
+                sinks[s]->write(lines, n);
+                sinks[s]->poll();
+            }
+            deliveredEvents.fetch_add(n, memory_order_relaxed);
+            batches.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    // Returns false if value did not fit and was cut to KEY_LENGTH characters
+    static bool copyField(char* field, const string& value) {
+        size_t n = min(value.size(), (size_t)KEY_LENGTH);
+        memcpy(field, value.data(), n);
+        field[n] = '\0';
+        return n == value.size();
+    }
+
+public:
+    ChangeFeed() : ring(NULL), stopping(false), nextSeq(0), droppedEvents(0), truncatedEvents(0), deliveredEvents(0), batches(0), started(false) {}
+
+    // Takes ownership of the sink. Add sinks before start().
+    void addSink(ChangeSink* sink) {
+        sinks.push_back(sink);
+    }
+
+    // capacity is rounded up to a power of two
+    void start(int capacity) {
+        int size = 1;
+        while (size < capacity) size <<= 1;
+        ring = new ChangeRing(size);
+        stopping = false;
+        nextSeq = 0;
+        droppedEvents = 0;
+        truncatedEvents = 0;
+        deliveredEvents = 0;
+        batches = 0;
+        started = true;
+        worker = thread(&ChangeFeed::run, this);
+    }
+
+    // Delivers whatever is still in the ring, then closes the sinks
+    void stop() {
+        if (worker.joinable()) {
+            stopping.store(true, memory_order_release);
+            worker.join();
+        }
+        ostringstream out;
+        for (size_t s = 0; s < sinks.size(); s++) {
+            sinks[s]->printStats(out);
+            delete sinks[s];
+        }
+        sinkStats = out.str();
+        sinks.clear();
+        delete ring;
+        ring = NULL;
+    }
+
+    void publish(ChangeKind kind, const string& matricNo, const string& courseCode, int credit) {
+        ChangeEvent event;
+        event.seq = nextSeq.fetch_add(1, memory_order_relaxed) + 1;
+        event.timeUs = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        event.kind = kind;
+        event.credit = credit;
+        bool matricFits = copyField(event.matricNo, matricNo);
+        bool codeFits = copyField(event.courseCode, courseCode);
+        event.truncated = !matricFits || !codeFits;
+        if (event.truncated) truncatedEvents.fetch_add(1, memory_order_relaxed);
+        if (!ring->push(event)) droppedEvents.fetch_add(1, memory_order_relaxed);
+    }
+
+    long long published() {
+        return nextSeq.load(memory_order_relaxed);
+    }
+
+    long long dropped() {
+        return droppedEvents.load(memory_order_relaxed);
+    }
+
+    long long delivered() {
+        return deliveredEvents.load(memory_order_relaxed);
+    }
+
+    bool wasStarted() {
+        return started;
+    }
+
+    // Call after stop(), when the counts are final
+    void printStats() {
+        cout << "Change feed: " << published() << " published, " << dropped() << " dropped (ring full), "
+             << delivered() << " delivered in " << batches.load(memory_order_relaxed) << " batch(es)\n";
+        long long truncated = truncatedEvents.load(memory_order_relaxed);
+        if (truncated > 0) {
+            cout << "  " << truncated << " event(s) had a matric or course code longer than " << KEY_LENGTH
+                 << " characters, cut short and marked TRUNCATED\n";
+        }
+        cout << sinkStats;
+    }
+
+    ~ChangeFeed() {
+        stop();
+    }
+};
+
+const int CHANGE_RING_EVENTS = 1 << 16;
+ChangeFeed changeFeed;
+bool changeFeedOn = false;
+
+void publishChange(ChangeKind kind, Student* student, const string& courseCode, int credit) {
+    changeFeed.publish(kind, student->profile->matricNo, courseCode, credit);
+}
+
+// Opens the sinks and starts the feed thread. Returns false if a sink cannot be opened.
+bool startChangeFeed(const string& filename, int port, int capacity) {
+    if (!filename.empty()) {
+        FileChangeSink* file = new FileChangeSink();
+        changeFeed.addSink(file);
+        if (!file->open(filename)) {
+            cout << "Cannot open change feed file " << filename << ".\n";
+            return false;
+        }
+    }
+    if (port > 0) {
+#ifdef __linux__
+        SocketChangeSink* subscribers = new SocketChangeSink();
+        changeFeed.addSink(subscribers);
+        if (!subscribers->listen(port)) return false;
+#else
+        cout << "Change feed subscribers need Linux.\n";
+        return false;
+#endif
+    }
+    changeFeed.start(capacity);
+    changeFeedOn = true;
+    return true;
+}
+
+void stopChangeFeed() {
+    if (!changeFeedOn) return;
+    changeFeedOn = false;
+    changeFeed.stop();
+}
+
+int main(int argc, char* argv[]) {
+    // --stats and --trace may accompany any mode; their output is produced on exit
+    bool showStats = false;
+    int lazyLimit = 0;
+    string changeFile = "";
+    int changePort = 0;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--stats") {
+            showStats = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            tracingEnabled = true;
+            traceFileName = argv[++i];
+        } else if (arg == "--trace-sample" && i + 1 < argc) {
+            int every = atoi(argv[++i]);
+            traceSampleEvery = every > 0 ? every : 1;
+        } else if (arg == "--lazy-students") {
+            lazyLimit = i + 1 < argc && isdigit((unsigned char)argv[i + 1][0]) ? atoi(argv[++i]) : 1000;
+        } else if (arg == "--change-feed" && i + 1 < argc) {
+            changeFile = argv[++i];
+        } else if (arg == "--change-feed-port" && i + 1 < argc) {
+            changePort = atoi(argv[++i]);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    // Command-line modes load students their own way, so the pager would never be used
+    if (lazyLimit > 0 && argc > 1) {
+        cout << "--lazy-students works with the console menus only.\n";
+        return 1;
+    }
+
+    // Only modes that change registrations in this process can feed them
+    if (!changeFile.empty() || changePort > 0) {
+        string mode = argc > 1 ? argv[1] : "";
+        if (mode != "" && mode != "--serve" && mode != "--serve-menus" && mode != "--primary" && mode != "--replica" && mode != "--simulate") {
+            cout << "--change-feed works with the console, --serve, --serve-menus, --primary, --replica and --simulate.\n";
+            return 1;
+        }
+        if (!startChangeFeed(changeFile, changePort, CHANGE_RING_EVENTS)) return 1;
+    }
+
+    if (argc > 1) {
+        int code = runCommandLine(argc, argv);
+        stopChangeFeed();
+        if (showStats) printPerformanceStats();
+        if (tracingEnabled) writeTraceFile(traceFileName);
+        return code;
+    }
+
+    if (lazyLimit > 0) studentPager.open("students.txt", lazyLimit);
+    else loadStudents();
+    loadCourses();
+    loadStaff();
+    loadPendingRequests();
+    initCreditTotals();
     
-    if (choice == 'y' || choice == 'Y') {
-        string filename = student->matricNo + "_CourseRegistrationSlip.txt";
-        ofstream file(filename.c_str());
-        
-        file << "========================================\n";
-        file << "      COURSE REGISTRATION SLIP\n";
-        file << "========================================\n";
-        file << "Name: " << student->name << "\n";
-        file << "Matric No: " << student->matricNo << "\n";
-        file << "Program: " << student->program << "\n";
-        file << "Year: " << student->year << "\n";
-        file << "========================================\n";
-        file << "APPROVED COURSES:\n";
+    while (true) {
+        studentPager.trim();
+        printMainMenu();
         
-        CourseNode* current = student->courseList;
-        while (current != NULL) {
-            if (current->status == "Approved") {
-                Course* course = courseTree.search(current->courseCode);
-                if (course != NULL) {
-                    file << course->courseCode << " | " << course->courseName 
-                         << " | " << course->credit << " credit(s)\n";
+        int choice;
+        cin >> choice;
+        cin.ignore();
+        easterEgg();
+        if (choice == 1) {
+            cout << "Enter Matric No: ";
+            string matric;
+            getline(cin, matric);
+            
+            Student* student = studentTree.search(matric);
+            if (student == NULL) {
+                cout << "You are not eligible for course registration.\n";
+            } else {
+                studentPager.pin(student);
+                studentMenu(student);
+                studentPager.unpin(student);
+            }
+        } else if (choice == 2) {
+            cout << "Enter Staff ID: ";
+            string staffID;
+            getline(cin, staffID);
+            
+            Staff* foundStaff = findStaff(staffID);
+            
+            if (foundStaff == NULL) {
+                cout << "Prohibited access.\n";
+            } else {
+                cout << "Welcome " << foundStaff->name << "!\n";
+                staffMenu(foundStaff);
+            }
+        } else if (choice == 3) {
+            saveAllData();
+            stopChangeFeed();
+            if (showStats) printPerformanceStats();
+            if (tracingEnabled) writeTraceFile(traceFileName);
+            cout << "Thank you for using the system!\n";
+            break;
+        } else {
+            cout << "Invalid choice.\n";
+        }
+    }
+    
+    return 0;
+}
+
+void loadStudents(const char* filename) {
+    STAT_SCOPE(OP_LOAD_STUDENTS);
+    TRACE_SPAN(TRACE_LOAD, "students");
+    ifstream file(filename);
+    if (!file) {
+        cout << "Students file not found. Starting with empty student list.\n";
+        return;
+    }
+    
+    vector<Student*> loaded;
+    bool sorted = true;
+    RejectedLines rejected;
+    string line;
+    while (getline(file, line)) {
+        if (recordLine(line).empty()) continue;
+        Student* newStudent = readStudentRecord(file, line, rejected);
+        if (newStudent == NULL) continue;
+        if (!loaded.empty() && !(loaded.back()->profile->matricNo < newStudent->profile->matricNo)) sorted = false;
+        loaded.push_back(newStudent);
+    }
+    
+    // A file written by saveStudents is in matric order; inserting it one by one would build a chain
+    if (sorted && studentTree.getRoot() == NULL) {
+        studentTree.buildBalanced(loaded);
+        for (size_t i = 0; i < loaded.size(); i++) studentIndex.add(loaded[i]);
+    } else {
+        for (size_t i = 0; i < loaded.size(); i++) {
+            studentTree.insert(loaded[i]);
+            if (studentTree.search(loaded[i]->profile->matricNo) == loaded[i]) studentIndex.add(loaded[i]);
+        }
+    }
+    
+    file.close();
+    rejected.keep(filename);
+    cout << "Students loaded successfully.\n";
+}
+
+// Parses a student line and reads its enrollment lines from file. Returns NULL if the student line is malformed.
+Student* readStudentRecord(istream& file, const string& line, RejectedLines& rejected) {
+    StudentRow row;
+    string_view text = recordLine(line);
+    if (!StudentSchema::parse(text, row) || !text.empty() || row.courses < 0) {
+        rejected.add(line);
+        return NULL;
+    }
+    Student* student = new Student(string(row.name), string(row.matricNo), row.maxCredit, row.currentCredit, row.year, string(row.program));
+    string courseLine;
+    for (int i = 0; i < row.courses && getline(file, courseLine); i++) {
+        EnrollmentRow course;
+        string_view courseText = recordLine(courseLine);
+        if (EnrollmentSchema::parse(courseText, course) && courseText.empty()) {
+            addCourseToStudent(student, string(course.courseCode), string(course.status));
+        } else {
+            rejected.add(courseLine);
+        }
+    }
+    return student;
+}
+
+void loadCourses(const char* filename) {
+    STAT_SCOPE(OP_LOAD_COURSES);
+    TRACE_SPAN(TRACE_LOAD, "courses");
+    ifstream file(filename);
+    if (!file) {
+        cout << "Courses file not found. Starting with empty course list.\n";
+        return;
+    }
+    
+    vector<Course*> loaded;
+    bool sorted = true;
+    RejectedLines rejected;
+    string line, studentLine;
+    while (getline(file, line)) {
+        string_view text = recordLine(line);
+        if (text.empty()) continue;
+        
+        CourseRow row;
+        if (!CourseSchema::parse(text, row) || !text.empty() || row.students < 0) {
+            rejected.add(line);
+            continue;
+        }
+        Course* newCourse = new Course(string(row.courseCode), string(row.courseName), string(row.lecturerName),
+                                       row.credit, row.capacity, row.seatsTaken);
+        
+        // Read students from following lines
+        for (int i = 0; i < row.students && getline(file, studentLine); i++) {
+            RosterRow student;
+            string_view studentText = recordLine(studentLine);
+            if (RosterSchema::parse(studentText, student) && studentText.empty()) {
+                insertStudentInCourseList(newCourse, string(student.matricNo), string(student.name));
+            } else {
+                rejected.add(studentLine);
+            }
+        }
+        
+        if (!loaded.empty() && !(loaded.back()->details->courseCode < newCourse->details->courseCode)) sorted = false;
+        loaded.push_back(newCourse);
+    }
+    
+    // A file written by saveCourses is in code order; inserting it one by one would build a chain
+    if (sorted && courseTree.getRoot() == NULL) {
+        courseTree.buildBalanced(loaded);
+        for (size_t i = 0; i < loaded.size(); i++) courseIndex.add(loaded[i]);
+    } else {
+        for (size_t i = 0; i < loaded.size(); i++) {
+            courseTree.insert(loaded[i]);
+            if (courseTree.search(loaded[i]->details->courseCode) == loaded[i]) courseIndex.add(loaded[i]);
+        }
+    }
+    courseCatalog.publish(courseTree);
+    
+    file.close();
+    rejected.keep(filename);
+    cout << "Courses loaded successfully.\n";
+}
+
+void loadStaff() {
+    ifstream file("staff.txt");
+    if (!file) {
+        cout << "Staff file not found.\n";
+        return;
+    }
+    
+    int malformed = 0;
+    string line;
+    while (getline(file, line)) {
+        string_view text = recordLine(line);
+        if (text.empty()) continue;
+        
+        StaffRow row;
+        if (!StaffSchema::parse(text, row) || !text.empty()) {
+            malformed++;
+            continue;
+        }
+        Staff newStaff;
+        newStaff.name = string(row.name);
+        newStaff.staffID = string(row.staffID);
+        staffList.push_back(newStaff);
+    }
+    
+    file.close();
+    if (malformed > 0) cout << "Skipped " << malformed << " malformed line(s) in staff.txt.\n";
+    cout << "Staff loaded successfully.\n";
+}
+
+// Returns NULL if no staff member has this ID
+Staff* findStaff(const string& staffID) {
+    for (size_t i = 0; i < staffList.size(); i++) {
+        if (staffList[i].staffID == staffID) return &staffList[i];
+    }
+    return NULL;
+}
+
+void loadPendingRequests() {
+    STAT_SCOPE(OP_LOAD_REQUESTS);
+    TRACE_SPAN(TRACE_LOAD, "pending_requests");
+    ifstream file("pending_requests.txt");
+    if (!file) return;
+
+    RejectedLines rejected;
+    string line;
+    while (getline(file, line)) {
+        string_view text = recordLine(line);
+        if (text.empty()) continue;
+
+        RequestRow row;
+        if (!RequestSchema::parse(text, row) || !(text.empty() || text == "+")) {
+            rejected.add(line);
+            continue;
+        }
+        // A trailing "+" field marks another course of the package on the line before
+        if (text == "+" && regQueue.getRear() != NULL) {
+            regQueue.extendRear(string(row.courseCode), string(row.courseName), row.credit);
+            continue;
+        }
+        regQueue.enqueue(string(row.matricNo), string(row.studentName), string(row.courseCode), string(row.courseName), row.credit);
+        regQueue.getRear()->timestamp = row.timestamp;
+    }
+
+    file.close();
+    rejected.keep("pending_requests.txt");
+}
+
+void saveStudentRecords(Student* root, ofstream& file) {
+    string buffer;
+    TreeCursor<Student> cursor(root);
+    while (cursor.hasNext()) {
+        writeStudentRecord(cursor.next(), buffer);
+        if (buffer.size() >= 65536) {
+            file << buffer;
+            buffer.clear();
+        }
+    }
+    file << buffer;
+}
+
+// Appends the record to out. keepOrder writes the courses last to first, so reading the record back
+// (which prepends each course) rebuilds courseList in the same order.
+void writeStudentRecord(Student* node, string& out, bool keepOrder) {
+    StudentRow row = { node->profile->name, node->profile->matricNo, node->maxCredit, node->currentCredit,
+                       node->profile->year, node->profile->program, countStudentCourses(node) };
+    StudentSchema::format(row, out);
+    out += '\n';
+
+    auto writeCourse = [&out](CourseNode* course) {
+        EnrollmentRow enrollment = { course->courseCode, course->status };
+        EnrollmentSchema::format(enrollment, out);
+        out += '\n';
+    };
+    if (!keepOrder) {
+        for (CourseNode* current = node->courseList; current != NULL; current = current->next) writeCourse(current);
+        return;
+    }
+    vector<CourseNode*> courses;
+    for (CourseNode* current = node->courseList; current != NULL; current = current->next) courses.push_back(current);
+    for (int i = (int)courses.size() - 1; i >= 0; i--) writeCourse(courses[i]);
+}
+
+void saveCourseRecords(Course* root, ofstream& file) {
+    string buffer;
+    TreeCursor<Course> cursor(root);
+    while (cursor.hasNext()) {
+        Course* node = cursor.next();
+        
+        // Count students in list
+        int count = 0;
+        StudentNode* temp = node->studentList;
+        while (temp != NULL) {
+            count++;
+            temp = temp->next;
+        }
+        
+        CourseRow row = { node->details->courseCode, node->details->courseName, node->details->lecturerName,
+                          node->credit, node->capacity, node->currentCapacity.load(), count };
+        CourseSchema::format(row, buffer);
+        buffer += '\n';
+        
+        // Write student list
+        for (temp = node->studentList; temp != NULL; temp = temp->next) {
+            RosterRow student = { temp->matricNo, temp->name };
+            RosterSchema::format(student, buffer);
+            buffer += '\n';
+        }
+        if (buffer.size() >= 65536) {
+            file << buffer;
+            buffer.clear();
+        }
+    }
+    file << buffer;
+}
+
+void saveStudents(const char* filename) {
+    STAT_SCOPE(OP_SAVE_STUDENTS);
+    TRACE_SPAN(TRACE_SAVE, "students");
+    if (lazyStudents) {
+        if (!studentPager.save(filename)) cout << "Error saving students.\n";
+        return;
+    }
+    ofstream file(filename);
+    if (!file) {
+        cout << "Error saving students.\n";
+        return;
+    }
+    
+    Student* root = studentTree.getRoot();
+    saveStudentRecords(root, file);
+    file.close();
+}
+
+void saveCourses(const char* filename) {
+    STAT_SCOPE(OP_SAVE_COURSES);
+    TRACE_SPAN(TRACE_SAVE, "courses");
+    ofstream file(filename);
+    if (!file) {
+        cout << "Error saving courses.\n";
+        return;
+    }
+    
+    Course* root = courseTree.getRoot();
+    saveCourseRecords(root, file);
+    file.close();
+}
+
+void savePendingRequests() {
+    STAT_SCOPE(OP_SAVE_REQUESTS);
+    TRACE_SPAN(TRACE_SAVE, "pending_requests");
+    ofstream file("pending_requests.txt");
+    if (!file) {
+        cout << "Error saving pending requests.\n";
+        return;
+    }
+    
+    string buffer;
+    RegistrationRequest* temp = regQueue.getFront();
+    while (temp != NULL) {
+        if (!temp->isCancelled) {
+            for (RegistrationRequest* member = temp; member != NULL; member = member->package) {
+                RequestRow row = { member->matricNo, member->studentName, member->courseCode, member->courseName,
+                                   member->credit, (long long)member->timestamp };
+                RequestSchema::format(row, buffer);
+                buffer += member == temp ? "\n" : "\t+\n";
+            }
+            if (buffer.size() >= 65536) {
+                file << buffer;
+                buffer.clear();
+            }
+        }
+        temp = temp->next;
+    }
+    file << buffer;
+    
+    file.close();
+}
+
+void saveAllData() {
+    TRACE_SPAN(TRACE_SAVE, "all");
+    cout << "\nSaving all data...\n";
+    saveStudents();
+    saveCourses();
+    savePendingRequests();
+    cout << "All data saved successfully.\n";
+}
+
+void markRequestAsCancelled(string matric, string courseCode) {
+    STAT_SCOPE(OP_CANCEL_REQUEST);
+    RegistrationRequest* entry = regQueue.findPending(matric, courseCode);
+    if (entry != NULL) regQueue.cancelCourse(entry->owner, PackedKey(courseCode), courseCode);
+}
+
+// Approves a request taken from the front of the queue.
+// Returns false if the student no longer holds the course, or if the course is full,
+// in which case the request is auto-rejected and the student is notified.
+bool approveRequest(RegistrationRequest* req, Student* student, Course* course) {
+    TRACE_SPAN(TRACE_APPROVE, "");
+    if (opLogging) logOp("APPROVE\t" + req->matricNo + "\t" + req->courseCode);
+    if (req->package != NULL) return approvePackage(req, student);
+    CourseNode* courseNode = findCourseInStudent(student, req->courseKey, req->courseCode);
+    if (courseNode == NULL) return false;
+
+    if (course->currentCapacity >= course->capacity) {
+        adjustStudentCredit(student, -req->credit, 0);
+        removeCourseFromStudent(student, req->courseCode);
+        if (changeFeedOn) publishChange(CHANGE_REJECTED, student, req->courseCode, req->credit);
+        string notifMsg = req->courseCode + " " + req->courseName + " auto-rejected (course full) at " + getCurrentTimestamp();
+        student->profile->notifications.push(notifMsg);
+        return false;
+    }
+
+    courseNode->status = "Approved";
+    adjustStudentCredit(student, -req->credit, req->credit);
+    course->currentCapacity++;
+    insertStudentInCourseList(course, student->profile->matricNo, student->profile->name);
+    if (changeFeedOn) publishChange(CHANGE_APPROVED, student, req->courseCode, req->credit);
+    string notifMsg = req->courseCode + " " + req->courseName +
+                    " approved at " + getCurrentTimestamp();
+    student->profile->notifications.push(notifMsg);
+    return true;
+}
+
+// Rejects a request taken from the front of the queue and releases its pending credit.
+bool rejectRequest(RegistrationRequest* req, Student* student, string reason) {
+    TRACE_SPAN(TRACE_REJECT, "");
+    if (opLogging) logOp("REJECT\t" + req->matricNo + "\t" + req->courseCode + "\t" + reason);
+    if (req->package != NULL) {
+        if (releasePackage(req, student) == 0) return false;
+        student->profile->notifications.push("Package " + req->allCodes() + " rejected at " + getCurrentTimestamp() + ". Reason: " + reason);
+        return true;
+    }
+    if (findCourseInStudent(student, req->courseKey, req->courseCode) == NULL) return false;
+
+    adjustStudentCredit(student, -req->credit, 0);
+    removeCourseFromStudent(student, req->courseCode);
+    if (changeFeedOn) publishChange(CHANGE_REJECTED, student, req->courseCode, req->credit);
+    string notifMsg = req->courseCode + " " + req->courseName +
+                    " rejected at " + getCurrentTimestamp() +
+                    ". Reason: " + reason;
+    student->profile->notifications.push(notifMsg);
+    return true;
+}
+
+// Takes one seat in each of the n courses, or none. Every seat is claimed with a compare-and-swap
+// on the course's seat count and the seats already claimed are handed back if a later course is
+// full, so concurrent packages over the same courses never wait on a lock.
+// Returns the index of the full course, or -1 once every seat is taken.
+int takeSeats(Course* const* courses, int n) {
+    for (int i = 0; i < n; i++) {
+        int taken = courses[i]->currentCapacity.load();
+        do {
+            if (taken >= courses[i]->capacity) {
+                releaseSeats(courses, i);
+                return i;
+            }
+        } while (!courses[i]->currentCapacity.compare_exchange_weak(taken, taken + 1));
+    }
+    return -1;
+}
+
+void releaseSeats(Course* const* courses, int n) {
+    for (int i = 0; i < n; i++) courses[i]->currentCapacity--;
+}
+
+// Approves every course of a package or none of them. If a course is full or no longer offered,
+// the whole package is auto-rejected. Courses staff have since retracted are left out.
+bool approvePackage(RegistrationRequest* req, Student* student) {
+    vector<RegistrationRequest*> members;
+    vector<CourseNode*> nodes;
+    vector<Course*> courses;
+    string missing;
+    for (RegistrationRequest* member = req; member != NULL; member = member->package) {
+        CourseNode* courseNode = findCourseInStudent(student, member->courseKey, member->courseCode);
+        if (courseNode == NULL) continue;
+        Course* course = courseTree.search(member->courseCode);
+        if (course == NULL) missing = member->courseCode;
+        members.push_back(member);
+        nodes.push_back(courseNode);
+        courses.push_back(course);
+    }
+    if (members.empty()) return false;
+
+    int full = missing.empty() ? takeSeats(courses.data(), courses.size()) : -1;
+    if (!missing.empty() || full >= 0) {
+        string reason = missing.empty() ? courses[full]->details->courseCode + " is full" : missing + " is no longer offered";
+        releasePackage(req, student);
+        student->profile->notifications.push("Package " + req->allCodes() + " auto-rejected (" + reason + ") at " + getCurrentTimestamp());
+        return false;
+    }
+
+    int credits = 0;
+    for (size_t i = 0; i < members.size(); i++) {
+        nodes[i]->status = "Approved";
+        insertStudentInCourseList(courses[i], student->profile->matricNo, student->profile->name);
+        credits += members[i]->credit;
+        if (changeFeedOn) publishChange(CHANGE_APPROVED, student, members[i]->courseCode, members[i]->credit);
+    }
+    adjustStudentCredit(student, -credits, credits);
+    student->profile->notifications.push("Package " + req->allCodes() + " approved at " + getCurrentTimestamp());
+    return true;
+}
+
+// Drops every course of a package the student still holds and releases their pending credit.
+// Returns the number of courses dropped.
+int releasePackage(RegistrationRequest* req, Student* student) {
+    int credits = 0, count = 0;
+    for (RegistrationRequest* member = req; member != NULL; member = member->package) {
+        if (findCourseInStudent(student, member->courseKey, member->courseCode) == NULL) continue;
+        removeCourseFromStudent(student, member->courseCode);
+        credits += member->credit;
+        count++;
+        if (changeFeedOn) publishChange(CHANGE_REJECTED, student, member->courseCode, member->credit);
+    }
+    adjustStudentCredit(student, -credits, 0);
+    return count;
+}
+
+void studentMenu(Student* student) {
+    while (true) {
+        studentPager.trim();
+        printStudentMenu(student);
+        
+        int choice;
+        cin >> choice;
+        cin.ignore();
+        
+        switch (choice) {
+            case 1: viewAllCourses(); break;
+            case 2: searchCourse(); break;
+            case 3: registerCourse(student); break;
+            case 4: viewRegisteredCourses(student); break;
+            case 5: deleteCourse(student); break;
+            case 6: viewNotifications(student); break;
+            case 7: viewRegistrationSlip(student); break;
+            case 8: viewStudentsInCourse(student); break;
+            case 9: saveAllData(); return;
+            default: cout << "Invalid choice.\n";
+        }
+    }
+}
+
+void printMainMenu() {
+    cout << "\n========================================\n";
+    cout << "   COURSE REGISTRATION SYSTEM\n";
+    cout << "========================================\n";
+    cout << "1. Student\n";
+    cout << "2. Staff\n";
+    cout << "3. Exit\n";
+    cout << "Select role: ";
+}
+
+void printStudentMenu(Student* student) {
+    cout << "\n========================================\n";
+    cout << "   STUDENT MENU\n";
+    cout << "========================================\n";
+    cout << "Name: " << student->profile->name << "\n";
+    cout << "Matric No: " << student->profile->matricNo << "\n";
+    cout << "Program: " << student->profile->program << " (Year " << student->profile->year << ")\n";
+    cout << "Credits: " << student->currentCredit << "/" << student->maxCredit << "\n";
+    cout << "========================================\n";
+    cout << "1. View All Courses\n";
+    cout << "2. Search Course\n";
+    cout << "3. Register Course\n";
+    cout << "4. View Registered Courses\n";
+    cout << "5. Delete Course\n";
+    cout << "6. View Notifications\n";
+    cout << "7. View Registration Slip\n";
+    cout << "8. View Students in Course\n";
+    cout << "9. Back to Main Menu\n";
+    cout << "Choice: ";
+}
+
+void staffMenu(Staff* staff) {
+    while (true) {
+        studentPager.trim();
+        printStaffMenu();
+        
+        int choice;
+        cin >> choice;
+        cin.ignore();
+        
+        switch (choice) {
+            case 1: staffViewRequests(); break;
+            case 2: staffViewAllStudents(); break;
+            case 3: staffSearchStudent(); break;
+            case 4: staffInsertStudent(); break;
+            case 5: staffUpdateCourse(); break;
+            case 6: staffInsertCourse(); break;
+            case 7: staffDeleteCourse(); break;
+            case 8: staffViewStudentListInCourse(); break;
+            case 9: staffViewAllCourses(); break;
+            case 10: staffRetractCourse(); break;
+            case 11: staffInsertCourseForStudent(); break;
+            case 12: staffBatchAllocate(); break;
+            case 13: staffFilterStudents(); break;
+            case 14: printPerformanceStats(); break;
+            case 15: staffWriteTrace(); break;
+            case 16: staffBulkExport(); break;
+            case 17: staffBlockRegister(); break;
+            case 18: staffProcessCourseRequests(); break;
+            case 19: staffAnalytics(); break;
+            case 20: saveAllData(); return;
+            default: cout << "Invalid choice.\n";
+        }
+    }
+}
+
+void printStaffMenu() {
+    cout << "\n========================================\n";
+    cout << "   STAFF MENU\n";
+    cout << "========================================\n";
+    cout << "1. View All Student Requests\n";
+    cout << "2. View All Students\n";
+    cout << "3. Search Student\n";
+    cout << "4. Insert Student\n";
+    cout << "5. Update Course Details\n";
+    cout << "6. Insert New Course\n";
+    cout << "7. Delete Course\n";
+    cout << "8. View Student List in Course\n";
+    cout << "9. View All Courses\n";
+    cout << "10. Retract Course from Student\n";
+    cout << "11. Insert Course for Student\n";
+    cout << "12. Batch Seat Allocation\n";
+    cout << "13. Filter Students by Program/Year/Credits\n";
+    cout << "14. Performance Statistics\n";
+    cout << "15. Write Trace File\n";
+    cout << "16. Bulk Export Slips and Course Lists\n";
+    cout << "17. Block Register Cohort\n";
+    cout << "18. Process Requests for a Course\n";
+    cout << "19. Analytics Queries\n";
+    cout << "20. Back to Main Menu\n";
+    cout << "Choice: ";
+}
+
+// Asks how to continue a paged listing. Returns the key to resume from, or "" to stop.
+string askNextPage(const string& nextKey) {
+    if (nextKey.empty()) return "";
+    cout << PAGE_PROMPT;
+    string input;
+    getline(cin, input);
+    return nextPageKey(nextKey, input);
+}
+
+string nextPageKey(const string& nextKey, const string& input) {
+    if (input == "q" || input == "Q") return "";
+    return input.empty() ? nextKey : input;
+}
+
+void viewAllCourses() {
+    if (CatalogRead()->entries.empty()) {
+        cout << "No courses available.\n";
+        return;
+    }
+    cout << "\n=== All Courses ===\n";
+    string key = "";
+    do {
+        key = askNextPage(displayCatalogPage(key, LIST_PAGE_SIZE));
+    } while (!key.empty());
+}
+
+// Prints up to pageSize courses from the catalog starting at the first code >= fromKey.
+// Returns the code to resume from, or "" when the listing is complete.
+string displayCatalogPage(const string& fromKey, int pageSize) {
+    CatalogRead catalog;
+    OutputBuffer out(cout);
+    size_t i = catalog->lowerBound(fromKey);
+    for (int shown = 0; shown < pageSize && i < catalog->entries.size(); shown++, i++) {
+        const CatalogEntry* entry = catalog->entries[i];
+        out << entry->courseCode << " | " << entry->courseName << " | "
+            << entry->credit << " credit(s) | " << entry->seatsTaken()
+            << "/" << entry->capacity << " students\n";
+    }
+    return i < catalog->entries.size() ? catalog->entries[i]->courseCode : "";
+}
+
+void printCourseLine(Course* course) {
+    cout << course->details->courseCode << " | " << course->details->courseName << " | "
+         << course->credit << " credit(s) | " << course->currentCapacity
+         << "/" << course->capacity << " students\n";
+}
+
+void searchCourse() {
+    cout << "Enter Course Code, Name or Lecturer: ";
+    string query;
+    getline(cin, query);
+    searchCourseQuery(query);
+}
+
+void searchCourseQuery(const string& query) {
+    {
+        CatalogRead catalog;
+        const CatalogEntry* course = catalog->find(query);
+        if (course != NULL) {
+            cout << "\n=== Course Details ===\n";
+            cout << "Code: " << course->courseCode << "\n";
+            cout << "Name: " << course->courseName << "\n";
+            cout << "Credit: " << course->credit << "\n";
+            cout << "Students: " << course->seatsTaken() << "/" << course->capacity << "\n";
+            return;
+        }
+    }
+
+    vector<Course*> results = courseIndex.searchPrefix(query, 20);
+    if (results.empty()) results = courseIndex.searchSubstring(query, 20);
+    if (!results.empty()) {
+        cout << "\n=== Matching Courses ===\n";
+        for (size_t i = 0; i < results.size(); i++) printCourseLine(results[i]);
+        return;
+    }
+
+    results = courseIndex.searchFuzzy(query, 10);
+    if (results.empty()) {
+        cout << "Course not found.\n";
+    } else {
+        cout << "\n=== Did you mean ===\n";
+        for (size_t i = 0; i < results.size(); i++) printCourseLine(results[i]);
+    }
+}
+
+void registerCourse(Student* student) {
+    cout << "Enter Course Code (or several, separated by spaces, to register all or none): ";
+    string code;
+    getline(cin, code);
+    registerCourseCode(student, code);
+}
+
+void registerCourseCode(Student* student, const string& code) {
+    TRACE_SPAN(TRACE_REGISTER, "");
+    vector<string> codes = splitCodes(code);
+    if (codes.size() > 1) {
+        registerPackageCodes(student, codes);
+        return;
+    }
+    Course* course = courseTree.search(code);
+    if (course == NULL) {
+        cout << "Course not found.\n";
+        return;
+    }
+    
+    RegisterResult result = submitRegistration(student, course);
+    if (result == REGISTER_DUPLICATE) {
+        cout << "You have already registered for this course.\n";
+    } else if (result == REGISTER_OVER_CREDIT) {
+        cout << "Registration failed: Exceeds maximum credit limit.\n";
+    } else if (result == REGISTER_FULL) {
+        cout << "Course is already full.\n";
+    } else {
+        cout << "Registration request submitted successfully (Status: Pending).\n";
+    }
+}
+
+// Registers several courses as one package: either all of them are queued or none is
+void registerPackageCodes(Student* student, const vector<string>& codes) {
+    vector<Course*> courses;
+    for (size_t i = 0; i < codes.size(); i++) {
+        Course* course = courseTree.search(codes[i]);
+        if (course == NULL) {
+            cout << "Course not found: " << codes[i] << ". No course was registered.\n";
+            return;
+        }
+        courses.push_back(course);
+    }
+
+    int failed;
+    RegisterResult result = submitPackage(student, courses, failed);
+    if (result == REGISTER_OK) {
+        cout << "Package of " << courses.size() << " courses submitted as one request (Status: Pending).\n";
+        return;
+    }
+    string code = courses[failed]->details->courseCode;
+    if (result == REGISTER_DUPLICATE) {
+        cout << "You have already registered for " << code << ", or listed it twice.";
+    } else if (result == REGISTER_OVER_CREDIT) {
+        cout << "Registration failed: Exceeds maximum credit limit at " << code << ".";
+    } else {
+        cout << code << " is already full.";
+    }
+    cout << " No course was registered.\n";
+}
+
+// Splits a line of course codes separated by spaces or commas
+vector<string> splitCodes(const string& text) {
+    vector<string> codes;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find_first_of(" ,\t", start);
+        if (end == string::npos) end = text.size();
+        if (end > start) codes.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return codes;
+}
+
+// Checks a registration and, if allowed, queues it as a pending request
+RegisterResult submitRegistration(Student* student, Course* course) {
+    RegisterResult result = checkRegistration(student, course);
+    if (result != REGISTER_OK) return result;
+    queueRegistration(student, course);
+    return REGISTER_OK;
+}
+
+// Queues a request that has passed its checks and counts its credits as pending
+void queueRegistration(Student* student, Course* course) {
+    regQueue.enqueue(student->profile->matricNo, student->profile->name, course->details->courseCode,
+                     course->details->courseName, course->credit);
+    addCourseToStudent(student, course->details->courseCode, "Pending");
+    adjustStudentCredit(student, course->credit, 0);
+    if (opLogging) logOp("REGISTER\t" + student->profile->matricNo + "\t" + course->details->courseCode);
+    if (changeFeedOn) publishChange(CHANGE_REGISTERED, student, course->details->courseCode, course->credit);
+}
+
+// Checks every course of a package with the credits of the ones before it counted, and only if all
+// of them pass queues the package as one request. Otherwise failed is the index of the first course
+// that did not pass and nothing has changed.
+RegisterResult submitPackage(Student* student, const vector<Course*>& courses, int& failed) {
+    int credits = 0;
+    for (failed = 0; failed < (int)courses.size(); failed++) {
+        Course* course = courses[failed];
+        for (int i = 0; i < failed; i++) {
+            if (courses[i] == course) return REGISTER_DUPLICATE;
+        }
+        RegisterResult result = checkRegistration(student, course);
+        if (result != REGISTER_OK) return result;
+        credits += course->credit;
+        if (student->currentCredit + credits > student->maxCredit) return REGISTER_OVER_CREDIT;
+    }
+    failed = -1;
+
+    string op = "REGISTER\t" + student->profile->matricNo;
+    for (size_t i = 0; i < courses.size(); i++) {
+        if (opLogging) op += "\t" + courses[i]->details->courseCode;
+        if (i == 0) regQueue.enqueue(student->profile->matricNo, student->profile->name, courses[i]->details->courseCode,
+                                     courses[i]->details->courseName, courses[i]->credit);
+        else regQueue.extendRear(courses[i]->details->courseCode, courses[i]->details->courseName, courses[i]->credit);
+        addCourseToStudent(student, courses[i]->details->courseCode, "Pending");
+        if (changeFeedOn) publishChange(CHANGE_REGISTERED, student, courses[i]->details->courseCode, courses[i]->credit);
+    }
+    adjustStudentCredit(student, credits, 0);
+    if (opLogging) logOp(op);
+    return REGISTER_OK;
+}
+
+// The admission checks, without queuing anything
+RegisterResult checkRegistration(Student* student, Course* course) {
+    if (findCourseInStudent(student, course->codeKey, course->details->courseCode) != NULL) return REGISTER_DUPLICATE;
+    if (student->currentCredit + course->credit > student->maxCredit) return REGISTER_OVER_CREDIT;
+    if (course->currentCapacity >= course->capacity) return REGISTER_FULL;
+    return REGISTER_OK;
+}
+
+void viewRegisteredCourses(Student* student) {
+    if (student->courseList == NULL) {
+        cout << "No courses registered.\n";
+        return;
+    }
+    
+    cout << "\n=== Registered Courses ===\n";
+    CatalogRead catalog;
+    int count = 1;
+    CourseNode* current = student->courseList;
+    while (current != NULL) {
+        const CatalogEntry* course = catalog->find(current->courseCode);
+        if (course != NULL) {
+            cout << count++ << ". " << course->courseCode << " - " 
+                 << course->courseName << " (" << course->credit 
+                 << " credits) [" << current->status;
+            RegistrationRequest* entry = current->status == "Pending" ? regQueue.findPending(student->profile->matricNo, current->courseCode) : NULL;
+            if (entry != NULL) {
+                cout << ": #" << regQueue.positionOf(entry) << " of " << regQueue.getLiveCount() << " in queue, #"
+                     << regQueue.positionInCourse(entry) << " of " << regQueue.getPendingFor(current->courseCode) << " for this course";
+            }
+            cout << "]\n";
+        }
+        current = current->next;
+    }
+}
+
+void deleteCourse(Student* student) {
+    viewRegisteredCourses(student);
+    
+    if (student->courseList == NULL) return;
+    
+    cout << "Enter Course Code to delete: ";
+    string code;
+    getline(cin, code);
+    deleteCourseCode(student, code);
+}
+
+void deleteCourseCode(Student* student, const string& code) {
+    TRACE_SPAN(TRACE_DROP, "");
+    CourseNode* courseNode = findCourseInStudent(student, code);
+    if (courseNode == NULL) {
+        cout << "Course not found in your registered courses.\n";
+        return;
+    }
+    
+    dropRegisteredCourse(student, courseNode, courseTree.search(code), NULL);
+    cout << "Course deleted successfully.\n";
+}
+
+// Drops a course the student holds: a pending request is cancelled in the queue, an approved seat is released.
+// Callers that already hold the pending request pass it as req to skip the queue scan.
+void dropRegisteredCourse(Student* student, CourseNode* courseNode, Course* course, RegistrationRequest* req) {
+    string code = courseNode->courseCode;
+    if (opLogging) logOp("DROP\t" + student->profile->matricNo + "\t" + code);
+    if (changeFeedOn) publishChange(CHANGE_DROPPED, student, code, course != NULL ? course->credit : 0);
+    if (course != NULL) {
+        if (courseNode->status == "Pending") {
+            adjustStudentCredit(student, -course->credit, 0);
+            if (req != NULL) regQueue.cancelCourse(req, courseNode->key, code);
+            else markRequestAsCancelled(student->profile->matricNo, code);
+        } else {
+            adjustStudentCredit(student, 0, -course->credit);
+            course->currentCapacity--;
+            removeStudentFromCourseList(course, student->profile->matricNo);
+        }
+    }
+    removeCourseFromStudent(student, code);
+}
+
+void viewNotifications(Student* student) {
+    while (showLatestNotification(student)) {
+        int choice;
+        cin >> choice;
+        cin.ignore();
+        if (!applyNotificationChoice(student, choice)) return;
+    }
+}
+
+// Prints the newest notification and the choices for it. Returns false if there are none.
+bool showLatestNotification(Student* student) {
+    if (student->profile->notifications.isEmpty()) {
+        cout << "No notifications.\n";
+        return false;
+    }
+    
+    Notification* notif = student->profile->notifications.getTop();
+    cout << "\n=== Latest Notification ===\n";
+    cout << notif->message << "\n";
+    cout << "Time: " << getCurrentTimestamp(notif->timestamp) << "\n";
+    
+    cout << "\n1. Mark as Unread (Stop)\n";
+    cout << "2. Mark as Read (Next)\n";
+    cout << "3. Mark All as Read\n";
+    cout << "Choice: ";
+    return true;
+}
+
+// Returns true to show the next notification
+bool applyNotificationChoice(Student* student, int choice) {
+    if (choice == 1) {
+        return false;
+    } else if (choice == 2) {
+        student->profile->notifications.pop();
+    } else if (choice == 3) {
+        student->profile->notifications.clear();
+        cout << "All notifications marked as read.\n";
+        return false;
+    }
+    return true;
+}
+
+// Renders the slip once; the same text is shown on screen and written to the download file
+string renderRegistrationSlip(Student* student) {
+    string slip;
+    slip.reserve(512);
+    appendRegistrationSlip(slip, student);
+    return slip;
+}
+
+// Appends the slip text to out; safe to call from several threads while the student tree is not being modified
+void appendRegistrationSlip(string& slip, Student* student) {
+    slip += "========================================\n";
+    slip += "      COURSE REGISTRATION SLIP\n";
+    slip += "========================================\n";
+    slip += "Name: " + student->profile->name + "\n";
+    slip += "Matric No: " + student->profile->matricNo + "\n";
+    slip += "Program: " + student->profile->program + "\n";
+    slip += "Year: " + to_string(student->profile->year) + "\n";
+    slip += "========================================\n";
+    slip += "APPROVED COURSES:\n";
+
+    CatalogRead catalog;
+    bool hasApproved = false;
+    for (CourseNode* current = student->courseList; current != NULL; current = current->next) {
+        if (current->status != "Approved") continue;
+        const CatalogEntry* course = catalog->find(current->courseCode);
+        if (course != NULL) {
+            slip += course->courseCode + " | " + course->courseName + " | " + to_string(course->credit) + " credit(s)\n";
+            hasApproved = true;
+        }
+    }
+
+    if (!hasApproved) {
+        slip += "No approved courses yet.\n";
+    }
+    slip += "========================================\n";
+    slip += "Total Approved Credits: " + to_string(student->approvedCredit) + "/" + to_string(student->maxCredit) + "\n";
+}
+
+// Appends the downloadable student list of a course to out
+void appendCourseRoster(string& out, Course* course) {
+    out += "=== Students in " + course->details->courseCode + " - " + course->details->courseName + " ===\n\n";
+    int count = 1;
+    for (StudentNode* temp = course->studentList; temp != NULL; temp = temp->next) {
+        out += to_string(count++) + ". " + temp->name + " (" + temp->matricNo + ")\n";
+    }
+}
+
+void viewRegistrationSlip(Student* student) {
+    string slip = renderRegistrationSlip(student);
+    cout << "\n" << slip;
+    
+    cout << "\nDownload slip? (y/n): ";
+    char choice;
+    cin >> choice;
+    cin.ignore();
+    
+    if (choice == 'y' || choice == 'Y') {
+        downloadRegistrationSlip(student, slip);
+    }
+}
+
+void downloadRegistrationSlip(Student* student, const string& slip) {
+    string filename = student->profile->matricNo + "_CourseRegistrationSlip.txt";
+    ofstream file(filename.c_str());
+    file << slip;
+    file.close();
+    cout << "Slip downloaded as " << filename << "\n";
+}
+
+void viewStudentsInCourse(Student* student) {
+    cout << "Enter Course Code: ";
+    string code;
+    getline(cin, code);
+    viewStudentsInCourseCode(student, code);
+}
+
+void viewStudentsInCourseCode(Student* student, const string& code) {
+    Course* course = courseTree.search(code);
+    if (course == NULL) {
+        cout << "Course not found.\n";
+        return;
+    }
+    
+    bool isApproved = false;
+    CourseNode* current = student->courseList;
+    while (current != NULL) {
+        if (current->courseCode == code && current->status == "Approved") {
+            isApproved = true;
+            break;
+        }
+        current = current->next;
+    }
+    
+    if (!isApproved) {
+        cout << "You are not approved in this course.\n";
+        return;
+    }
+    
+    cout << "\n=== Students in " << course->details->courseCode << " ===\n";
+    if (course->studentList == NULL) {
+        cout << "No students in this course.\n";
+    } else {
+        StudentNode* temp = course->studentList;
+        int count = 1;
+        while (temp != NULL) {
+            cout << count++ << ". " << temp->name << " (" << temp->matricNo << ")\n";
+            temp = temp->next;
+        }
+    }
+}
+
+void staffViewRequests() {
+    TRACE_SPAN(TRACE_DRAIN, "interactive");
+    if (regQueue.isEmpty()) {
+        cout << "No pending requests.\n";
+        return;
+    }
+    
+    RegistrationRequest* req;
+    while ((req = showNextRequest()) != NULL) {
+        int choice;
+        cin >> choice;
+        cin.ignore();
+        
+        if (choice == 3) return;
+        
+        string reason;
+        if (choice == 2 && requestNeedsReason(req)) {
+            cout << "Enter rejection reason: ";
+            getline(cin, reason);
+        }
+        if (!decideFrontRequest(req, choice, reason)) continue;
+        
+        cout << "\nContinue processing? (y/n): ";
+        char cont;
+        cin >> cont;
+        cin.ignore();
+        
+        if (cont != 'y' && cont != 'Y') return;
+    }
+    
+    cout << "All requests processed.\n";
+}
+
+// Shows the queue and the request at its front with the decision menu, dropping cancelled
+// requests on the way. Returns NULL once the queue is empty.
+RegistrationRequest* showNextRequest() {
+    while (!regQueue.isEmpty()) {
+        cout << "\n=== Pending Requests ===\n";
+        regQueue.display(10);
+        
+        RegistrationRequest* req = regQueue.getFront();
+        
+        if (req->isCancelled) {
+            cout << "\nRequest cancelled by student - skipping...\n";
+            delete regQueue.dequeue();
+            continue;
+        }
+        
+        printRequestChoice(req);
+        return req;
+    }
+    return NULL;
+}
+
+// Shows a request with the decision menu
+void printRequestChoice(RegistrationRequest* req) {
+    cout << "\nProcessing request for " << req->studentName 
+         << " (" << req->matricNo << ")\n";
+    if (req->package == NULL) {
+        cout << "Course: " << req->courseCode << " - " << req->courseName << "\n";
+    } else {
+        cout << "Package (approve all or none):\n";
+        for (RegistrationRequest* member = req; member != NULL; member = member->package) {
+            cout << "  " << member->courseCode << " - " << member->courseName << "\n";
+        }
+    }
+    cout << "1. Approve\n";
+    cout << "2. Reject\n";
+    cout << "3. Stop\n";
+    cout << "Choice: ";
+}
+
+// Decides one course's requests in arrival order, leaving every other request where it is in the queue
+void staffProcessCourseRequests() {
+    TRACE_SPAN(TRACE_DRAIN, "course");
+    cout << "Enter Course Code: ";
+    string code;
+    getline(cin, code);
+    Course* course = courseTree.search(code);
+    if (course == NULL) {
+        cout << "Course not found.\n";
+        return;
+    }
+    code = course->details->courseCode;
+
+    RegistrationRequest* req;
+    while ((req = regQueue.firstFor(code)) != NULL) {
+        cout << "\n=== Pending Requests for " << code << " (" << regQueue.getPendingFor(code) << ") ===\n";
+        regQueue.displayFor(code, 10);
+        printRequestChoice(req);
+
+        int choice;
+        cin >> choice;
+        cin.ignore();
+
+        if (choice == 3) return;
+        if (choice != 1 && choice != 2) {
+            cout << "Invalid choice.\n";
+            continue;
+        }
+
+        string reason;
+        if (choice == 2 && requestNeedsReason(req)) {
+            cout << "Enter rejection reason: ";
+            getline(cin, reason);
+        }
+        bool decided = decideRequest(req, choice, reason);
+        regQueue.remove(req);
+        delete req;
+        if (!decided) continue;
+
+        cout << "\nContinue processing? (y/n): ";
+        char cont;
+        cin >> cont;
+        cin.ignore();
+
+        if (cont != 'y' && cont != 'Y') return;
+    }
+
+    cout << "No pending requests for " << code << ".\n";
+}
+
+// A rejection reason is only asked for when the student and course still exist
+bool requestNeedsReason(RegistrationRequest* req) {
+    return studentTree.search(req->matricNo) != NULL && courseTree.search(req->courseCode) != NULL;
+}
+
+// Applies choice 1 (approve) or 2 (reject) to the front request and removes it from the queue.
+// Returns false if the approval failed because the course is full.
+bool decideFrontRequest(RegistrationRequest* req, int choice, const string& reason) {
+    bool decided = decideRequest(req, choice, reason);
+    delete regQueue.dequeue();
+    return decided;
+}
+
+// Applies choice 1 (approve) or 2 (reject) to a request, leaving it in the queue.
+// Returns false if the approval failed because a course is full.
+bool decideRequest(RegistrationRequest* req, int choice, const string& reason) {
+    Student* student = studentTree.search(req->matricNo);
+    Course* course = courseTree.search(req->courseCode);
+    
+    if (student != NULL && course != NULL) {
+        if (choice == 1) {
+            if (findCourseInStudent(student, req->courseCode) != NULL) {
+                // A package is also refused whole when one of its courses has since been deleted
+                string missing;
+                for (RegistrationRequest* member = req->package; member != NULL; member = member->package) {
+                    if (findCourseInStudent(student, member->courseKey, member->courseCode) != NULL &&
+                        courseTree.search(member->courseCode) == NULL) missing = member->courseCode;
+                }
+                if (!approveRequest(req, student, course)) {
+                    if (req->package == NULL) cout << "Approval failed: Course is full.\n";
+                    else if (!missing.empty()) cout << "Approval failed: " << missing << " is no longer offered.\n";
+                    else cout << "Approval failed: Not every course in the package has a free seat.\n";
+                    return false;
+                }
+                cout << "Request approved.\n";
+            }
+        } else if (choice == 2) {
+            if (rejectRequest(req, student, reason)) {
+                cout << "Request rejected.\n";
+            }
+        }
+    }
+    return true;
+}
+
+void staffViewAllStudents() {
+    if (lazyStudents ? studentPager.empty() : studentTree.getRoot() == NULL) {
+        cout << "No students in system.\n";
+        return;
+    }
+    cout << "\n=== All Students ===\n";
+    string key = "";
+    do {
+        key = askNextPage(lazyStudents ? studentPager.displayPage(key, LIST_PAGE_SIZE) : studentTree.displayPage(key, LIST_PAGE_SIZE));
+    } while (!key.empty());
+}
+
+void staffSearchStudent() {
+    cout << "Enter Matric No: ";
+    string matric;
+    getline(cin, matric);
+    showStudentDetails(matric);
+}
+
+void showStudentDetails(const string& matric) {
+    Student* student = studentTree.search(matric);
+    if (student == NULL) {
+        cout << "Student not found.\n";
+    } else {
+        cout << "\n=== Student Details ===\n";
+        cout << "Name: " << student->profile->name << "\n";
+        cout << "Matric No: " << student->profile->matricNo << "\n";
+        cout << "Program: " << student->profile->program << "\n";
+        cout << "Year: " << student->profile->year << "\n";
+        cout << "Credits: " << student->currentCredit << "/" << student->maxCredit
+             << " (" << student->approvedCredit << " approved, " << student->pendingCredit << " pending)\n";
+        
+        cout << "\n=== Registered Courses ===\n";
+        if (student->courseList == NULL) {
+            cout << "No courses registered.\n";
+        } else {
+            CourseNode* current = student->courseList;
+            while (current != NULL) {
+                Course* course = courseTree.search(current->courseCode);
+                if (course != NULL) {
+                    cout << course->details->courseCode << " - " << course->details->courseName 
+                         << " [" << current->status << "]\n";
+                }
+                current = current->next;
+            }
+        }
+    }
+}
+
+void printStudentLine(Student* student) {
+    cout << student->profile->name << " | " << student->profile->matricNo << " | Year "
+         << student->profile->year << " | " << student->profile->program << " | "
+         << student->currentCredit << "/" << student->maxCredit << " credits\n";
+}
+
+// Lists the programs and reads a choice. Returns "" for any program.
+string selectProgram() {
+    vector<pair<string, int> > programs = studentIndex.programs();
+
+    cout << "\n=== Programs ===\n";
+    for (size_t i = 0; i < programs.size(); i++) {
+        cout << i + 1 << ". " << programs[i].first << " (" << programs[i].second << " students)\n";
+    }
+    cout << "Select Program (0 for any): ";
+    int choice;
+    cin >> choice;
+    return choice >= 1 && choice <= (int)programs.size() ? programs[choice - 1].first : "";
+}
+
+void staffFilterStudents() {
+    if (!allStudentsLoaded()) return;
+    StudentFilter filter;
+    filter.program = selectProgram();
+
+    cout << "Enter Minimum Year (0 for any): ";
+    cin >> filter.minYear;
+    cout << "Enter Maximum Year (0 for any): ";
+    cin >> filter.maxYear;
+    cout << "Enter Minimum Remaining Credits (0 for any): ";
+    cin >> filter.minHeadroom;
+    cin.ignore();
+
+    const int pageSize = 20;
+    int offset = 0;
+    vector<Student*> page;
+    while (true) {
+        int total = studentIndex.query(filter, offset, pageSize, page);
+        if (total == 0) {
+            cout << "No students match the filter.\n";
+            return;
+        }
+
+        cout << "\n=== Students " << offset + 1 << "-" << offset + page.size() << " of " << total << " ===\n";
+        for (size_t i = 0; i < page.size(); i++) printStudentLine(page[i]);
+        if (total <= pageSize) return;
+
+        cout << "\nn. Next Page  p. Previous Page  q. Quit\nChoice: ";
+        string nav;
+        getline(cin, nav);
+        if (nav == "n" || nav == "N") {
+            if (offset + pageSize < total) offset += pageSize;
+        } else if (nav == "p" || nav == "P") {
+            if (offset >= pageSize) offset -= pageSize;
+        } else {
+            return;
+        }
+    }
+}
+
+void staffInsertStudent() {
+    string studentName, matricNo, program;
+    int maxCredit, currentCredit, year;
+    cout << "Enter Student Name: ";
+    getline(cin, studentName);
+    cout << "Enter Matric No: ";
+    getline(cin, matricNo);
+    cout << "Enter Max Credit: ";
+    cin >> maxCredit;
+    cout << "Enter Year: ";
+    cin >> year;
+    cin.ignore();
+    cout << "Enter Program: ";
+    getline(cin, program);
+    currentCredit = 0;
+    Student* newStudent = new Student(studentName, matricNo, maxCredit, currentCredit, year, program);
+    
+    // cannot insert duplicate matric no
+    if (studentTree.search(newStudent->profile->matricNo) != NULL) {
+        cout << "Student with this Matric No already exists.\n";
+        delete newStudent;
+        return;
+    }
+    studentTree.insert(newStudent);
+    studentIndex.add(newStudent);
+    if (lazyStudents) studentPager.adopt(newStudent);
+    cout << "Student inserted successfully.\n";
+}
+
+void staffUpdateCourse() {
+    cout << "Enter Course Code: ";
+    string code;
+    getline(cin, code);
+    
+    Course* course = courseTree.search(code);
+    if (course == NULL) {
+        cout << "Course not found.\n";
+        return;
+    }
+    
+    cout << "\nCurrent Details:\n";
+    cout << "Lecturer: " << course->details->lecturerName << "\n";
+    cout << "Capacity: " << course->capacity << "\n";
+    
+    cout << "\n1. Update Lecturer\n";
+    cout << "2. Update Capacity\n";
+    cout << "3. Update Both\n";
+    cout << "Choice: ";
+    
+    int choice;
+    cin >> choice;
+    cin.ignore();
+    
+    if (choice == 1 || choice == 3) {
+        cout << "Enter New Lecturer Name: ";
+        string lecturer;
+        getline(cin, lecturer);
+        updateCourseLecturer(course, lecturer);
+    }
+    
+    if (choice == 2 || choice == 3) {
+        cout << "Enter New Capacity: ";
+        int capacity;
+        cin >> capacity;
+        cin.ignore();
+        updateCourseCapacity(course, capacity);
+    }
+    
+    cout << "Course updated successfully.\n";
+}
+
+void updateCourseLecturer(Course* course, const string& lecturer) {
+    if (opLogging) logOp("LECTURER\t" + course->details->courseCode + "\t" + lecturer);
+    courseIndex.remove(course);
+    course->details->lecturerName = lecturer;
+    courseIndex.add(course);
+    courseCatalog.publishCourse(course->details->courseCode, course);
+}
+
+void updateCourseCapacity(Course* course, int capacity) {
+    if (opLogging) logOp("CAPACITY\t" + course->details->courseCode + "\t" + to_string(capacity));
+    course->capacity = capacity;
+    courseCatalog.publishCourse(course->details->courseCode, course);
+}
+
+void staffInsertCourse() {
+    string courseCode, courseName, lecturerName;
+    int credit, capacity;
+    cout << "Enter Course Code: ";
+    getline(cin, courseCode);
+    cout << "Enter Course Name: ";
+    getline(cin, courseName);
+    cout << "Enter Lecturer Name: ";
+    getline(cin, lecturerName);
+    cout << "Enter Credit: ";
+    cin >> credit;
+    cout << "Enter Capacity: ";
+    cin >> capacity;
+    cin.ignore();
+    if (insertCourseRecord(courseCode, courseName, lecturerName, credit, capacity) == NULL) {
+        cout << "Course with this code already exists.\n";
+        return;
+    }
+    cout << "Course inserted successfully.\n";
+}
+
+// Adds a course to the tree, search index and catalog. Returns NULL if the code is already taken.
+Course* insertCourseRecord(const string& code, const string& name, const string& lecturer, int credit, int capacity) {
+    Course* newCourse = new Course(code, name, lecturer, credit, capacity, 0);
+    // cannot insert duplicate course code
+    if (courseTree.search(newCourse->details->courseCode) != NULL) {
+        delete newCourse;
+        return NULL;
+    }
+    if (opLogging) logOp("ADDCOURSE\t" + code + "\t" + name + "\t" + lecturer + "\t" + to_string(credit) + "\t" + to_string(capacity));
+    courseTree.insert(newCourse);
+    courseIndex.add(newCourse);
+    courseCatalog.publishCourse(newCourse->details->courseCode, newCourse);
+    return newCourse;
+}
+
+void staffDeleteCourse() {
+    cout << "Enter Course Code: ";
+    string code;
+    getline(cin, code);
+    
+    Course* course = courseTree.search(code);
+    if (course == NULL) {
+        cout << "Course not found.\n";
+        return;
+    }
+    // if course have student cannot delete
+    if (!deleteCourseRecord(course)) {
+        cout << "Cannot delete course with enrolled students.\n";
+        return;
+    }
+    cout << "Course deleted successfully.\n";
+}
+
+// Removes a course nobody is enrolled in. Returns false if it still has students.
+bool deleteCourseRecord(Course* course) {
+    if (course->studentList != NULL) return false;
+    string code = course->details->courseCode;
+    if (opLogging) logOp("DELCOURSE\t" + code);
+    courseIndex.remove(course);
+    // Readers may still hold the course through an older catalog snapshot, so the catalog frees it
+    courseCatalog.publishCourse(code, NULL, courseTree.detachCourse(code));
+    return true;
+}
+
+void staffViewStudentListInCourse() {
+    cout << "Enter Course Code: ";
+    string code;
+    getline(cin, code);
+    
+    Course* course = showCourseStudentList(code);
+    if (course == NULL) return;
+    
+    cout << "\nDownload list? (y/n): ";
+    char choice;
+    cin >> choice;
+    cin.ignore();
+    
+    if (choice == 'y' || choice == 'Y') {
+        downloadCourseStudentList(course);
+    }
+}
+
+// Prints the students in a course. Returns the course, or NULL if it does not exist.
+Course* showCourseStudentList(const string& code) {
+    Course* course = courseTree.search(code);
+    if (course == NULL) {
+        cout << "Course not found.\n";
+        return NULL;
+    }
+    
+    cout << "\n=== Students in " << course->details->courseCode << " - " << course->details->courseName << " ===\n";
+    
+    if (course->studentList == NULL) {
+        cout << "No students in this course.\n";
+    } else {
+        StudentNode* temp = course->studentList;
+        int count = 1;
+        while (temp != NULL) {
+            cout << count++ << ". " << temp->name << " (" << temp->matricNo << ")\n";
+            temp = temp->next;
+        }
+    }
+    return course;
+}
+
+void downloadCourseStudentList(Course* course) {
+    string filename = course->details->courseCode + "_StudentList.txt";
+    string roster;
+    appendCourseRoster(roster, course);
+    ofstream file(filename.c_str());
+    file << roster;
+    file.close();
+    cout << "List downloaded as " << filename << "\n";
+}
+
+void staffViewAllCourses() {
+    viewAllCourses();
+}
+
+void staffRetractCourse() {
+    TRACE_SPAN(TRACE_RETRACT, "");
+    cout << "Enter Student Matric No: ";
+    string matric;
+    getline(cin, matric);
+    
+    Student* student = studentTree.search(matric);
+    if (student == NULL) {
+        cout << "Student not found.\n";
+        return;
+    }
+    
+    cout << "\n=== Student: " << student->profile->name << " (" << student->profile->matricNo << ") ===\n";
+    cout << "Registered Courses:\n";
+    
+    if (student->courseList == NULL) {
+        cout << "No courses registered.\n";
+        return;
+    }
+    
+    int count = 1;
+    CourseNode* current = student->courseList;
+    while (current != NULL) {
+        Course* course = courseTree.search(current->courseCode);
+        if (course != NULL) {
+            cout << count++ << ". " << course->details->courseCode << " - " 
+                 << course->details->courseName << " [" << current->status << "]\n";
+        }
+        current = current->next;
+    }
+    
+    cout << "\nEnter Course Code to retract: ";
+    string code;
+    getline(cin, code);
+    
+    CourseNode* courseNode = findCourseInStudent(student, code);
+    if (courseNode == NULL) {
+        cout << "Course not found in student's registered courses.\n";
+        return;
+    }
+    
+    retractStudentCourse(student, courseNode);
+    
+    cout << "Course retracted successfully.\n";
+    cout << "\nUpdated Registered Courses:\n";
+    
+    if (student->courseList == NULL) {
+        cout << "No courses registered.\n";
+    } else {
+        CourseNode* current = student->courseList;
+        while (current != NULL) {
+            Course* c = courseTree.search(current->courseCode);
+            if (c != NULL) {
+                cout << c->details->courseCode << " - " << c->details->courseName 
+                     << " [" << current->status << "]\n";
+            }
+            current = current->next;
+        }
+    }
+}
+
+// Takes a course off a student's list: an approved seat is released, pending credit is returned.
+// A pending course's request stays queued and is skipped once it is reached.
+void retractStudentCourse(Student* student, CourseNode* courseNode) {
+    string code = courseNode->courseCode;
+    if (opLogging) logOp("RETRACT\t" + student->profile->matricNo + "\t" + code);
+    Course* course = courseTree.search(code);
+    if (changeFeedOn) publishChange(CHANGE_RETRACTED, student, code, course != NULL ? course->credit : 0);
+    if (course != NULL) {
+        if (courseNode->status == "Approved") {
+            adjustStudentCredit(student, 0, -course->credit);
+            removeStudentFromCourseList(course, student->profile->matricNo);
+            course->currentCapacity--;
+        } else {
+            adjustStudentCredit(student, -course->credit, 0);
+        }
+    }
+    
+    removeCourseFromStudent(student, code);
+}
+
+void staffInsertCourseForStudent() {
+    cout << "Enter Student Matric No: ";
+    string matric;
+    getline(cin, matric);
+    
+    Student* student = studentTree.search(matric);
+    if (student == NULL) {
+        cout << "Student not found.\n";
+        return;
+    }
+    
+    cout << "\n=== Student: " << student->profile->name << " (" << student->profile->matricNo << ") ===\n";
+    cout << "Current Registered Courses:\n";
+    
+    if (student->courseList == NULL) {
+        cout << "No courses registered.\n";
+    } else {
+        CourseNode* current = student->courseList;
+        while (current != NULL) {
+            Course* c = courseTree.search(current->courseCode);
+            if (c != NULL) {
+                cout << c->details->courseCode << " - " << c->details->courseName 
+                     << " [" << current->status << "]\n";
+            }
+            current = current->next;
+        }
+    }
+    
+    cout << "\nEnter Course Code to insert: ";
+    string code;
+    getline(cin, code);
+    
+    Course* course = courseTree.search(code);
+    if (course == NULL) {
+        cout << "Course not found.\n";
+        return;
+    }
+    
+    if (findCourseInStudent(student, code) != NULL) {
+        cout << "Student already registered for this course.\n";
+        return;
+    }
+    
+    if (student->currentCredit + course->credit > student->maxCredit) {
+        cout << "Cannot insert: Exceeds maximum credit limit.\n";
+        return;
+    }
+    
+    if (course->currentCapacity >= course->capacity) {
+        cout << "Cannot insert: Course is full.\n";
+        return;
+    }
+    
+    addCourseToStudent(student, code, "Approved");
+    adjustStudentCredit(student, 0, course->credit);
+    insertStudentInCourseList(course, student->profile->matricNo, student->profile->name);
+    course->currentCapacity++;
+    if (changeFeedOn) publishChange(CHANGE_ENROLLED, student, code, course->credit);
+    
+    cout << "Course inserted successfully for student.\n";
+    cout << "\nUpdated Registered Courses:\n";
+    
+    CourseNode* current = student->courseList;
+    while (current != NULL) {
+        Course* c = courseTree.search(current->courseCode);
+        if (c != NULL) {
+            cout << c->details->courseCode << " - " << c->details->courseName 
+                 << " [" << current->status << "]\n";
+        }
+        current = current->next;
+    }
+}
+
+// Cohort Block Registration
+// Enrols a whole program/year cohort in a fixed set of courses. The plan checks every student's
+// credit limit and every course's free seats before anything changes; applying it walks each
+// course's student list once to merge in the new students, who arrive in matric order.
+struct CohortPlan {
+    vector<Course*> courses;     // at most 32
+    vector<Student*> students;   // the cohort, in matric order
+    vector<unsigned> missing;    // per student, a bit for each course to add; 0 if none or skipped
+    vector<int> seatsNeeded;     // per course
+    int alreadyEnrolled;         // students who hold every course already
+    int overCredit;              // students skipped because the courses they lack exceed their limit
+    int enrolments;
+};
+
+// Fills plan for the students matching filter. Returns false if a course lacks seats for the cohort.
+bool planCohort(const StudentFilter& filter, const vector<Course*>& courses, CohortPlan& plan) {
+    plan.courses = courses;
+    studentIndex.query(filter, 0, INT_MAX, plan.students);
+    plan.missing.assign(plan.students.size(), 0);
+    plan.seatsNeeded.assign(courses.size(), 0);
+    plan.alreadyEnrolled = plan.overCredit = plan.enrolments = 0;
+
+    for (size_t s = 0; s < plan.students.size(); s++) {
+        Student* student = plan.students[s];
+        unsigned mask = 0;
+        int credits = 0;
+        for (size_t c = 0; c < courses.size(); c++) {
+            if (findCourseInStudent(student, courses[c]->codeKey, courses[c]->details->courseCode) != NULL) continue;
+            mask |= 1u << c;
+            credits += courses[c]->credit;
+        }
+        if (mask == 0) {
+            plan.alreadyEnrolled++;
+        } else if (student->currentCredit + credits > student->maxCredit) {
+            plan.overCredit++;
+        } else {
+            plan.missing[s] = mask;
+            for (size_t c = 0; c < courses.size(); c++) {
+                if (mask & (1u << c)) plan.seatsNeeded[c]++;
+            }
+            plan.enrolments += __builtin_popcount(mask);
+        }
+    }
+
+    bool fits = true;
+    for (size_t c = 0; c < courses.size(); c++) {
+        if (plan.seatsNeeded[c] > courses[c]->capacity - courses[c]->currentCapacity) fits = false;
+    }
+    return fits;
+}
+
+// Applies a plan that fits. Returns the number of students enrolled.
+int applyCohort(CohortPlan& plan) {
+    int enrolled = 0;
+    for (size_t s = 0; s < plan.students.size(); s++) {
+        unsigned mask = plan.missing[s];
+        if (mask == 0) continue;
+        Student* student = plan.students[s];
+        int credits = 0;
+        for (size_t c = 0; c < plan.courses.size(); c++) {
+            if (!(mask & (1u << c))) continue;
+            addCourseToStudent(student, plan.courses[c]->details->courseCode, "Approved");
+            credits += plan.courses[c]->credit;
+            if (changeFeedOn) publishChange(CHANGE_ENROLLED, student, plan.courses[c]->details->courseCode, plan.courses[c]->credit);
+        }
+        adjustStudentCredit(student, 0, credits);
+        enrolled++;
+    }
+
+    for (size_t c = 0; c < plan.courses.size(); c++) {
+        Course* course = plan.courses[c];
+        StudentNode** link = &course->studentList;
+        for (size_t s = 0; s < plan.students.size(); s++) {
+            if (!(plan.missing[s] & (1u << c))) continue;
+            Student* student = plan.students[s];
+            while (*link != NULL && compareKeys((*link)->key, (*link)->matricNo, student->matricKey, student->profile->matricNo) < 0) {
+                link = &(*link)->next;
+            }
+            StudentNode* node = new StudentNode(student->profile->matricNo, student->profile->name);
+            node->next = *link;
+            *link = node;
+            link = &node->next;
+        }
+        course->currentCapacity += plan.seatsNeeded[c];
+    }
+    return enrolled;
+}
+
+void staffBlockRegister() {
+    if (!allStudentsLoaded()) return;
+    StudentFilter filter;
+    filter.program = selectProgram();
+    cout << "Enter Year (0 for any): ";
+    cin >> filter.minYear;
+    cin.ignore();
+    filter.maxYear = filter.minYear;
+
+    cout << "Enter Course Codes (separated by spaces): ";
+    string line;
+    getline(cin, line);
+    vector<string> codes = splitCodes(line);
+    if (codes.empty() || codes.size() > 32) {
+        cout << "Enter between 1 and 32 course codes.\n";
+        return;
+    }
+    vector<Course*> courses;
+    for (size_t i = 0; i < codes.size(); i++) {
+        Course* course = courseTree.search(codes[i]);
+        if (course == NULL) {
+            cout << "Course not found: " << codes[i] << "\n";
+            return;
+        }
+        if (find(courses.begin(), courses.end(), course) == courses.end()) courses.push_back(course);
+    }
+
+    CohortPlan plan;
+    bool fits = planCohort(filter, courses, plan);
+    cout << "\n=== Block Registration ===\n";
+    cout << "Students in cohort: " << plan.students.size() << "\n";
+    cout << "Already registered for every course: " << plan.alreadyEnrolled << "\n";
+    cout << "Skipped (would exceed credit limit): " << plan.overCredit << "\n";
+    cout << "To enrol: " << plan.students.size() - plan.alreadyEnrolled - plan.overCredit
+         << " student(s), " << plan.enrolments << " enrolment(s)\n";
+    for (size_t c = 0; c < courses.size(); c++) {
+        int freeSeats = courses[c]->capacity - courses[c]->currentCapacity;
+        cout << courses[c]->details->courseCode << ": " << plan.seatsNeeded[c] << " seat(s) needed, " << freeSeats << " free";
+        if (plan.seatsNeeded[c] > freeSeats) cout << " - short by " << plan.seatsNeeded[c] - freeSeats;
+        cout << "\n";
+    }
+    if (!fits) {
+        cout << "Not enough seats for the whole cohort. Raise the capacity first. Nothing was changed.\n";
+        return;
+    }
+    if (plan.enrolments == 0) {
+        cout << "Nothing to do.\n";
+        return;
+    }
+
+    cout << "\nApply these enrolments? (y/n): ";
+    char choice;
+    cin >> choice;
+    cin.ignore();
+    if (choice != 'y' && choice != 'Y') {
+        cout << "Block registration cancelled.\n";
+        return;
+    }
+    int enrolled = applyCohort(plan);
+    cout << enrolled << " student(s) enrolled in " << courses.size() << " course(s) (Status: Approved).\n";
+}
+
+// Value at the given percentile of a merged histogram (upper edge of its bucket, capped at max)
+unsigned long long histogramPercentile(const vector<unsigned long long>& buckets, unsigned long long count,
+                                       unsigned long long maxNs, double percentile) {
+    unsigned long long rank = (unsigned long long)(percentile / 100.0 * count);
+    if (rank >= count) rank = count - 1;
+    unsigned long long seen = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen > rank) return min(histogramBucketLimit(b), maxNs);
+    }
+    return maxNs;
+}
+
+string formatMicros(unsigned long long ns) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.2f", ns / 1000.0);
+    return buffer;
+}
+
+void printPerformanceStats() {
+    cout << "\n=== Performance Statistics (microseconds) ===\n";
+#if STATS_ENABLED
+    cout << left << setw(24) << "Operation" << right << setw(10) << "Count" << setw(11) << "Mean"
+         << setw(11) << "p50" << setw(11) << "p90" << setw(11) << "p99" << setw(12) << "Max" << "\n";
+    for (int op = 0; op < OP_COUNT; op++) {
+        unsigned long long count = 0, totalNs = 0, maxNs = 0;
+        vector<unsigned long long> buckets(HISTOGRAM_BUCKETS, 0);
+        for (StatsBlock* block = statsBlocks.load(); block != NULL; block = block->nextBlock) {
+            OpStats& s = block->ops[op];
+            count += s.count.load(memory_order_relaxed);
+            totalNs += s.totalNs.load(memory_order_relaxed);
+            maxNs = max(maxNs, s.maxNs.load(memory_order_relaxed));
+            for (int b = 0; b < HISTOGRAM_BUCKETS; b++) buckets[b] += s.buckets[b].load(memory_order_relaxed);
+        }
+        if (count == 0) continue;
+
+        cout << left << setw(24) << statOpNames[op] << right << setw(10) << count
+             << setw(11) << formatMicros(totalNs / count)
+             << setw(11) << formatMicros(histogramPercentile(buckets, count, maxNs, 50))
+             << setw(11) << formatMicros(histogramPercentile(buckets, count, maxNs, 90))
+             << setw(11) << formatMicros(histogramPercentile(buckets, count, maxNs, 99))
+             << setw(12) << formatMicros(maxNs) << "\n";
+    }
+#else
+    cout << "Instrumentation was compiled out (STATS_ENABLED=0).\n";
+#endif
+    cout << "\n=== Gauges ===\n";
+    cout << "Student tree height: " << studentTree.height() << "\n";
+    if (lazyStudents) studentPager.printStats();
+    cout << "Course tree height: " << courseTree.height() << "\n";
+    cout << "Queue length: " << regQueue.getLength() << " (" << regQueue.getLiveCount() << " live)\n";
+    if (changeFeed.wasStarted()) changeFeed.printStats();
+}
+
+// Writes every buffered trace event as Chrome trace JSON. Returns the number of events written.
+int writeTraceFile(string filename) {
+    ofstream file(filename.c_str());
+    if (!file) {
+        cout << "Error writing trace file.\n";
+        return 0;
+    }
+
+    OutputBuffer out(file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    int written = 0;
+    for (TraceBuffer* buffer = traceBuffers.load(); buffer != NULL; buffer = buffer->nextBuffer) {
+        unsigned long long head = buffer->head.load(memory_order_acquire);
+        unsigned long long first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+        for (unsigned long long i = first; i < head; i++) {
+            TraceRecord& r = buffer->records[i & (TRACE_CAPACITY - 1)];
+            char line[256];
+            snprintf(line, sizeof(line),
+                     "%s{\"name\":\"%s\",\"cat\":\"registration\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"detail\":\"%s\"}}\n",
+                     written == 0 ? "" : ",", traceEventNames[r.event], r.phase, r.timestampNs / 1000.0,
+                     buffer->threadId, r.detail);
+            out << line;
+            written++;
+        }
+    }
+    out << "]}\n";
+    return written;
+}
+
+void staffWriteTrace() {
+    if (!tracingEnabled) {
+        cout << "Tracing is off. Start the program with --trace <file> to record events.\n";
+        return;
+    }
+    int written = writeTraceFile(traceFileName);
+    cout << written << " trace event(s) written to " << traceFileName << "\n";
+}
+
+// Batch Seat Allocation
+// Decides every live request in the queue at once instead of first-come-first-served,
+// granting as many requests as possible under course capacity and student maxCredit.
+struct AllocRequest {
+    RegistrationRequest* req;
+    int student;
+    int course;
+    int credit;
+    bool granted;
+};
+
+struct AllocStudent {
+    Student* student;
+    int headroom; // credits still grantable in this run
+    vector<int> requests;
+};
+
+struct AllocCourse {
+    Course* course;
+    int freeSeats;
+    double pressure; // demand / free seats
+    vector<int> requests;
+};
+
+class SeatAllocator {
+private:
+    vector<AllocRequest> requests;
+    vector<AllocStudent> students;
+    vector<AllocCourse> courses;
+    vector<RegistrationRequest*> packages; // package requests in queue order, decided all or nothing
+    vector<bool> packageFits;
+    int grantedCount;
+    int swapCount;
+
+    // Index of the course in courses, adding it on first use; -1 if it no longer exists
+    int courseSlot(const string& code, unordered_map<string, int>& courseIndex) {
+        unordered_map<string, int>::iterator it = courseIndex.find(code);
+        if (it != courseIndex.end()) return it->second;
+        Course* course = courseTree.search(code);
+        if (course == NULL) return -1;
+        AllocCourse ac;
+        ac.course = course;
+        ac.freeSeats = course->capacity - course->currentCapacity;
+        if (ac.freeSeats < 0) ac.freeSeats = 0;
+        ac.pressure = 0;
+        courses.push_back(ac);
+        courseIndex[code] = courses.size() - 1;
+        return courses.size() - 1;
+    }
+
+    // Packages are not traded seat by seat: each one that still fits, in queue order, keeps its
+    // seats out of the optimisation, and the rest are rejected when the plan is applied.
+    void planPackage(RegistrationRequest* req, unordered_map<string, int>& courseIndex) {
+        Student* student = studentTree.search(req->matricNo);
+        if (student == NULL) return;
+        vector<int> slots;
+        bool fit = true;
+        for (RegistrationRequest* member = req; member != NULL; member = member->package) {
+            if (findCourseInStudent(student, member->courseKey, member->courseCode) == NULL) continue;
+            int c = courseSlot(member->courseCode, courseIndex);
+            if (c < 0 || courses[c].freeSeats <= 0) fit = false;
+            slots.push_back(c);
+        }
+        if (fit) {
+            for (size_t i = 0; i < slots.size(); i++) courses[slots[i]].freeSeats--;
+        }
+        packages.push_back(req);
+        packageFits.push_back(fit);
+    }
+
+    void grant(int r) {
+        AllocRequest& a = requests[r];
+        a.granted = true;
+        students[a.student].headroom -= a.credit;
+        courses[a.course].freeSeats--;
+        grantedCount++;
+    }
+
+    void revoke(int r) {
+        AllocRequest& a = requests[r];
+        a.granted = false;
+        students[a.student].headroom += a.credit;
+        courses[a.course].freeSeats++;
+        grantedCount--;
+    }
+
+    bool fits(int r) {
+        AllocRequest& a = requests[r];
+        return !a.granted && courses[a.course].freeSeats > 0 && students[a.student].headroom >= a.credit;
+    }
+
+    // Finds a rejected request in course c whose student could take a seat there if one were freed.
+    int findWaiting(int c, int excludeStudent) {
+        vector<int>& list = courses[c].requests;
+        for (size_t i = 0; i < list.size(); i++) {
+            AllocRequest& a = requests[list[i]];
+            if (!a.granted && a.student != excludeStudent && students[a.student].headroom >= a.credit)
+                return list[i];
+        }
+        return -1;
+    }
+
+    // A student blocked by maxCredit in a course with free seats gives up a seat in another
+    // course if that seat can go to someone who is waiting for it. Each swap grants one more request.
+    bool improve(int blocked) {
+        AllocRequest& b = requests[blocked];
+        AllocStudent& s = students[b.student];
+        for (size_t i = 0; i < s.requests.size(); i++) {
+            int g = s.requests[i];
+            if (!requests[g].granted) continue;
+            if (s.headroom + requests[g].credit < b.credit) continue;
+
+            int waiting = findWaiting(requests[g].course, b.student);
+            if (waiting == -1) continue;
+
+            revoke(g);
+            grant(blocked);
+            grant(waiting);
+            swapCount++;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    SeatAllocator() : grantedCount(0), swapCount(0) {}
+
+    // Snapshots the live requests in the queue. Returns the number of requests considered.
+    int build(RegistrationQueue& queue) {
+        requests.clear();
+        students.clear();
+        courses.clear();
+        packages.clear();
+        packageFits.clear();
+        grantedCount = swapCount = 0;
+
+        unordered_map<string, int> studentIndex;
+        unordered_map<string, int> courseIndex;
+
+        for (RegistrationRequest* req = queue.getFront(); req != NULL; req = req->next) {
+            if (req->isCancelled) continue;
+            if (req->package != NULL) {
+                planPackage(req, courseIndex);
+                continue;
+            }
+
+            int si, ci;
+            unordered_map<string, int>::iterator it = studentIndex.find(req->matricNo);
+            if (it == studentIndex.end()) {
+                Student* student = studentTree.search(req->matricNo);
+                if (student == NULL) continue;
+                AllocStudent as;
+                as.student = student;
+                // currentCredit already includes every pending request of this student
+                as.headroom = student->maxCredit - student->currentCredit;
+                si = students.size();
+                students.push_back(as);
+                studentIndex[req->matricNo] = si;
+            } else {
+                si = it->second;
+            }
+
+            ci = courseSlot(req->courseCode, courseIndex);
+            if (ci < 0) continue;
+
+            if (findCourseInStudent(students[si].student, req->courseCode) == NULL) continue;
+
+            AllocRequest ar;
+            ar.req = req;
+            ar.student = si;
+            ar.course = ci;
+            ar.credit = req->credit;
+            ar.granted = false;
+
+            int r = requests.size();
+            requests.push_back(ar);
+            students[si].headroom += req->credit;
+            students[si].requests.push_back(r);
+            courses[ci].requests.push_back(r);
+        }
+
+        for (size_t c = 0; c < courses.size(); c++) {
+            int seats = courses[c].freeSeats > 0 ? courses[c].freeSeats : 1;
+            courses[c].pressure = (double)courses[c].requests.size() / seats;
+        }
+        return requests.size();
+    }
+
+    // Greedy pass followed by local search. Returns the number of granted requests.
+    int solve() {
+        // Cheapest requests first, then least contended courses, then queue order
+        vector<int> order(requests.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        stable_sort(order.begin(), order.end(), [this](int x, int y) {
+            if (requests[x].credit != requests[y].credit) return requests[x].credit < requests[y].credit;
+            return courses[requests[x].course].pressure < courses[requests[y].course].pressure;
+        });
+
+        for (size_t i = 0; i < order.size(); i++) {
+            if (fits(order[i])) grant(order[i]);
+        }
+
+        bool changed = true;
+        for (int pass = 0; changed && pass < 4; pass++) {
+            changed = false;
+            for (size_t c = 0; c < courses.size(); c++) {
+                if (courses[c].freeSeats <= 0) continue;
+                vector<int>& list = courses[c].requests;
+                for (size_t i = 0; i < list.size() && courses[c].freeSeats > 0; i++) {
+                    int r = list[i];
+                    if (requests[r].granted) continue;
+                    if (fits(r)) {
+                        grant(r);
+                        changed = true;
+                    } else if (improve(r)) {
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return grantedCount;
+    }
+
+    // What plain first-come-first-served approval would have granted on the same snapshot.
+    int fcfsCount() {
+        vector<int> seats(courses.size()), headroom(students.size());
+        for (size_t c = 0; c < courses.size(); c++) seats[c] = courses[c].course->capacity - courses[c].course->currentCapacity;
+        for (size_t s = 0; s < students.size(); s++) headroom[s] = students[s].student->maxCredit - students[s].student->currentCredit;
+        for (size_t r = 0; r < requests.size(); r++) headroom[requests[r].student] += requests[r].credit;
+
+        int count = 0;
+        for (size_t r = 0; r < requests.size(); r++) {
+            AllocRequest& a = requests[r];
+            if (seats[a.course] > 0 && headroom[a.student] >= a.credit) {
+                seats[a.course]--;
+                headroom[a.student] -= a.credit;
+                count++;
+            }
+        }
+        return count;
+    }
+
+    int getRequestCount() { return requests.size(); }
+    int getPackageCount() { return packages.size(); }
+
+    int getPackageFitCount() {
+        int count = 0;
+        for (size_t i = 0; i < packageFits.size(); i++) count += packageFits[i];
+        return count;
+    }
+    int getGrantedCount() { return grantedCount; }
+    int getSwapCount() { return swapCount; }
+
+    int getOversubscribedCount() {
+        int count = 0;
+        for (size_t c = 0; c < courses.size(); c++) {
+            if ((int)courses[c].requests.size() > courses[c].course->capacity - courses[c].course->currentCapacity) count++;
+        }
+        return count;
+    }
+
+    // Drains the queue, approving and rejecting through the same bookkeeping as staffViewRequests.
+    void apply(RegistrationQueue& queue, int& approved, int& rejected) {
+        TRACE_SPAN(TRACE_DRAIN, "batch");
+        approved = rejected = 0;
+        int next = 0, nextPackage = 0;
+        while (!queue.isEmpty()) {
+            RegistrationRequest* req = queue.getFront();
+            if (nextPackage < (int)packages.size() && packages[nextPackage] == req) {
+                Student* student = studentTree.search(req->matricNo);
+                if (packageFits[nextPackage++] && approveRequest(req, student, NULL)) {
+                    approved++;
+                } else if (rejectRequest(req, student, "Not allocated a seat in batch allocation")) {
+                    rejected++;
+                }
+            } else if (next < (int)requests.size() && requests[next].req == req) {
+                AllocRequest& a = requests[next++];
+                Student* student = students[a.student].student;
+                Course* course = courses[a.course].course;
+                if (a.granted && approveRequest(req, student, course)) {
+                    approved++;
+                } else if (!a.granted && rejectRequest(req, student, "Not allocated a seat in batch allocation")) {
+                    rejected++;
+                }
+            }
+            delete queue.dequeue();
+        }
+    }
+};
+
+void staffBatchAllocate() {
+    if (regQueue.isEmpty()) {
+        cout << "No pending requests.\n";
+        return;
+    }
+
+    SeatAllocator allocator;
+    int considered = allocator.build(regQueue);
+    int granted = allocator.solve();
+
+    cout << "\n=== Batch Seat Allocation ===\n";
+    cout << "Requests considered: " << considered << "\n";
+    cout << "Oversubscribed courses: " << allocator.getOversubscribedCount() << "\n";
+    cout << "Requests granted: " << granted << " (first-come-first-served would grant "
+         << allocator.fcfsCount() << ")\n";
+    cout << "Requests rejected: " << considered - granted << "\n";
+    if (allocator.getPackageCount() > 0) {
+        cout << "Packages (all or none, in queue order): " << allocator.getPackageFitCount() << " of "
+             << allocator.getPackageCount() << " fit\n";
+    }
+
+    cout << "\nApply these decisions to all pending requests? (y/n): ";
+    char choice;
+    cin >> choice;
+    cin.ignore();
+
+    if (choice != 'y' && choice != 'Y') {
+        cout << "Batch allocation cancelled.\n";
+        return;
+    }
+
+    int approved, rejected;
+    allocator.apply(regQueue, approved, rejected);
+    cout << approved << " request(s) approved, " << rejected << " request(s) rejected.\n";
+}
+
+// Bulk Export
+// Renders every student's registration slip and every course's student list on a pool of worker
+// threads. Work is handed out in chunks; each worker formats a chunk into its own buffer and writes
+// it with one fwrite per file, or, in archive mode, hands the chunk to the caller to append in order.
+const int EXPORT_CHUNK = 64;
+
+struct ExportJob {
+    vector<Student*> students;
+    vector<Course*> courses;
+    bool archive;
+    string target; // output directory, or archive file name
+    int chunks;
+    atomic<int> nextChunk;
+    vector<string> chunkText; // archive mode only
+    vector<char> chunkDone;
+    mutex lock;
+    condition_variable chunkReady;
+    atomic<long long> bytes;
+    atomic<int> failed;
+
+    ExportJob() : archive(false), chunks(0), nextChunk(0), bytes(0), failed(0) {}
+};
+
+string exportFileName(ExportJob& job, int item) {
+    if (item < (int)job.students.size()) {
+        return job.students[item]->profile->matricNo + "_CourseRegistrationSlip.txt";
+    }
+    return job.courses[item - job.students.size()]->details->courseCode + "_StudentList.txt";
+}
+
+void renderExportItem(ExportJob& job, int item, string& out) {
+    if (item < (int)job.students.size()) {
+        appendRegistrationSlip(out, job.students[item]);
+    } else {
+        appendCourseRoster(out, job.courses[item - job.students.size()]);
+    }
+}
+
+void exportWorker(ExportJob* job) {
+    int total = job->students.size() + job->courses.size();
+    string buffer;
+    string path;
+    int chunk;
+    while ((chunk = job->nextChunk++) < job->chunks) {
+        int first = chunk * EXPORT_CHUNK;
+        int last = min(first + EXPORT_CHUNK, total);
+        buffer.clear();
+
+        for (int i = first; i < last; i++) {
+            if (job->archive) {
+                buffer += "##### " + exportFileName(*job, i) + "\n";
+                renderExportItem(*job, i, buffer);
+                continue;
+            }
+
+            size_t start = buffer.size();
+            renderExportItem(*job, i, buffer);
+            path = job->target + "/" + exportFileName(*job, i);
+            FILE* file = fopen(path.c_str(), "wb");
+            if (file == NULL || fwrite(buffer.data() + start, 1, buffer.size() - start, file) != buffer.size() - start) {
+                job->failed++;
+            }
+            if (file != NULL) fclose(file);
+        }
+        job->bytes += buffer.size();
+
+        if (job->archive) {
+            lock_guard<mutex> guard(job->lock);
+            job->chunkText[chunk].swap(buffer);
+            job->chunkDone[chunk] = 1;
+            job->chunkReady.notify_one();
+        }
+    }
+}
+
+// Exports slips for every student and rosters for every course. Returns the number of files written
+// (entries, in archive mode) and fills bytesOut, or -1 if the output could not be opened.
+int bulkExport(bool archive, const string& target, int threads, long long& bytesOut) {
+    ExportJob job;
+    job.archive = archive;
+    job.target = target;
+    for (TreeCursor<Student> cursor(studentTree.getRoot()); cursor.hasNext();) job.students.push_back(cursor.next());
+    for (TreeCursor<Course> cursor(courseTree.getRoot()); cursor.hasNext();) job.courses.push_back(cursor.next());
+    int total = job.students.size() + job.courses.size();
+    job.chunks = (total + EXPORT_CHUNK - 1) / EXPORT_CHUNK;
+
+    FILE* out = NULL;
+    if (archive) {
+        out = fopen(target.c_str(), "wb");
+        if (out == NULL) return -1;
+        job.chunkText.resize(job.chunks);
+        job.chunkDone.assign(job.chunks, 0);
+    } else {
+        error_code ec;
+        filesystem::create_directories(target, ec);
+        if (!filesystem::is_directory(target, ec)) return -1;
+    }
+
+    if (threads < 1) threads = 1;
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) pool.push_back(thread(exportWorker, &job));
+
+    // Archive chunks are appended in order as they finish, so the file is the same for any thread count
+    if (archive) {
+        for (int chunk = 0; chunk < job.chunks; chunk++) {
+            string text;
+            {
+                unique_lock<mutex> guard(job.lock);
+                job.chunkReady.wait(guard, [&]() { return job.chunkDone[chunk] != 0; });
+                text.swap(job.chunkText[chunk]);
+            }
+            if (fwrite(text.data(), 1, text.size(), out) != text.size()) job.failed++;
+        }
+        fclose(out);
+    }
+
+    for (size_t t = 0; t < pool.size(); t++) pool[t].join();
+    bytesOut = job.bytes;
+    return job.failed > 0 ? -1 : total;
+}
+
+int defaultExportThreads() {
+    unsigned cores = thread::hardware_concurrency();
+    return cores == 0 ? 4 : (int)cores;
+}
+
+void staffBulkExport() {
+    if (!allStudentsLoaded()) return;
+    cout << "\n=== Bulk Export ===\n";
+    cout << "1. Separate files (one slip per student, one list per course)\n";
+    cout << "2. Single archive file\n";
+    cout << "Choice: ";
+    int choice;
+    cin >> choice;
+    cin.ignore();
+    if (choice != 1 && choice != 2) {
+        cout << "Invalid choice.\n";
+        return;
+    }
+
+    cout << (choice == 1 ? "Enter output directory: " : "Enter archive file name: ");
+    string target;
+    getline(cin, target);
+    if (target.empty()) target = choice == 1 ? "export" : "export.txt";
+
+    long long bytes = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int files = bulkExport(choice == 2, target, defaultExportThreads(), bytes);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (files < 0) {
+        cout << "Could not write to " << target << ".\n";
+        return;
+    }
+    cout << files << (choice == 1 ? " file(s)" : " entries") << " exported to " << target
+         << " (" << bytes / 1024 << " KB, " << fixed << setprecision(2) << seconds << " s)\n";
+}
+
+// Analytics
+// Reporting queries run over a columnar copy of the data. One pass over the trees copies each field
+// into its own array, so a query never touches the live records. Text columns are dictionary
+// encoded: a filter on one is decided once per distinct value, and GROUP BY uses the value's number
+// as the group. Each WHERE condition narrows a row mask in one loop over one column, and each
+// aggregate is another loop over one column.
+//   SELECT COUNT | SUM(col) | AVG(col) | MIN(col) | MAX(col), ... FROM courses | students | enrollments
+//   [WHERE col op value [AND ...]] [GROUP BY col] [ORDER BY result column [DESC]] [LIMIT n]
+// where op is one of = != < <= > >= and ^ (text starts with).
+struct AnalyticsColumn {
+    string name;
+    bool text;
+    vector<double> numbers;
+    vector<int> ids; // text columns: index into dictionary
+    vector<string> dictionary;
+    unordered_map<string, int> lookup; // only while copying
+    int last; // id of the previous text value; runs of one value skip the lookup
+
+    AnalyticsColumn(const string& _name, bool _text) : name(_name), text(_text), last(-1) {}
+
+    void add(double value) { numbers.push_back(value); }
+
+    void add(const string& value) {
+        if (last < 0 || dictionary[last] != value) {
+            unordered_map<string, int>::iterator it = lookup.find(value);
+            if (it == lookup.end()) {
+                it = lookup.insert(make_pair(value, (int)dictionary.size())).first;
+                dictionary.push_back(value);
+            }
+            last = it->second;
+        }
+        ids.push_back(last);
+    }
+
+    // For values that never repeat, such as matric numbers
+    void addDistinct(const string& value) {
+        ids.push_back(dictionary.size());
+        dictionary.push_back(value);
+    }
+
+    // Shares another column's dictionary, so rows can be copied by id without hashing the text
+    void shareDictionary(const AnalyticsColumn& from) {
+        dictionary = from.dictionary;
+    }
+};
+
+struct AnalyticsTable {
+    string name;
+    int rows;
+    vector<AnalyticsColumn> columns;
+
+    AnalyticsTable() : rows(0) {}
+
+    AnalyticsColumn& addColumn(const string& name, bool text) {
+        columns.push_back(AnalyticsColumn(name, text));
+        return columns.back();
+    }
+
+    int find(const string& name) const {
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (columns[i].name == name) return i;
+        }
+        return -1;
+    }
+};
+
+class AnalyticsSnapshot {
+public:
+    AnalyticsTable courses;
+    AnalyticsTable students;
+    AnalyticsTable enrollments;
+
+    void build();
+
+    AnalyticsTable* table(const string& name) {
+        if (name == "courses") return &courses;
+        if (name == "students") return &students;
+        if (name == "enrollments") return &enrollments;
+        return NULL;
+    }
+};
+
+void AnalyticsSnapshot::build() {
+    courses = AnalyticsTable();
+    courses.name = "courses";
+    courses.columns.reserve(8); // column references below must stay valid
+    AnalyticsColumn& code = courses.addColumn("code", true);
+    AnalyticsColumn& faculty = courses.addColumn("faculty", true);
+    AnalyticsColumn& lecturer = courses.addColumn("lecturer", true);
+    AnalyticsColumn& credit = courses.addColumn("credit", false);
+    AnalyticsColumn& capacity = courses.addColumn("capacity", false);
+    AnalyticsColumn& enrolled = courses.addColumn("enrolled", false);
+    AnalyticsColumn& fill = courses.addColumn("fill", false);
+    AnalyticsColumn& pending = courses.addColumn("pending", false);
+    vector<PackedKey> courseKeys;
+    for (TreeCursor<Course> cursor(courseTree.getRoot()); cursor.hasNext();) {
+        Course* course = cursor.next();
+        const string& courseCode = course->details->courseCode;
+        courseKeys.push_back(course->codeKey);
+        courses.rows++;
+        int taken = course->currentCapacity;
+        code.addDistinct(courseCode);
+        faculty.add(courseCode.substr(0, 4));
+        lecturer.add(course->details->lecturerName);
+        credit.add(course->credit);
+        capacity.add(course->capacity);
+        enrolled.add(taken);
+        fill.add(course->capacity > 0 ? (double)taken / course->capacity : 0);
+        pending.add(regQueue.getPendingFor(courseCode));
+    }
+
+    // Course rows by packed code in an open-addressing table, so enrollments find their course without hashing strings
+    size_t slotMask = 15;
+    while (slotMask + 1 < 2 * courseKeys.size()) slotMask = slotMask * 2 + 1;
+    vector<int> courseSlots(slotMask + 1, -1);
+    for (int row = 0; row < courses.rows; row++) {
+        size_t slot = packedKeyHash(courseKeys[row]) & slotMask;
+        while (courseSlots[slot] >= 0) slot = (slot + 1) & slotMask;
+        courseSlots[slot] = row;
+    }
+
+    students = AnalyticsTable();
+    students.name = "students";
+    students.columns.reserve(9);
+    AnalyticsColumn& matric = students.addColumn("matric", true);
+    AnalyticsColumn& program = students.addColumn("program", true);
+    AnalyticsColumn& year = students.addColumn("year", false);
+    AnalyticsColumn& maxCredit = students.addColumn("maxcredit", false);
+    AnalyticsColumn& credits = students.addColumn("credits", false);
+    AnalyticsColumn& approved = students.addColumn("approved", false);
+    AnalyticsColumn& pendingCredits = students.addColumn("pending", false);
+    AnalyticsColumn& headroom = students.addColumn("headroom", false);
+    AnalyticsColumn& courseCount = students.addColumn("courses", false);
+
+    enrollments = AnalyticsTable();
+    enrollments.name = "enrollments";
+    enrollments.columns.reserve(8);
+    AnalyticsColumn& byMatric = enrollments.addColumn("matric", true);
+    AnalyticsColumn& byProgram = enrollments.addColumn("program", true);
+    AnalyticsColumn& byYear = enrollments.addColumn("year", false);
+    AnalyticsColumn& byCode = enrollments.addColumn("code", true);
+    AnalyticsColumn& byFaculty = enrollments.addColumn("faculty", true);
+    AnalyticsColumn& byLecturer = enrollments.addColumn("lecturer", true);
+    AnalyticsColumn& status = enrollments.addColumn("status", true);
+    AnalyticsColumn& byCredit = enrollments.addColumn("credit", false);
+    byCode.shareDictionary(code);
+    byFaculty.shareDictionary(faculty);
+    byLecturer.shareDictionary(lecturer);
+
+    for (TreeCursor<Student> cursor(studentTree.getRoot()); cursor.hasNext();) {
+        Student* student = cursor.next();
+        int row = students.rows++;
+        matric.addDistinct(student->profile->matricNo);
+        program.add(student->profile->program);
+        year.add(student->profile->year);
+        maxCredit.add(student->maxCredit);
+        credits.add(student->currentCredit);
+        approved.add(student->approvedCredit);
+        pendingCredits.add(student->pendingCredit);
+        headroom.add(student->maxCredit - student->currentCredit);
+
+        int count = 0;
+        for (CourseNode* node = student->courseList; node != NULL; node = node->next, count++) {
+            size_t slot = packedKeyHash(node->key) & slotMask;
+            int c;
+            while ((c = courseSlots[slot]) >= 0 && compareKeys(courseKeys[c], code.dictionary[c], node->key, node->courseCode) != 0) {
+                slot = (slot + 1) & slotMask;
+            }
+            if (c < 0) continue; // course since deleted
+            byMatric.ids.push_back(matric.ids[row]);
+            byProgram.ids.push_back(program.ids[row]);
+            byYear.add(student->profile->year);
+            byCode.ids.push_back(code.ids[c]);
+            byFaculty.ids.push_back(faculty.ids[c]);
+            byLecturer.ids.push_back(lecturer.ids[c]);
+            status.add(node->status);
+            byCredit.add(credit.numbers[c]);
+            enrollments.rows++;
+        }
+        courseCount.add(count);
+    }
+    byMatric.shareDictionary(matric);
+    byProgram.shareDictionary(program);
+
+    AnalyticsTable* tables[] = { &courses, &students, &enrollments };
+    for (int t = 0; t < 3; t++) {
+        for (size_t i = 0; i < tables[t]->columns.size(); i++) unordered_map<string, int>().swap(tables[t]->columns[i].lookup);
+    }
+}
+
+struct AnalyticsCondition {
+    int column;
+    string op;
+    double number;
+    string text;
+};
+
+struct AnalyticsAggregate {
+    string function; // count, sum, avg, min or max
+    int column;      // -1 for count
+    string label;
+};
+
+struct AnalyticsQuery {
+    AnalyticsTable* table;
+    vector<AnalyticsAggregate> aggregates;
+    vector<AnalyticsCondition> where;
+    int groupBy;
+    string orderBy;
+    bool descending;
+    int limit;
+
+    AnalyticsQuery() : table(NULL), groupBy(-1), descending(false), limit(-1) {}
+};
+
+// Words, numbers and quoted text (kept with its opening quote), plus ( ) , * and the comparison operators
+vector<string> analyticsTokens(const string& text) {
+    vector<string> tokens;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (isspace((unsigned char)c)) {
+            i++;
+        } else if (c == '\'' || c == '"') {
+            size_t end = text.find(c, i + 1);
+            if (end == string::npos) end = text.size();
+            tokens.push_back(text.substr(i, end - i));
+            i = end + 1;
+        } else if (isalnum((unsigned char)c) || c == '_' || c == '.' || c == '-') {
+            size_t start = i;
+            while (i < text.size() && (isalnum((unsigned char)text[i]) || text[i] == '_' || text[i] == '.' || text[i] == '-')) i++;
+            tokens.push_back(text.substr(start, i - start));
+        } else if ((c == '<' || c == '>' || c == '!') && i + 1 < text.size() && (text[i + 1] == '=' || (c == '<' && text[i + 1] == '>'))) {
+            tokens.push_back(c == '<' && text[i + 1] == '>' ? "!=" : text.substr(i, 2));
+            i += 2;
+        } else {
+            tokens.push_back(string(1, c));
+            i++;
+        }
+    }
+    return tokens;
+}
+
+// Moves past the next token if it is the given keyword, in any case
+bool takeKeyword(const vector<string>& tokens, size_t& at, const char* word) {
+    if (at < tokens.size() && toLowerCopy(tokens[at]) == word) {
+        at++;
+        return true;
+    }
+    return false;
+}
+
+// Parses a query against the snapshot's tables. Returns false with a message for the user.
+bool parseAnalyticsQuery(AnalyticsSnapshot& snapshot, const string& text, AnalyticsQuery& query, string& error) {
+    vector<string> tokens = analyticsTokens(text);
+    size_t at = 0;
+
+    if (!takeKeyword(tokens, at, "select")) {
+        error = "A query starts with SELECT";
+        return false;
+    }
+    vector<pair<string, string> > wanted; // function, column name
+    while (at < tokens.size()) {
+        string function = toLowerCopy(tokens[at++]);
+        string column;
+        if (at < tokens.size() && tokens[at] == "(") {
+            if (at + 2 >= tokens.size() || tokens[at + 2] != ")") {
+                error = "Expected " + function + "(column)";
+                return false;
+            }
+            column = toLowerCopy(tokens[at + 1]);
+            at += 3;
+        }
+        if (function == "count" && (column.empty() || column == "*")) {
+            column = "";
+        } else if ((function != "sum" && function != "avg" && function != "min" && function != "max") || column.empty()) {
+            error = "Unknown aggregate: " + function + (column.empty() ? "" : "(" + column + ")");
+            return false;
+        }
+        wanted.push_back(make_pair(function, column));
+        if (at >= tokens.size() || tokens[at] != ",") break;
+        at++;
+    }
+
+    if (wanted.empty() || !takeKeyword(tokens, at, "from") || at >= tokens.size()) {
+        error = "Expected SELECT aggregates FROM courses, students or enrollments";
+        return false;
+    }
+    query.table = snapshot.table(toLowerCopy(tokens[at]));
+    if (query.table == NULL) {
+        error = "Unknown table: " + tokens[at] + " (courses, students, enrollments)";
+        return false;
+    }
+    at++;
+    AnalyticsTable& table = *query.table;
+
+    for (size_t i = 0; i < wanted.size(); i++) {
+        AnalyticsAggregate aggregate;
+        aggregate.function = wanted[i].first;
+        aggregate.column = wanted[i].second.empty() ? -1 : table.find(wanted[i].second);
+        aggregate.label = wanted[i].second.empty() ? "count" : aggregate.function + "(" + wanted[i].second + ")";
+        if (!wanted[i].second.empty() && (aggregate.column < 0 || table.columns[aggregate.column].text)) {
+            error = "No numeric column " + wanted[i].second + " in " + table.name;
+            return false;
+        }
+        query.aggregates.push_back(aggregate);
+    }
+
+    if (takeKeyword(tokens, at, "where")) {
+        do {
+            if (at + 2 >= tokens.size()) {
+                error = "Expected WHERE column op value";
+                return false;
+            }
+            AnalyticsCondition condition;
+            condition.column = table.find(toLowerCopy(tokens[at]));
+            condition.op = tokens[at + 1];
+            string value = tokens[at + 2];
+            at += 3;
+            if (condition.column < 0) {
+                error = "No column " + tokens[at - 3] + " in " + table.name;
+                return false;
+            }
+            if (condition.op != "=" && condition.op != "!=" && condition.op != "<" && condition.op != "<=" &&
+                condition.op != ">" && condition.op != ">=" && condition.op != "^") {
+                error = "Unknown operator: " + condition.op;
+                return false;
+            }
+            if (!value.empty() && (value[0] == '\'' || value[0] == '"')) value.erase(0, 1);
+            condition.text = value;
+            if (!table.columns[condition.column].text) {
+                char* end;
+                condition.number = strtod(value.c_str(), &end);
+                if (value.empty() || *end != '\0' || condition.op == "^") {
+                    error = table.columns[condition.column].name + " is numeric; compare it with a number";
+                    return false;
+                }
+            }
+            query.where.push_back(condition);
+        } while (takeKeyword(tokens, at, "and"));
+    }
+
+    if (takeKeyword(tokens, at, "group")) {
+        if (!takeKeyword(tokens, at, "by") || at >= tokens.size() || (query.groupBy = table.find(toLowerCopy(tokens[at]))) < 0) {
+            error = "Expected GROUP BY and a column of " + table.name;
+            return false;
+        }
+        at++;
+    }
+    if (takeKeyword(tokens, at, "order")) {
+        if (!takeKeyword(tokens, at, "by") || at >= tokens.size()) {
+            error = "Expected ORDER BY and a result column";
+            return false;
+        }
+        // A label like avg(fill) arrives as four tokens
+        query.orderBy = toLowerCopy(tokens[at++]);
+        if (at + 2 < tokens.size() && tokens[at] == "(") {
+            query.orderBy += "(" + toLowerCopy(tokens[at + 1]) + ")";
+            at += 3;
+        }
+        if (takeKeyword(tokens, at, "desc")) query.descending = true;
+        else takeKeyword(tokens, at, "asc");
+    }
+    if (takeKeyword(tokens, at, "limit")) {
+        if (at >= tokens.size() || (query.limit = atoi(tokens[at].c_str())) <= 0) {
+            error = "Expected LIMIT and a positive number";
+            return false;
+        }
+        at++;
+    }
+    if (at < tokens.size()) {
+        error = "Unexpected " + tokens[at];
+        return false;
+    }
+    return true;
+}
+
+// Clears mask[i] for every row that fails the condition
+void applyAnalyticsCondition(const AnalyticsColumn& column, const AnalyticsCondition& condition, vector<char>& mask) {
+    char* m = mask.data();
+    int rows = mask.size();
+    if (column.text) {
+        vector<char> hit(column.dictionary.size());
+        for (size_t i = 0; i < hit.size(); i++) {
+            const string& value = column.dictionary[i];
+            int order = value.compare(condition.text);
+            const string& op = condition.op;
+            hit[i] = op == "^" ? value.compare(0, condition.text.size(), condition.text) == 0
+                   : op == "=" ? order == 0 : op == "!=" ? order != 0 : op == "<" ? order < 0
+                   : op == "<=" ? order <= 0 : op == ">" ? order > 0 : order >= 0;
+        }
+        const int* ids = column.ids.data();
+        for (int i = 0; i < rows; i++) m[i] &= hit[ids[i]];
+        return;
+    }
+
+    const double* v = column.numbers.data();
+    double x = condition.number;
+    if (condition.op == "=") for (int i = 0; i < rows; i++) m[i] &= v[i] == x;
+    else if (condition.op == "!=") for (int i = 0; i < rows; i++) m[i] &= v[i] != x;
+    else if (condition.op == "<") for (int i = 0; i < rows; i++) m[i] &= v[i] < x;
+    else if (condition.op == "<=") for (int i = 0; i < rows; i++) m[i] &= v[i] <= x;
+    else if (condition.op == ">") for (int i = 0; i < rows; i++) m[i] &= v[i] > x;
+    else for (int i = 0; i < rows; i++) m[i] &= v[i] >= x;
+}
+
+string analyticsNumber(double value) {
+    ostringstream out;
+    if (value == floor(value) && fabs(value) < 1e15) out << (long long)value;
+    else out << fixed << setprecision(3) << value;
+    return out.str();
+}
+
+// Runs a query on the snapshot and appends the result table, or the error, to out.
+// Returns false if the query could not be parsed.
+bool runAnalyticsQuery(AnalyticsSnapshot& snapshot, const string& text, string& out) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AnalyticsQuery query;
+    string error;
+    if (!parseAnalyticsQuery(snapshot, text, query, error)) {
+        out += "Error: " + error + "\n";
+        return false;
+    }
+    AnalyticsTable& table = *query.table;
+    int rows = table.rows;
+
+    vector<char> mask(rows, 1);
+    for (size_t i = 0; i < query.where.size(); i++) {
+        applyAnalyticsCondition(table.columns[query.where[i].column], query.where[i], mask);
+    }
+
+    // Dense group numbers: a text column's dictionary ids, or the distinct values of a numeric one.
+    // A grouped query over no rows has no groups, and group may then be NULL.
+    bool grouped = query.groupBy >= 0;
+    vector<int> numbered;
+    const int* group = NULL;
+    vector<string> keys(1, "");
+    if (query.groupBy >= 0 && table.columns[query.groupBy].text) {
+        group = table.columns[query.groupBy].ids.data();
+        keys = table.columns[query.groupBy].dictionary;
+    } else if (query.groupBy >= 0) {
+        const vector<double>& values = table.columns[query.groupBy].numbers;
+        keys.clear();
+        numbered.resize(rows);
+        // Small whole numbers such as years and credits are their own group numbers; other values are hashed
+        double low = HUGE_VAL, high = -HUGE_VAL;
+        bool whole = true;
+        for (int i = 0; i < rows; i++) {
+            low = min(low, values[i]);
+            high = max(high, values[i]);
+            whole = whole && values[i] == floor(values[i]);
+        }
+        if (rows > 0 && whole && high - low < 4096) {
+            for (int k = 0; k <= high - low; k++) keys.push_back(analyticsNumber(low + k));
+            for (int i = 0; i < rows; i++) numbered[i] = (int)(values[i] - low);
+        } else {
+            unordered_map<double, int> seen;
+            for (int i = 0; i < rows; i++) {
+                unordered_map<double, int>::iterator it = seen.find(values[i]);
+                if (it == seen.end()) {
+                    it = seen.insert(make_pair(values[i], (int)keys.size())).first;
+                    keys.push_back(analyticsNumber(values[i]));
+                }
+                numbered[i] = it->second;
+            }
+        }
+        group = numbered.data();
+    }
+    int groups = keys.size();
+
+    const char* m = mask.data();
+    vector<long long> count(groups, 0);
+    if (!grouped) {
+        long long matched = 0;
+        for (int i = 0; i < rows; i++) matched += m[i];
+        count[0] = matched;
+    } else {
+        for (int i = 0; i < rows; i++) count[group[i]] += m[i];
+    }
+
+    vector<vector<double> > results(query.aggregates.size());
+    for (size_t a = 0; a < query.aggregates.size(); a++) {
+        const AnalyticsAggregate& aggregate = query.aggregates[a];
+        vector<double>& result = results[a];
+        if (aggregate.column < 0) {
+            result.assign(count.begin(), count.end());
+            continue;
+        }
+        const double* v = table.columns[aggregate.column].numbers.data();
+        bool sum = aggregate.function == "sum" || aggregate.function == "avg";
+        bool lowest = aggregate.function == "min";
+        result.assign(groups, sum ? 0 : lowest ? HUGE_VAL : -HUGE_VAL);
+        double* r = result.data();
+        if (sum && !grouped) {
+            double total = 0;
+            for (int i = 0; i < rows; i++) total += m[i] ? v[i] : 0.0;
+            r[0] = total;
+        } else if (sum) {
+            for (int i = 0; i < rows; i++) r[group[i]] += m[i] ? v[i] : 0.0;
+        } else {
+            for (int i = 0; i < rows; i++) {
+                int g = grouped ? group[i] : 0;
+                if (m[i] && (lowest ? v[i] < r[g] : v[i] > r[g])) r[g] = v[i];
+            }
+        }
+        if (aggregate.function == "avg") {
+            for (int g = 0; g < groups; g++) r[g] = count[g] > 0 ? r[g] / count[g] : 0;
+        }
+    }
+
+    // Groups with matching rows, in key order unless ORDER BY names a result column
+    vector<int> order;
+    for (int g = 0; g < groups; g++) {
+        if (count[g] > 0 || !grouped) order.push_back(g);
+    }
+    int sortBy = -2; // -1 sorts by the group column
+    if (!query.orderBy.empty()) {
+        if (query.groupBy >= 0 && query.orderBy == table.columns[query.groupBy].name) sortBy = -1;
+        for (size_t a = 0; a < query.aggregates.size(); a++) {
+            if (query.aggregates[a].label == query.orderBy) sortBy = a;
+        }
+        if (sortBy == -2) {
+            out += "Error: ORDER BY must name the group column or one of the results\n";
+            return false;
+        }
+    }
+    bool numericKeys = query.groupBy >= 0 && !table.columns[query.groupBy].text;
+    stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        if (sortBy >= 0 && results[sortBy][a] != results[sortBy][b]) {
+            return query.descending ? results[sortBy][a] > results[sortBy][b] : results[sortBy][a] < results[sortBy][b];
+        }
+        bool less = numericKeys ? atof(keys[a].c_str()) < atof(keys[b].c_str()) : keys[a] < keys[b];
+        bool greater = numericKeys ? atof(keys[b].c_str()) < atof(keys[a].c_str()) : keys[b] < keys[a];
+        return sortBy == -1 && query.descending ? greater : less;
+    });
+    if (query.limit > 0 && (int)order.size() > query.limit) order.resize(query.limit);
+    double ms = elapsedMs(start);
+
+    string header = query.groupBy >= 0 ? table.columns[query.groupBy].name : "";
+    for (size_t a = 0; a < query.aggregates.size(); a++) header += (header.empty() ? "" : " | ") + query.aggregates[a].label;
+    out += header + "\n";
+    for (size_t k = 0; k < order.size(); k++) {
+        string line = query.groupBy >= 0 ? keys[order[k]] : "";
+        for (size_t a = 0; a < results.size(); a++) line += (line.empty() ? "" : " | ") + analyticsNumber(results[a][order[k]]);
+        out += line + "\n";
+    }
+    long long matched = 0;
+    for (int g = 0; g < groups; g++) matched += count[g];
+    ostringstream footer;
+    footer << order.size() << " row(s); " << matched << " of " << rows << " " << table.name << " matched in "
+           << fixed << setprecision(2) << ms << " ms\n";
+    out += footer.str();
+    return true;
+}
+
+void printAnalyticsTables(AnalyticsSnapshot& snapshot) {
+    AnalyticsTable* tables[] = { &snapshot.courses, &snapshot.students, &snapshot.enrollments };
+    for (int t = 0; t < 3; t++) {
+        cout << tables[t]->name << " (" << tables[t]->rows << " rows):";
+        for (size_t i = 0; i < tables[t]->columns.size(); i++) cout << " " << tables[t]->columns[i].name;
+        cout << "\n";
+    }
+}
+
+void staffAnalytics() {
+    if (!allStudentsLoaded()) return;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AnalyticsSnapshot snapshot;
+    snapshot.build();
+    cout << "\n=== Analytics ===\n";
+    cout << "Data copied in " << fixed << setprecision(1) << elapsedMs(start) << " ms. Tables and columns:\n";
+    printAnalyticsTables(snapshot);
+    cout << "Example: SELECT COUNT, AVG(fill) FROM courses WHERE capacity >= 50 GROUP BY faculty ORDER BY avg(fill) DESC LIMIT 5\n";
+    while (true) {
+        cout << "\nQuery (blank to return): ";
+        string line;
+        getline(cin, line);
+        if (line.empty()) return;
+        string out;
+        runAnalyticsQuery(snapshot, line, out);
+        cout << out;
+    }
+}
+
+// Synthetic Data
+// Fills the global trees and queue with generated students, courses and pending requests for benchmarks.
+string syntheticMatric(int i) {
+    static const char* programs[] = { "CS", "SE", "EC", "IT", "BI", "DE", "GR", "NS", "MM", "AI" };
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "A%02d%s%04d", 20 + (i / 10000) % 10, programs[(i / 100000) % 10], i % 10000);
+    return buffer;
+}
+
+string syntheticCourseCode(int i) {
+    static const char* faculties[] = { "SECJ", "SECR", "SECV", "SECI", "SECP", "SCSJ", "SECD", "SECB" };
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%s%04d", faculties[(i / 10000) % 8], i % 10000);
+    return buffer;
+}
+
+string syntheticCourseName(int i) {
+    static const char* topics[] = { "Data", "Network", "Software", "Database", "Operating", "Computer", "Web",
+                                    "Mobile", "Cloud", "Information", "Human", "Digital", "Parallel", "Machine" };
+    static const char* subjects[] = { "Structures", "Security", "Engineering", "Systems", "Programming",
+                                      "Graphics", "Analytics", "Architecture", "Interaction", "Learning", "Design" };
+    return string(topics[i % 14]) + " " + subjects[(i / 14) % 11] + " " + to_string(i / 154 + 1);
+}
+
+void generateSyntheticData(int numStudents, int numCourses, int requestsPerStudent, unsigned seed) {
+    static const char* programNames[] = {
+        "Computer Science (Data Engineering)", "Computer Science (Network and Security)",
+        "Computer Science (Bioinformatics)", "Software Engineering", "Information Technology"
+    };
+    srand(seed);
+
+    // Insert in shuffled order so the unbalanced BSTs stay shallow
+    vector<int> order(numCourses);
+    for (int i = 0; i < numCourses; i++) order[i] = i;
+    shuffleIndices(order);
+    vector<Course*> courses(numCourses);
+    for (int i = 0; i < numCourses; i++) {
+        int k = order[i];
+        Course* course = new Course(syntheticCourseCode(k), syntheticCourseName(k), "Lecturer " + to_string(k % 500),
+                                    2 + rand() % 3, 30 + rand() % 171, 0);
+        // A shard worker drops other shards' courses after drawing their numbers, so every worker sees the same data
+        if (shardCount > 0 && shardOf(course->details->courseCode, shardCount) != shardIndex) {
+            delete course;
+            courses[k] = NULL;
+            continue;
+        }
+        courseTree.insert(course);
+        courseIndex.add(course);
+        courses[k] = course;
+    }
+    courseCatalog.publish(courseTree);
+
+    order.resize(numStudents);
+    for (int i = 0; i < numStudents; i++) order[i] = i;
+    shuffleIndices(order);
+    vector<Student*> students(numStudents);
+    for (int i = 0; i < numStudents; i++) {
+        int k = order[i];
+        Student* student = new Student("Student " + to_string(k), syntheticMatric(k), 12 + rand() % 9, 0,
+                                       1 + rand() % 4, programNames[rand() % 5]);
+        studentTree.insert(student);
+        studentIndex.add(student);
+        students[k] = student;
+    }
+
+    // Requests arrive interleaved across students, like registration day
+    for (int round = 0; round < requestsPerStudent; round++) {
+        for (int i = 0; i < numStudents; i++) {
+            Student* student = students[order[i]];
+            // Skew demand towards a popular subset of courses
+            int k = (rand() % 4 == 0) ? rand() % numCourses : rand() % (numCourses / 10 + 1);
+            Course* course = courses[k];
+            if (course == NULL || findCourseInStudent(student, course->codeKey, course->details->courseCode) != NULL) continue;
+            if (student->currentCredit + course->credit > student->maxCredit) continue;
+
+            regQueue.enqueue(student->profile->matricNo, student->profile->name, course->details->courseCode, course->details->courseName, course->credit);
+            addCourseToStudent(student, course->details->courseCode, "Pending");
+            adjustStudentCredit(student, course->credit, 0);
+        }
+    }
+}
+
+void shuffleIndices(vector<int>& v) {
+    for (int i = (int)v.size() - 1; i > 0; i--) {
+        unsigned r = ((unsigned)rand() << 15) ^ (unsigned)rand();
+        int j = r % (i + 1);
+        swap(v[i], v[j]);
+    }
+}
+
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void benchAllocation(int numStudents, int numCourses) {
+    cout << "Generating " << numStudents << " students x " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 6, 2043);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    SeatAllocator allocator;
+    int considered = allocator.build(regQueue);
+    double buildMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    int granted = allocator.solve();
+    double solveMs = elapsedMs(start);
+
+    int fcfs = allocator.fcfsCount();
+
+    start = chrono::steady_clock::now();
+    int approved, rejected;
+    allocator.apply(regQueue, approved, rejected);
+    double applyMs = elapsedMs(start);
+
+    cout << "Requests: " << considered << " (" << allocator.getOversubscribedCount() << " oversubscribed courses)\n";
+    cout << "Granted: " << granted << " vs FCFS " << fcfs << " (" << allocator.getSwapCount() << " swaps)\n";
+    cout << "Applied: " << approved << " approved, " << rejected << " rejected\n";
+    cout << fixed << setprecision(1);
+    cout << "Build " << buildMs << " ms, solve " << solveMs << " ms, apply " << applyMs << " ms\n";
+}
+
+void insertStudentInCourseList(Course* course, string matric, string name) {
+    StudentNode* newNode = new StudentNode(matric, name);
+    const PackedKey& key = newNode->key;
+    
+    if (course->studentList == NULL || compareKeys(course->studentList->key, course->studentList->matricNo, key, matric) > 0) {
+        newNode->next = course->studentList;
+        course->studentList = newNode;
+    } else {
+        StudentNode* temp = course->studentList;
+        while (temp->next != NULL && compareKeys(temp->next->key, temp->next->matricNo, key, matric) < 0) {
+            temp = temp->next;
+        }
+        newNode->next = temp->next;
+        temp->next = newNode;
+    }
+}
+
+void removeStudentFromCourseList(Course* course, string matric) {
+    if (course->studentList == NULL) return;
+    PackedKey key(matric);
+    
+    if (sameKey(course->studentList->key, course->studentList->matricNo, key, matric)) {
+        StudentNode* temp = course->studentList;
+        course->studentList = course->studentList->next;
+        delete temp;
+        return;
+    }
+    
+    StudentNode* temp = course->studentList;
+    while (temp->next != NULL && !sameKey(temp->next->key, temp->next->matricNo, key, matric)) {
+        temp = temp->next;
+    }
+    
+    if (temp->next != NULL) {
+        StudentNode* toDelete = temp->next;
+        temp->next = temp->next->next;
+        delete toDelete;
+    }
+}
+
+string getCurrentTimestamp(time_t t) {
+    time_t now = (t == 0) ? std::time(nullptr) : t;
+    tm* local = std::localtime(&now);
+    char buffer[20];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", local);
+    return buffer;
+}
+
+void easterEgg() {
+    int num=0;
+    if (rand() % 100000 == 0) {
+        cout << "500 Internal Server Error\n";
+        exit(0);
+    }
+}
+void benchSearch(int numCourses) {
+    cout << "Generating " << numCourses << " courses...\n";
+    generateSyntheticData(0, numCourses, 0, 2043);
+
+    const int rounds = 1000;
+    string prefixes[] = { "SECJ", "SECJ2", "SECR00", "SCSJ01" };
+    string substrings[] = { "network", "engineering 3", "lecturer 42", "0123" };
+    string typos[] = { "netwrok", "enginering", "strucutres", "leturer 7" };
+    string* groups[] = { prefixes, substrings, typos };
+    const char* names[] = { "prefix", "substring", "fuzzy" };
+
+    cout << fixed << setprecision(2);
+    for (int g = 0; g < 3; g++) {
+        long matches = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            string q = groups[g][r % 4];
+            vector<Course*> results;
+            if (g == 0) results = courseIndex.searchPrefix(q, 20);
+            else if (g == 1) results = courseIndex.searchSubstring(q, 20);
+            else results = courseIndex.searchFuzzy(q, 10);
+            matches += results.size();
+        }
+        double us = elapsedMs(start) * 1000.0 / rounds;
+        cout << names[g] << ": " << us << " us/query (" << matches / rounds << " results/query)\n";
+    }
+
+    // Incremental maintenance
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        Course* course = courseTree.search(syntheticCourseCode(i % numCourses));
+        courseIndex.remove(course);
+        courseIndex.add(course);
+    }
+    cout << "update: " << elapsedMs(start) * 1000.0 / rounds << " us/course\n";
+}
+
+// Catalog lookups from 1 to 32 reader threads while one writer tries to republish the catalog
+// every millisecond and keeps moving seat counts. The same lookups then run on one shared table
+// behind a reader-writer lock, with the writer editing it in place. Readers stop on their own
+// clock, since the writer may not get the lock at all while they run.
+void benchCatalog(int numCourses) {
+    cout << "Generating " << numCourses << " courses...\n";
+    generateSyntheticData(0, numCourses, 0, 2043);
+
+    vector<string> codes(numCourses);
+    vector<Course*> courses(numCourses);
+    for (int i = 0; i < numCourses; i++) {
+        codes[i] = syntheticCourseCode(i);
+        courses[i] = courseTree.search(codes[i]);
+    }
+    CatalogSnapshot locked;
+    {
+        CatalogRead catalog;
+        for (size_t i = 0; i < catalog->entries.size(); i++) locked.entries.push_back(new CatalogEntry(*catalog->entries[i]));
+        locked.keys = catalog->keys;
+    }
+    shared_mutex tableLock;
+
+    cout << fixed << setprecision(2);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < 100; i++) {
+        courses[i]->details->lecturerName = "Lecturer " + to_string(i);
+        courseCatalog.publishCourse(courses[i]->details->courseCode, courses[i]);
+    }
+    cout << "Publishing a snapshot after one course changed: " << elapsedMs(start) * 10 << " us\n";
+
+    const int durationMs = 500;
+    cout << "readers | lock-free Mreads/s  writes | rw-lock Mreads/s  writes\n";
+    for (int readers = 1; readers <= 32; readers *= 2) {
+        double rate[2];
+        long long writes[2];
+        for (int mode = 0; mode < 2; mode++) {
+            atomic<int> running(readers);
+            vector<long long> reads(readers, 0);
+            vector<thread> pool;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int r = 0; r < readers; r++) {
+                pool.push_back(thread([&, r]() {
+                    unsigned long long state = 88172645463325252ULL + r;
+                    long long count = 0, checksum = 0;
+                    while (elapsedMs(start) < durationMs) {
+                        for (int k = 0; k < 256; k++) {
+                            state ^= state << 13;
+                            state ^= state >> 7;
+                            state ^= state << 17;
+                            const string& code = codes[state % numCourses];
+                            if (mode == 0) {
+                                CatalogRead catalog;
+                                const CatalogEntry* entry = catalog->find(code);
+                                checksum += entry->credit + entry->seatsTaken() + entry->lecturerName.size();
+                            } else {
+                                shared_lock<shared_mutex> guard(tableLock);
+                                const CatalogEntry* entry = locked.find(code);
+                                checksum += entry->credit + entry->seatsTaken() + entry->lecturerName.size();
+                            }
+                        }
+                        count += 256;
+                    }
+                    reads[r] = count + (checksum == -1);
+                    running--;
+                }));
+            }
+
+            writes[mode] = 0;
+            while (running > 0) {
+                Course* course = courses[writes[mode] % numCourses];
+                string lecturer = "Lecturer " + to_string(writes[mode] % 500);
+                if (mode == 0) {
+                    course->details->lecturerName = lecturer;
+                    courseCatalog.publishCourse(course->details->courseCode, course);
+                } else {
+                    unique_lock<shared_mutex> guard(tableLock);
+                    CatalogEntry* entry = const_cast<CatalogEntry*>(locked.find(course->details->courseCode));
+                    entry->lecturerName = lecturer;
+                }
+                for (int s = 0; s < 100; s++) {
+                    Course* seated = courses[(writes[mode] * 100 + s) % numCourses];
+                    seated->currentCapacity++;
+                    seated->currentCapacity--;
+                }
+                writes[mode]++;
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            for (int r = 0; r < readers; r++) pool[r].join();
+
+            long long total = 0;
+            for (int r = 0; r < readers; r++) total += reads[r];
+            rate[mode] = total / (durationMs / 1000.0) / 1e6;
+        }
+        cout << setw(7) << readers << " | " << setw(18) << rate[0] << setw(8) << writes[0]
+             << " | " << setw(16) << rate[1] << setw(8) << writes[1] << "\n";
+    }
+    cout << "Catalog version " << courseCatalog.getVersion() << ", " << courseCatalog.retiredCount()
+         << " replaced snapshot(s) still waiting for readers\n";
+    for (size_t i = 0; i < locked.entries.size(); i++) delete locked.entries[i];
+}
+
+// Matric lookups on n students with string keys against packed keys: a walk down the student
+// BST, a binary search of a sorted key array, and a linear scan of the array.
+void benchPackedKeys(int numStudents) {
+    cout << "Generating " << numStudents << " students...\n";
+    generateSyntheticData(numStudents, 1000, 0, 2043);
+
+    const int lookups = 1000000;
+    vector<string> queries(lookups);
+    vector<PackedKey> packedQueries(lookups);
+    for (int i = 0; i < lookups; i++) {
+        queries[i] = syntheticMatric(((unsigned)rand() << 15 ^ rand()) % numStudents);
+        packedQueries[i] = PackedKey(queries[i]);
+    }
+    cout << fixed << setprecision(1);
+
+    long long found = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        const string& matric = queries[i];
+        Student* cur = studentTree.getRoot();
+        while (cur != NULL && cur->profile->matricNo != matric) cur = matric < cur->profile->matricNo ? cur->left : cur->right;
+        found += cur != NULL;
+    }
+    double stringTree = elapsedMs(start) * 1e6 / lookups;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        const string& matric = queries[i];
+        const PackedKey& key = packedQueries[i];
+        Student* cur = studentTree.getRoot();
+        int order;
+        while (cur != NULL && (order = compareKeys(key, matric, cur->matricKey, cur->profile->matricNo)) != 0) {
+            cur = order < 0 ? cur->left : cur->right;
+        }
+        found += cur != NULL;
+    }
+    double packedTree = elapsedMs(start) * 1e6 / lookups;
+    cout << "Tree walk: string " << stringTree << " ns, packed " << packedTree << " ns ("
+         << stringTree / packedTree << "x), " << found / 2 << "/" << lookups << " found\n";
+
+    vector<string> sortedText;
+    vector<PackedKey> sortedKeys;
+    for (TreeCursor<Student> cursor(studentTree.getRoot()); cursor.hasNext();) {
+        Student* student = cursor.next();
+        sortedText.push_back(student->profile->matricNo);
+        sortedKeys.push_back(student->matricKey);
+    }
+    found = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        vector<string>::iterator it = lower_bound(sortedText.begin(), sortedText.end(), queries[i]);
+        found += it != sortedText.end() && *it == queries[i];
+    }
+    double stringSearch = elapsedMs(start) * 1e6 / lookups;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        const PackedKey& key = packedQueries[i];
+        size_t lo = 0, hi = sortedKeys.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (sortedKeys[mid].hi < key.hi || (sortedKeys[mid].hi == key.hi && sortedKeys[mid].lo < key.lo)) lo = mid + 1;
+            else hi = mid;
+        }
+        found += lo < sortedKeys.size() && sortedKeys[lo].hi == key.hi && sortedKeys[lo].lo == key.lo;
+    }
+    double packedSearch = elapsedMs(start) * 1e6 / lookups;
+    cout << "Binary search: string " << stringSearch << " ns, packed " << packedSearch << " ns ("
+         << stringSearch / packedSearch << "x), " << found / 2 << "/" << lookups << " found\n";
+
+    // Every scan looks for a key at a random position, so each one reads half the array on average
+    const int scans = 200;
+    size_t positions = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < scans; i++) {
+        size_t j = 0;
+        while (j < sortedText.size() && sortedText[j] != queries[i]) j++;
+        positions += j;
+    }
+    double stringScan = elapsedMs(start) / scans;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < scans; i++) {
+        const PackedKey& key = packedQueries[i];
+        size_t j = 0;
+        while (j < sortedKeys.size() && !(sortedKeys[j].hi == key.hi && sortedKeys[j].lo == key.lo)) j++;
+        positions += j;
+    }
+    double packedScan = elapsedMs(start) / scans;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < scans; i++) positions += scanPackedKeys(&sortedKeys[0], sortedKeys.size(), packedQueries[i]);
+    double vectorScan = elapsedMs(start) / scans;
+
+    size_t keysRead = positions / (3 * scans);
+
+    // The same scans over the first 4096 keys, which stay in cache
+    const size_t window = min((size_t)4096, sortedKeys.size());
+    const int windowScans = 20000;
+    vector<PackedKey> windowTargets(windowScans);
+    for (int i = 0; i < windowScans; i++) windowTargets[i] = sortedKeys[rand() % window];
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < windowScans; i++) {
+        const PackedKey& key = windowTargets[i];
+        size_t j = 0;
+        while (j < window && !(sortedKeys[j].hi == key.hi && sortedKeys[j].lo == key.lo)) j++;
+        positions += j;
+    }
+    double packedWindow = elapsedMs(start) * 1000.0 / windowScans;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < windowScans; i++) positions += scanPackedKeys(&sortedKeys[0], window, windowTargets[i]);
+    double vectorWindow = elapsedMs(start) * 1000.0 / windowScans;
+#if defined(__AVX2__)
+    const char* kernel = "AVX2";
+#elif defined(__SSE2__)
+    const char* kernel = "SSE2";
+#else
+    const char* kernel = "scalar";
+#endif
+    cout << setprecision(2) << "Linear scan of " << sortedKeys.size() << " keys: string " << stringScan << " ms, packed "
+         << packedScan << " ms, " << kernel << " " << vectorScan << " ms (" << stringScan / vectorScan << "x vs string), "
+         << keysRead << " keys read per scan\n";
+    cout << "Linear scan of " << window << " cached keys: packed " << packedWindow << " us, " << kernel << " "
+         << vectorWindow << " us (" << packedWindow / vectorWindow << "x)" << (positions == 0 ? " (nothing found)" : "") << "\n";
+}
+
+// Admission checks and a first-come-first-served drain of the whole registration queue.
+// Each check looks up a random student and course and runs the checks registerCourse makes.
+void benchDrain(int numStudents, int numCourses) {
+    cout << "Generating " << numStudents << " students and " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 2, 2043);
+
+    const int checks = 1000000;
+    vector<string> matrics(checks), codes(checks);
+    for (int i = 0; i < checks; i++) {
+        matrics[i] = syntheticMatric(((unsigned)rand() << 15 ^ rand()) % numStudents);
+        codes[i] = syntheticCourseCode(rand() % numCourses);
+    }
+    int outcomes[4] = { 0, 0, 0, 0 };
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < checks; i++) {
+        outcomes[checkRegistration(studentTree.search(matrics[i]), courseTree.search(codes[i]))]++;
+    }
+    double checkMs = elapsedMs(start);
+    cout << fixed << setprecision(1);
+    cout << "Admission checks: " << checkMs * 1e6 / checks << " ns each (" << outcomes[REGISTER_OK] << " ok, "
+         << outcomes[REGISTER_DUPLICATE] << " duplicate, " << outcomes[REGISTER_OVER_CREDIT] << " over credit, "
+         << outcomes[REGISTER_FULL] << " full)\n";
+
+    int requests = 0, approved = 0;
+    start = chrono::steady_clock::now();
+    while (!regQueue.isEmpty()) {
+        RegistrationRequest* req = regQueue.getFront();
+        Student* student = studentTree.search(req->matricNo);
+        Course* course = courseTree.search(req->courseCode);
+        if (!req->isCancelled && student != NULL && course != NULL && approveRequest(req, student, course)) approved++;
+        delete regQueue.dequeue();
+        requests++;
+    }
+    double drainMs = elapsedMs(start);
+    cout << "Drain: " << requests << " requests in " << drainMs << " ms, " << requests / drainMs * 1000
+         << " requests/s (" << approved << " approved)\n";
+}
+
+// Package registration: submitting packages of five courses on generated data, then package seat
+// reservations from 1 to 32 threads over a few popular courses. Each thread keeps up to 16
+// packages and hands back the oldest before taking another; capacities leave about three seats
+// for every four wanted, so some packages find a full course and roll back. The compare-and-swap
+// reservation is compared with the same loop behind one global mutex.
+void benchPackages(int numStudents, int numCourses) {
+    const int perPackage = 5;
+    cout << "Generating " << numStudents << " students and " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 0, 2043);
+
+    vector<Student*> students;
+    TreeCursor<Student> cursor(studentTree.getRoot());
+    while (cursor.hasNext()) students.push_back(cursor.next());
+    vector<Course*> catalog;
+    for (int i = 0; i < numCourses; i++) catalog.push_back(courseTree.search(syntheticCourseCode(i)));
+
+    int submitted = 0, refused = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t s = 0; s < students.size(); s++) {
+        vector<Course*> package;
+        for (int k = 0; k < perPackage; k++) package.push_back(catalog[rand() % numCourses]);
+        int failed;
+        if (submitPackage(students[s], package, failed) == REGISTER_OK) submitted++;
+        else refused++;
+    }
+    double submitMs = elapsedMs(start);
+    cout << fixed << setprecision(1);
+    cout << "Submitting packages of " << perPackage << ": " << submitMs * 1e6 / students.size() << " ns each ("
+         << submitted << " queued, " << refused << " refused whole)\n";
+
+    int approved = 0;
+    start = chrono::steady_clock::now();
+    while (!regQueue.isEmpty()) {
+        RegistrationRequest* req = regQueue.getFront();
+        if (approveRequest(req, studentTree.search(req->matricNo), NULL)) approved++;
+        delete regQueue.dequeue();
+    }
+    double drainMs = elapsedMs(start);
+    cout << "Approving them: " << drainMs * 1e6 / submitted << " ns per package (" << approved << " approved, "
+         << submitted - approved << " auto-rejected whole)\n";
+
+    const int numHot = 16, held = 16, durationMs = 300;
+    vector<Course*> hot;
+    for (int i = 0; i < numHot; i++) hot.push_back(new Course(syntheticCourseCode(numCourses + i), "Popular", "", 3, 0, 0));
+    mutex globalLock;
+
+    cout << "threads | lock-free packages/s  rolled back | global lock packages/s  rolled back\n";
+    for (int threads = 1; threads <= 32; threads *= 2) {
+        for (int i = 0; i < numHot; i++) hot[i]->capacity = max(1, threads * held * perPackage * 3 / 4 / numHot);
+        double rate[2], rolledBack[2];
+        for (int mode = 0; mode < 2; mode++) {
+            vector<long long> taken(threads, 0), failed(threads, 0);
+            vector<thread> pool;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int t = 0; t < threads; t++) {
+                pool.push_back(thread([&, t]() {
+                    unsigned long long state = 88172645463325252ULL + t;
+                    Course* ring[held][perPackage];
+                    bool holding[held] = { false };
+                    for (int next = 0; elapsedMs(start) < durationMs; next = (next + 1) % held) {
+                        Course** package = ring[next];
+                        if (holding[next]) {
+                            if (mode == 0) releaseSeats(package, perPackage);
+                            else {
+                                lock_guard<mutex> guard(globalLock);
+                                releaseSeats(package, perPackage);
+                            }
+                        }
+                        for (int k = 0; k < perPackage; k++) {
+                            state ^= state << 13;
+                            state ^= state >> 7;
+                            state ^= state << 17;
+                            package[k] = hot[(state >> 8) % numHot];
+                        }
+                        int full;
+                        if (mode == 0) full = takeSeats(package, perPackage);
+                        else {
+                            lock_guard<mutex> guard(globalLock);
+                            full = takeSeats(package, perPackage);
+                        }
+                        holding[next] = full < 0;
+                        if (full < 0) taken[t]++;
+                        else failed[t]++;
+                    }
+                    for (int i = 0; i < held; i++) {
+                        if (holding[i]) releaseSeats(ring[i], perPackage);
+                    }
+                }));
+            }
+            for (int t = 0; t < threads; t++) pool[t].join();
+
+            long long ok = 0, bad = 0;
+            for (int t = 0; t < threads; t++) {
+                ok += taken[t];
+                bad += failed[t];
+            }
+            rate[mode] = (ok + bad) / (durationMs / 1000.0);
+            rolledBack[mode] = 100.0 * bad / max(1LL, ok + bad);
+        }
+        cout << setw(7) << threads << " | " << setw(20) << setprecision(0) << rate[0] << setw(11) << setprecision(1)
+             << rolledBack[0] << "% | " << setw(22) << setprecision(0) << rate[1] << setw(11) << setprecision(1)
+             << rolledBack[1] << "%\n";
+    }
+
+    int leaked = 0;
+    for (int i = 0; i < numHot; i++) {
+        leaked += hot[i]->currentCapacity;
+        delete hot[i];
+    }
+    cout << "Seats still taken after every package was handed back: " << leaked << "\n";
+}
+
+// Block registration of one program (about a fifth of the generated students) into six new
+// two-credit courses with room for all of them
+void benchCohort(int numStudents) {
+    cout << "Generating " << numStudents << " students...\n";
+    generateSyntheticData(numStudents, 200, 0, 2043);
+    vector<Course*> courses;
+    for (int i = 0; i < 6; i++) {
+        Course* course = new Course(syntheticCourseCode(200 + i), syntheticCourseName(200 + i), "Cohort Lecturer", 2, numStudents, 0);
+        courseTree.insert(course);
+        courses.push_back(course);
+    }
+
+    StudentFilter filter;
+    filter.program = "Information Technology";
+    CohortPlan plan;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool fits = planCohort(filter, courses, plan);
+    double planMs = elapsedMs(start);
+    start = chrono::steady_clock::now();
+    int enrolled = fits ? applyCohort(plan) : 0;
+    double applyMs = elapsedMs(start);
+
+    bool ordered = true;
+    for (size_t c = 0; c < courses.size(); c++) {
+        int listed = 0;
+        for (StudentNode* node = courses[c]->studentList; node != NULL; node = node->next, listed++) {
+            if (node->next != NULL && !(node->matricNo < node->next->matricNo)) ordered = false;
+        }
+        if (listed != courses[c]->currentCapacity) ordered = false;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "Cohort: " << plan.students.size() << " students, " << plan.overCredit << " skipped over their credit limit\n";
+    cout << "Plan: " << planMs << " ms, apply: " << applyMs << " ms for " << enrolled << " students and "
+         << plan.enrolments << " enrolments\n";
+    cout << "Course lists in matric order and matching seat counts: " << (ordered ? "yes" : "NO") << "\n";
+}
+
+// Counting and draining one course's requests through its lane, against walking the whole queue,
+// for a popular course and an unpopular one
+void benchCourseQueue(int numStudents, int numCourses) {
+    cout << "Generating " << numStudents << " students and " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 4, 2043);
+    cout << "Queue: " << regQueue.getLiveCount() << " pending requests\n";
+
+    string codes[2] = { syntheticCourseCode(0), syntheticCourseCode(numCourses - 1) };
+    cout << fixed << setprecision(2);
+    for (int i = 0; i < 2; i++) {
+        const string& code = codes[i];
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        int scanned = 0;
+        for (RegistrationRequest* req = regQueue.getFront(); req != NULL; req = req->next) {
+            if (!req->isCancelled && req->courseCode == code) scanned++;
+        }
+        double scanMs = elapsedMs(start);
+
+        const int lookups = 100000;
+        long long counted = 0;
+        start = chrono::steady_clock::now();
+        for (int k = 0; k < lookups; k++) counted += regQueue.getPendingFor(code);
+        double countNs = elapsedMs(start) * 1e6 / lookups;
+
+        Course* course = courseTree.search(code);
+        int approved = 0, drained = 0;
+        start = chrono::steady_clock::now();
+        RegistrationRequest* req;
+        while ((req = regQueue.firstFor(code)) != NULL) {
+            if (approveRequest(req, studentTree.search(req->matricNo), course)) approved++;
+            regQueue.remove(req);
+            delete req;
+            drained++;
+        }
+        double drainMs = elapsedMs(start);
+
+        cout << code << (i == 0 ? " (popular)" : " (unpopular)") << ": " << counted / lookups << " pending (scan found " << scanned << ")\n";
+        cout << "  count: " << countNs << " ns through the lane, " << scanMs << " ms walking the queue\n";
+        cout << "  drain: " << drained << " requests in " << drainMs << " ms (" << approved << " approved), "
+             << regQueue.getLiveCount() << " other requests left in order\n";
+    }
+}
+
+// Queue positions from the rank indexes, against counting live requests from the front,
+// after a quarter of the requests have been cancelled
+void benchQueuePosition(int numStudents, int numCourses) {
+    cout << "Generating " << numStudents << " students and " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 4, 2044);
+    vector<RegistrationRequest*> entries;
+    for (RegistrationRequest* req = regQueue.getFront(); req != NULL; req = req->next) {
+        if (!req->isCancelled) entries.push_back(req);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<RegistrationRequest*> kept;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (i % 4 == 1) markRequestAsCancelled(entries[i]->matricNo, entries[i]->courseCode);
+        else kept.push_back(entries[i]);
+    }
+    double cancelNs = elapsedMs(start) * 1e6 / (entries.size() / 4);
+    cout << "Queue: " << regQueue.getLiveCount() << " pending after cancelling " << entries.size() - kept.size()
+         << " (" << fixed << setprecision(1) << cancelNs << " ns per cancel)\n";
+
+    const int lookups = 200000;
+    long long checksum = 0;
+    start = chrono::steady_clock::now();
+    for (int k = 0; k < lookups; k++) {
+        RegistrationRequest* req = kept[((unsigned)rand() << 15 ^ rand()) % kept.size()];
+        RegistrationRequest* entry = regQueue.findPending(req->matricNo, req->courseCode);
+        checksum += regQueue.positionOf(entry) + regQueue.positionInCourse(entry);
+    }
+    double rankNs = elapsedMs(start) * 1e6 / lookups;
+
+    const int walks = 200;
+    int mismatches = 0;
+    start = chrono::steady_clock::now();
+    for (int k = 0; k < walks; k++) {
+        RegistrationRequest* req = kept[((unsigned)rand() << 15 ^ rand()) % kept.size()];
+        int global = 0, inCourse = 0;
+        for (RegistrationRequest* temp = regQueue.getFront(); temp != NULL; temp = temp->next) {
+            if (temp->isCancelled) continue;
+            global++;
+            if (temp->courseCode == req->courseCode) inCourse++;
+            if (temp == req) break;
+        }
+        if (global != regQueue.positionOf(req) || inCourse != regQueue.positionInCourse(req)) mismatches++;
+    }
+    double walkMs = elapsedMs(start) / walks;
+
+    cout << setprecision(3);
+    cout << "Position (queue and course): " << rankNs << " ns through the rank indexes, "
+         << walkMs << " ms counting from the front\n";
+    cout << "Walked positions matching the indexes: " << walks - mismatches << "/" << walks << " (checksum " << checksum << ")\n";
+}
+
+void benchStudentIndex(int numStudents) {
+    cout << "Generating " << numStudents << " students...\n";
+    generateSyntheticData(numStudents, 1000, 4, 2043);
+
+    StudentFilter filters[4];
+    filters[0].program = "Computer Science (Network and Security)";
+    filters[0].minYear = filters[0].maxYear = 4;
+    filters[1].minYear = 2;
+    filters[1].maxYear = 3;
+    filters[2].minHeadroom = 12;
+    filters[3].program = "Software Engineering";
+    filters[3].minHeadroom = 10;
+    const char* names[] = { "program+year", "year range", "headroom", "program+headroom" };
+
+    const int rounds = 50;
+    cout << fixed << setprecision(3);
+    for (int f = 0; f < 4; f++) {
+        vector<Student*> page;
+        int total = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) total = studentIndex.query(filters[f], 0, 20, page);
+        double indexMs = elapsedMs(start) / rounds;
+
+        // Baseline: full in-order walk of the tree
+        start = chrono::steady_clock::now();
+        int scanned = 0;
+        vector<Student*> stack;
+        Student* cur = studentTree.getRoot();
+        while (cur != NULL || !stack.empty()) {
+            while (cur != NULL) {
+                stack.push_back(cur);
+                cur = cur->left;
+            }
+            cur = stack.back();
+            stack.pop_back();
+            const StudentFilter& fl = filters[f];
+            if ((fl.program.empty() || cur->profile->program == fl.program) && (fl.minYear == 0 || cur->profile->year >= fl.minYear) &&
+                (fl.maxYear == 0 || cur->profile->year <= fl.maxYear) && cur->maxCredit - cur->currentCredit >= fl.minHeadroom) scanned++;
+            cur = cur->right;
+        }
+        double scanMs = elapsedMs(start);
+
+        cout << names[f] << ": " << total << " matches, index " << indexMs << " ms/page, tree scan " << scanMs
+             << " ms" << (scanned == total ? "" : " (MISMATCH)") << "\n";
+    }
+}
+
+void benchListing(int numStudents) {
+    cout << "Generating " << numStudents << " students...\n";
+    generateSyntheticData(numStudents, 0, 0, 2043);
+
+    // Discard the listing itself; only the time matters
+    ofstream sink;
+    streambuf* saved = cout.rdbuf(sink.rdbuf());
+    const int rounds = 1000;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) studentTree.displayPage("", LIST_PAGE_SIZE);
+    double firstMs = elapsedMs(start) / rounds;
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) studentTree.displayPage(syntheticMatric(rand() % numStudents), LIST_PAGE_SIZE);
+    double seekMs = elapsedMs(start) / rounds;
+
+    start = chrono::steady_clock::now();
+    int pages = 0;
+    string key = "";
+    do {
+        key = studentTree.displayPage(key, LIST_PAGE_SIZE);
+        pages++;
+    } while (!key.empty());
+    double allMs = elapsedMs(start);
+
+    cout.rdbuf(saved);
+    cout << fixed << setprecision(3);
+    cout << "First page: " << firstMs << " ms, page from random key: " << seekMs << " ms\n";
+    cout << "All " << pages << " pages: " << allMs << " ms\n";
+}
+
+// Builds degenerate (sorted-insert) trees, then saves, searches, deletes, destroys and reloads them.
+// Every walk is iterative, so the call stack stays flat however deep the trees get.
+void stressDeepTrees(int n) {
+    const char* studentFile = "stress_students.tmp";
+    const char* courseFile = "stress_courses.tmp";
+    char key[16];
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "A%08d", i);
+        Student* student = new Student("Student " + to_string(i), key, 20, 3, 1 + i % 4, "Software Engineering");
+        addCourseToStudent(student, "C0000000", "Approved");
+        studentTree.insert(student);
+
+        snprintf(key, sizeof(key), "C%07d", i);
+        Course* course = new Course(key, "Course " + to_string(i), "Lecturer", 3, 40, i == 0 ? 1 : 0);
+        if (i == 0) insertStudentInCourseList(course, "A00000000", "Student 0");
+        courseTree.insert(course);
+    }
+    cout << fixed << setprecision(1);
+    cout << "Sorted insert of " << n << " students and courses: " << elapsedMs(start) << " ms, heights "
+         << studentTree.height() << " / " << courseTree.height() << "\n";
+
+    start = chrono::steady_clock::now();
+    int found = 0;
+    for (int i = 0; i < 10; i++) {
+        snprintf(key, sizeof(key), "A%08d", (int)((long)n * i / 10));
+        if (studentTree.search(key) != NULL) found++;
+    }
+    cout << "10 searches on the degenerate tree: " << found << " found, " << elapsedMs(start) << " ms\n";
+
+    start = chrono::steady_clock::now();
+    saveStudents(studentFile);
+    saveCourses(courseFile);
+    cout << "Save: " << elapsedMs(start) << " ms\n";
+
+    start = chrono::steady_clock::now();
+    for (int i = 1; i <= 3; i++) {
+        snprintf(key, sizeof(key), "C%07d", n - i);
+        courseTree.deleteCourse(key);
+    }
+    snprintf(key, sizeof(key), "C%07d", n / 2);
+    courseTree.deleteCourse(key);
+    cout << "Delete 4 courses: " << elapsedMs(start) << " ms\n";
+
+    start = chrono::steady_clock::now();
+    studentTree.clear();
+    courseTree.clear();
+    cout << "Destroy: " << elapsedMs(start) << " ms\n";
+
+    start = chrono::steady_clock::now();
+    loadStudents(studentFile);
+    loadCourses(courseFile);
+    cout << "Reload: " << elapsedMs(start) << " ms, heights " << studentTree.height() << " / " << courseTree.height() << "\n";
+
+    start = chrono::steady_clock::now();
+    saveStudents(studentFile);
+    saveCourses(courseFile);
+    studentTree.clear();
+    courseTree.clear();
+    studentIndex.clear();
+    courseIndex.clear();
+    cout << "Save and destroy after reload: " << elapsedMs(start) << " ms\n";
+
+    remove(studentFile);
+    remove(courseFile);
+}
+
+// Cost of a span around a cheap operation, with tracing off and at several sampling rates
+void benchTrace() {
+    generateSyntheticData(0, 1000, 0, 2043);
+    const int spans = 1000000;
+    bool savedEnabled = tracingEnabled;
+    unsigned savedEvery = traceSampleEvery;
+    vector<string> codes;
+    for (int i = 0; i < 1000; i++) codes.push_back(syntheticCourseCode(i));
+
+    // Best of three runs per configuration; rate -1 is the unwrapped baseline, 0 is tracing off
+    int rates[] = { -1, 0, 1000, 100, 10, 1 };
+    double baseNs = 0;
+    long found = 0;
+    cout << fixed << setprecision(1);
+    for (int k = 0; k < 6; k++) {
+        tracingEnabled = rates[k] > 0;
+        traceSampleEvery = rates[k] > 0 ? rates[k] : 1;
+        double best = 1e18;
+        for (int run = 0; run < 3; run++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            if (rates[k] < 0) {
+                for (int i = 0; i < spans; i++) found += courseTree.search(codes[i % 1000]) != NULL;
+            } else {
+                for (int i = 0; i < spans; i++) {
+                    TRACE_SPAN(TRACE_REGISTER, "bench");
+                    found += courseTree.search(codes[i % 1000]) != NULL;
+                }
+            }
+            best = min(best, elapsedMs(start) * 1e6 / spans);
+        }
+
+        if (rates[k] < 0) {
+            baseNs = best;
+            cout << "Untraced lookup: " << best << " ns\n";
+            continue;
+        }
+        if (rates[k] == 0) cout << "Tracing off: ";
+        else cout << "Sampling 1/" << rates[k] << ": ";
+        char delta[32];
+        snprintf(delta, sizeof(delta), "%+.1f", best - baseNs);
+        cout << best << " ns (" << delta << " ns per span)\n";
+    }
+
+    tracingEnabled = savedEnabled;
+    traceSampleEvery = savedEvery;
+    if (found == 0) cout << "\n";
+}
+
+// Files per second for both export layouts, single-threaded and on the full pool
+void benchExport(int numStudents, int threads) {
+    int numCourses = max(1, numStudents / 30);
+    cout << "Generating " << numStudents << " students x " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 6, 2043);
+    SeatAllocator allocator;
+    allocator.build(regQueue);
+    allocator.solve();
+    int approved, rejected;
+    allocator.apply(regQueue, approved, rejected);
+    cout << approved << " approved registrations to export\n";
+
+    const string directory = "bench_export.tmp";
+    const string archive = "bench_export_archive.tmp";
+    int counts[] = { 1, threads };
+    cout << fixed << setprecision(0);
+    for (int layout = 0; layout < 2; layout++) {
+        for (int k = 0; k < 2; k++) {
+            if (k == 1 && threads == 1) break;
+            long long bytes = 0;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            int files = bulkExport(layout == 1, layout == 1 ? archive : directory, counts[k], bytes);
+            double ms = elapsedMs(start);
+            if (files < 0) {
+                cout << "Export failed.\n";
+                break;
+            }
+            cout << (layout == 1 ? "Archive" : "Files") << ", " << counts[k] << " thread(s): "
+                 << files << " in " << ms << " ms, " << files / (ms / 1000) << " files/s, "
+                 << bytes / (ms / 1000) / (1024 * 1024) << " MB/s\n";
+        }
+    }
+
+    error_code ec;
+    filesystem::remove_all(directory, ec);
+    remove(archive.c_str());
+}
+
+// Analytics: copies about a million enrollments into columns and times report queries on them. One
+// report is also written the way it would be today, as a walk over the live trees, for comparison.
+void benchAnalytics(int numStudents, int numCourses) {
+    // A grouped query before there is any data must come back with no rows
+    AnalyticsSnapshot empty;
+    empty.build();
+    string emptyOut;
+    const char* emptyQuery = "SELECT COUNT FROM enrollments GROUP BY status";
+    runAnalyticsQuery(empty, emptyQuery, emptyOut);
+    cout << emptyQuery << " with no data:\n" << emptyOut << "\n";
+
+    cout << "Generating " << numStudents << " students x " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 6, 2043);
+    // Approve the older half of the queue so there are approved and pending enrollments and fuller courses
+    for (int decided = regQueue.getLength() / 2; decided > 0 && !regQueue.isEmpty(); decided--) {
+        RegistrationRequest* req = regQueue.getFront();
+        Student* student = studentTree.search(req->matricNo);
+        Course* course = courseTree.search(req->courseCode);
+        if (!req->isCancelled && student != NULL && course != NULL) approveRequest(req, student, course);
+        delete regQueue.dequeue();
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    AnalyticsSnapshot snapshot;
+    snapshot.build();
+    cout << fixed << setprecision(1);
+    cout << "Copied " << snapshot.courses.rows << " courses, " << snapshot.students.rows << " students and "
+         << snapshot.enrollments.rows << " enrollments into columns in " << elapsedMs(start) << " ms\n";
+
+    const char* queries[] = {
+        "SELECT COUNT, SUM(enrolled), SUM(capacity), AVG(fill) FROM courses GROUP BY faculty",
+        "SELECT AVG(credits), AVG(approved), COUNT FROM students GROUP BY year",
+        "SELECT COUNT FROM courses WHERE fill > 0.9 GROUP BY lecturer ORDER BY count DESC LIMIT 5",
+        "SELECT COUNT, SUM(credit) FROM enrollments WHERE status = Approved GROUP BY faculty",
+        "SELECT COUNT, AVG(credit) FROM enrollments WHERE faculty = SECJ AND year >= 3 AND status = Pending GROUP BY program",
+        "SELECT COUNT FROM enrollments WHERE credit >= 3 GROUP BY year"
+    };
+    for (int q = 0; q < 6; q++) {
+        string out;
+        double best = 1e18;
+        for (int run = 0; run < 5; run++) {
+            out.clear();
+            chrono::steady_clock::time_point t = chrono::steady_clock::now();
+            runAnalyticsQuery(snapshot, queries[q], out);
+            best = min(best, elapsedMs(t));
+        }
+        cout << "\n" << queries[q] << "\n" << out << "Best of 5: " << setprecision(2) << best << " ms\n";
+    }
+
+    // The fourth report as a tree walk: every student's course list, and a course lookup per enrollment
+    start = chrono::steady_clock::now();
+    map<string, pair<long long, long long> > byFaculty;
+    for (TreeCursor<Student> cursor(studentTree.getRoot()); cursor.hasNext();) {
+        Student* student = cursor.next();
+        for (CourseNode* node = student->courseList; node != NULL; node = node->next) {
+            if (node->status != "Approved") continue;
+            Course* course = courseTree.search(node->courseCode);
+            if (course == NULL) continue;
+            pair<long long, long long>& total = byFaculty[node->courseCode.substr(0, 4)];
+            total.first++;
+            total.second += course->credit;
+        }
+    }
+    cout << "\nThe same approved-credit report as a walk over the live trees: " << elapsedMs(start) << " ms ("
+         << byFaculty.size() << " faculties)\n";
+}
+
+// Bytes currently resident for this process, or 0 where that cannot be read
+long long residentBytes() {
+#ifdef __linux__
+    long long pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (file == NULL) return 0;
+    if (fscanf(file, "%lld %lld", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+    return resident * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+// Writes a student file, then loads it in full and through the lazy cache and looks students up the same way
+// in both: 9 lookups in 10 go to the 2% of students active today, and every 16th changes a record.
+// Each side runs in its own process where fork is available, so neither reuses memory the other freed.
+void benchLazyStudents(int numStudents, int cacheSize) {
+    const char* studentFile = "bench_students.tmp";
+    const int numCourses = 3000, lookups = 1000000;
+    generateSyntheticData(0, numCourses, 0, 2043);
+    // In matric order, as saveStudents writes it
+    vector<string> matrics(numStudents);
+    for (int i = 0; i < numStudents; i++) matrics[i] = syntheticMatric(i);
+    sort(matrics.begin(), matrics.end());
+    ofstream file(studentFile);
+    srand(2044);
+    for (int i = 0; i < numStudents; i++) {
+        int courses = rand() % 6, credits = 0;
+        string lines;
+        for (int c = 0; c < courses; c++) {
+            Course* course = courseTree.search(syntheticCourseCode(rand() % numCourses));
+            credits += course->credit;
+            lines += "\n" + course->details->courseCode + (rand() % 3 == 0 ? "\tPending" : "\tApproved");
+        }
+        file << "Student " << i << "\t" << matrics[i] << "\t24\t" << credits << "\t" << 1 + i % 4
+             << "\tSoftware Engineering\t" << courses << lines << "\n";
+    }
+    file.close();
+    vector<string>().swap(matrics);
+
+    cout << numStudents << " students, " << lookups << " lookups\n" << fixed << setprecision(1);
+    for (int lazy = 0; lazy <= 1; lazy++) {
+#ifdef __linux__
+        cout << flush;
+        pid_t child = fork();
+        if (child != 0) {
+            waitpid(child, NULL, 0);
+            continue;
+        }
+#endif
+        long long before = residentBytes();
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (lazy) {
+            studentPager.open(studentFile, cacheSize);
+        } else {
+            loadStudents(studentFile);
+            initCreditTotals();
+        }
+        double loadMs = elapsedMs(start);
+        long long afterLoad = residentBytes();
+
+        srand(2045);
+        int found = 0;
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < lookups; i++) {
+            unsigned r = ((unsigned)rand() << 15) ^ (unsigned)rand();
+            int k = rand() % 10 < 9 ? r % ((numStudents + 49) / 50) * 50 : r % numStudents;
+            Student* student = studentTree.search(syntheticMatric(k));
+            if (student == NULL) continue;
+            found++;
+            if (i % 16 == 0) adjustStudentCredit(student, 1, 0);
+            studentPager.trim();
+        }
+        double lookupMs = elapsedMs(start);
+
+        cout << (lazy ? "Lazy, cache of " + to_string(cacheSize) + ": index " : string("Full load: load ")) << loadMs << " ms, "
+             << (afterLoad - before) / 1048576.0 << " MB resident after loading, "
+             << (residentBytes() - before) / 1048576.0 << " MB after lookups, "
+             << lookupMs * 1e6 / lookups << " ns per lookup (" << found << " found)\n";
+        if (lazy) studentPager.printStats();
+#ifdef __linux__
+        studentPager.close();
+        cout << flush;
+        _exit(0);
+#else
+        studentTree.clear();
+        studentIndex.clear();
+#endif
+    }
+    studentPager.close();
+    remove(studentFile);
+}
+
+// Random field values for the record fuzzer and benchmark. Wild values use every byte, tabs and line breaks
+// included, and numbers across the whole range; tame ones look like real data.
+struct RecordSampler {
+    unsigned long long state;
+    bool wild;
+    deque<string> texts; // the rows' text fields point in here
+
+    RecordSampler(unsigned long long seed, bool _wild) : state(seed * 2654435761ULL + 1), wild(_wild) {}
+
+    unsigned long long next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    void operator()(string_view& value) {
+        string text;
+        int length = wild ? next() % 24 : 4 + next() % 27;
+        for (int i = 0; i < length; i++) {
+            if (!wild) text += (char)('a' + next() % 26);
+            else if (next() % 8 == 0) text += "\t\n\r"[next() % 3];
+            else text += (char)(1 + next() % 255);
+        }
+        texts.push_back(text);
+        value = texts.back();
+    }
+
+    void operator()(int& value) {
+        unsigned long long r = next();
+        if (!wild) value = r % 10000;
+        else if (r % 4 == 0) value = r % 2 ? INT_MAX : INT_MIN;
+        else value = (int)(r >> 8) >> (r % 31);
+    }
+
+    void operator()(long long& value) {
+        unsigned long long r = next();
+        if (!wild) value = 1700000000 + r % 100000000;
+        else if (r % 4 == 0) value = r % 2 ? LLONG_MAX : LLONG_MIN;
+        else value = (long long)next() >> (r % 63);
+    }
+};
+
+// What a text field reads back as: formatField writes separators as spaces
+struct RecordSanitizer {
+    deque<string>& texts;
+
+    void operator()(string_view& value) {
+        string text(value);
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\t' || text[i] == '\n' || text[i] == '\r') text[i] = ' ';
+        }
+        texts.push_back(text);
+        value = texts.back();
+    }
+
+    void operator()(int&) {}
+    void operator()(long long&) {}
+};
+
+// Round trips random rows through format and parse, then parses randomly damaged lines: whatever parses
+// must format to a line that parses back to the same row. Returns the number of failures.
+template <class Schema, class Row>
+int fuzzSchema(const char* name, int iterations, unsigned seed) {
+    RecordSampler sampler(seed, true);
+    string line, again;
+    int failures = 0, accepted = 0;
+    for (int i = 0; i < iterations; i++) {
+        if (sampler.texts.size() > 4096) sampler.texts.clear();
+        Row row, parsed, reparsed;
+        Schema::visit(row, ref(sampler));
+        Row expected = row;
+        RecordSanitizer sanitize = { sampler.texts };
+        Schema::visit(expected, ref(sanitize));
+
+        line.clear();
+        Schema::format(row, line);
+        string_view text = line;
+        if (!Schema::parse(text, parsed) || !text.empty() || !Schema::equal(parsed, expected)) {
+            if (failures++ < 3) cout << name << ": round trip failed for \"" << line << "\"\n";
+            continue;
+        }
+
+        // Insert, delete or overwrite a few bytes, favouring separators, signs and digits
+        static const char damage[] = "\t\t\t-+09 x\x80\xff";
+        for (int edits = 1 + sampler.next() % 3; edits > 0; edits--) {
+            size_t at = sampler.next() % (line.size() + 1);
+            char c = damage[sampler.next() % (sizeof(damage) - 1)];
+            int kind = sampler.next() % 3;
+            if (kind == 0 || at == line.size()) line.insert(line.begin() + at, c);
+            else if (kind == 1) line.erase(at, 1);
+            else line[at] = c;
+        }
+        text = line;
+        if (!Schema::parse(text, parsed)) continue;
+        accepted++;
+        again.clear();
+        Schema::format(parsed, again);
+        string_view againText = again;
+        if (!Schema::parse(againText, reparsed) || !againText.empty() || !Schema::equal(parsed, reparsed)) {
+            if (failures++ < 3) cout << name << ": damaged line \"" << line << "\" did not round trip\n";
+        }
+    }
+    cout << left << setw(12) << name << right << iterations << " round trips, " << accepted
+         << " damaged lines still parsed, " << failures << " failure(s)\n";
+    return failures;
+}
+
+int fuzzRecords(int iterations, unsigned seed) {
+    int failures = 0;
+    failures += fuzzSchema<StudentSchema, StudentRow>("student", iterations, seed);
+    failures += fuzzSchema<EnrollmentSchema, EnrollmentRow>("enrollment", iterations, seed + 1);
+    failures += fuzzSchema<CourseSchema, CourseRow>("course", iterations, seed + 2);
+    failures += fuzzSchema<RosterSchema, RosterRow>("roster", iterations, seed + 3);
+    failures += fuzzSchema<StaffSchema, StaffRow>("staff", iterations, seed + 4);
+    failures += fuzzSchema<RequestSchema, RequestRow>("request", iterations, seed + 5);
+    return failures == 0 ? 0 : 1;
+}
+
+// Formats n realistic rows through a 64 KB buffer the way the savers do, then parses them back a line at a time
+template <class Schema, class Row>
+void benchSchema(const char* name, int n) {
+    RecordSampler sampler(n, false);
+    vector<Row> rows(n);
+    for (int i = 0; i < n; i++) Schema::visit(rows[i], ref(sampler));
+
+    string chunk;
+    long long written = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        Schema::format(rows[i], chunk);
+        chunk += '\n';
+        if (chunk.size() >= 65536) {
+            written += chunk.size();
+            chunk.clear();
+        }
+    }
+    double formatMs = elapsedMs(start);
+
+    string buffer;
+    for (int i = 0; i < n; i++) {
+        Schema::format(rows[i], buffer);
+        buffer += '\n';
+    }
+    if (written + (long long)chunk.size() != (long long)buffer.size()) cout << "Formatted sizes differ\n";
+
+    start = chrono::steady_clock::now();
+    int parsed = 0;
+    string_view rest = buffer;
+    while (!rest.empty()) {
+        size_t end = rest.find('\n');
+        string_view line = rest.substr(0, end);
+        rest = end == string_view::npos ? string_view() : rest.substr(end + 1);
+        Row row;
+        if (Schema::parse(line, row) && line.empty()) parsed++;
+    }
+    double parseMs = elapsedMs(start);
+
+    double mb = buffer.size() / 1048576.0;
+    cout << left << setw(12) << name << right << parsed << "/" << n << " records, " << mb << " MB: format "
+         << formatMs << " ms (" << mb / formatMs * 1000 << " MB/s), parse " << parseMs << " ms ("
+         << mb / parseMs * 1000 << " MB/s)\n";
+}
+
+void benchRecords(int n) {
+    cout << fixed << setprecision(1);
+    benchSchema<StudentSchema, StudentRow>("student", n);
+    benchSchema<EnrollmentSchema, EnrollmentRow>("enrollment", n);
+    benchSchema<CourseSchema, CourseRow>("course", n);
+    benchSchema<RosterSchema, RosterRow>("roster", n);
+    benchSchema<StaffSchema, StaffRow>("staff", n);
+    benchSchema<RequestSchema, RequestRow>("request", n);
+
+    // The same student lines through the substr/atoi/stream code the loaders and savers used before
+    RecordSampler sampler(n, false);
+    vector<StudentRow> rows(n);
+    for (int i = 0; i < n; i++) StudentSchema::visit(rows[i], ref(sampler));
+    ostringstream out;
+    string buffer;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        out << rows[i].name << "\t" << rows[i].matricNo << "\t" << rows[i].maxCredit << "\t" << rows[i].currentCredit
+            << "\t" << rows[i].year << "\t" << rows[i].program << "\t" << rows[i].courses << "\n";
+        if (out.tellp() >= 65536) {
+            buffer += out.str();
+            out.str("");
+        }
+    }
+    double formatMs = elapsedMs(start);
+    buffer += out.str();
+    istringstream in(buffer);
+    string line;
+    long long checksum = 0;
+    start = chrono::steady_clock::now();
+    while (getline(in, line)) {
+        size_t pos = 0, tab;
+        string fields[7];
+        for (int f = 0; f < 7; f++) {
+            tab = line.find('\t', pos);
+            fields[f] = line.substr(pos, tab - pos);
+            pos = tab + 1;
+        }
+        checksum += atoi(fields[2].c_str()) + atoi(fields[3].c_str()) + atoi(fields[4].c_str()) + atoi(fields[6].c_str());
+    }
+    double parseMs = elapsedMs(start);
+    double mb = buffer.size() / 1048576.0;
+    cout << "Student lines the old way (stream <<, substr + atoi): format " << formatMs << " ms (" << mb / formatMs * 1000
+         << " MB/s), parse " << parseMs << " ms (" << mb / parseMs * 1000 << " MB/s)" << (checksum < 0 ? "!" : "") << "\n";
+}
+
+// CPU time of the calling thread, or wall time where that cannot be read
+double threadCpuNs() {
+#ifdef __linux__
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+#else
+    return chrono::duration<double, nano>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Cost per change with the feed off, appending to a file, and also streaming to a subscriber that keeps up
+// or to one that never reads. Each step registers a student for a course and drops it again (two changes).
+// Wall time includes the feed thread's share of the CPU; the publisher's own CPU time is the hot-path cost.
+void benchChangeFeed(int mutations, int capacity) {
+    const char* feedFile = "bench_changes.tmp";
+    const int numStudents = 100000, numCourses = 3000;
+    cout << "Generating " << numStudents << " students x " << numCourses << " courses...\n";
+    generateSyntheticData(numStudents, numCourses, 0, 2043);
+    vector<Student*> students;
+    TreeCursor<Student> cursor(studentTree.getRoot());
+    while (cursor.hasNext()) students.push_back(cursor.next());
+    vector<Course*> catalog;
+    for (int i = 0; i < numCourses; i++) catalog.push_back(courseTree.search(syntheticCourseCode(i)));
+
+#ifdef __linux__
+    const int configs = 4;
+#else
+    const int configs = 2;
+#endif
+    const char* names[] = { "Feed off", "File", "File + subscriber", "File + stalled subscriber" };
+    double baseNs = 0, baseCpuNs = 0;
+    cout << fixed << setprecision(1);
+    for (int k = 0; k < configs; k++) {
+        // Best of three runs
+        double best = 1e18, bestCpu = 1e18;
+        long long dropped = 0, delivered = 0, received = 0;
+        for (int run = 0; run < 3; run++) {
+            remove(feedFile);
+            atomic<long long> lines(0);
+            thread reader;
+            int stalled = -1;
+            if (k > 0) {
+                FileChangeSink* file = new FileChangeSink();
+                file->open(feedFile);
+                changeFeed.addSink(file);
+#ifdef __linux__
+                if (k >= 2) {
+                    SocketChangeSink* sink = new SocketChangeSink();
+                    sink->listen(0);
+                    changeFeed.addSink(sink);
+                    sockaddr_in address;
+                    memset(&address, 0, sizeof(address));
+                    address.sin_family = AF_INET;
+                    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                    address.sin_port = htons(sink->port());
+                    int fd = socket(AF_INET, SOCK_STREAM, 0);
+                    if (connect(fd, (sockaddr*)&address, sizeof(address)) < 0) cout << "Subscriber cannot connect.\n";
+                    if (k == 3) {
+                        // Keep the receive buffer small so the backlog limit is reached quickly
+                        int size = 4096;
+                        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+                        stalled = fd;
+                    } else {
+                        reader = thread([fd, &lines]() {
+                            char buffer[65536];
+                            ssize_t n;
+                            while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                                long long count = 0;
+                                for (ssize_t i = 0; i < n; i++) count += buffer[i] == '\n';
+                                lines += count;
+                            }
+                            close(fd);
+                        });
+                    }
+                }
+#endif
+                changeFeed.start(capacity);
+                changeFeedOn = true;
+                this_thread::sleep_for(chrono::milliseconds(20)); // let the feed thread accept the subscriber
+            }
+
+            double cpuStart = threadCpuNs();
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int i = 0; i < mutations / 2; i++) {
+                Student* student = students[i % students.size()];
+                Course* course = catalog[i % numCourses];
+                queueRegistration(student, course);
+                dropRegisteredCourse(student, findCourseInStudent(student, course->codeKey, course->details->courseCode),
+                                     course, regQueue.getRear());
+                delete regQueue.dequeue();
+            }
+            best = min(best, elapsedMs(start) * 1e6 / (mutations / 2 * 2));
+            bestCpu = min(bestCpu, (threadCpuNs() - cpuStart) / (mutations / 2 * 2));
+
+            if (k > 0) {
+                stopChangeFeed();
+                dropped = changeFeed.dropped();
+                delivered = changeFeed.delivered();
+            }
+#ifdef __linux__
+            if (reader.joinable()) reader.join();
+            if (stalled >= 0) close(stalled);
+#endif
+            received = lines;
+        }
+
+        if (k == 0) {
+            baseNs = best;
+            baseCpuNs = bestCpu;
+            cout << names[k] << ": " << best << " ns per change (" << bestCpu << " ns CPU)\n";
+            continue;
+        }
+        char delta[64];
+        snprintf(delta, sizeof(delta), "%+.1f ns, publisher CPU %+.1f ns", best - baseNs, bestCpu - baseCpuNs);
+        cout << names[k] << ": " << best << " ns per change (" << delta << "), " << delivered << " delivered, "
+             << dropped << " dropped with the ring full";
+        if (k == 2) cout << ", " << received << " received";
+        cout << "\n";
+        if (k == configs - 1) changeFeed.printStats();
+    }
+    remove(feedFile);
+}
+
+// Registration-Day Simulator
+// Discrete-event model of registration opening: virtual students arrive in a burst, submit and drop
+// requests through the same paths as the menus, and staff drain the queue at a configured rate.
+// Pending events live in a hierarchical timing wheel keyed by simulated milliseconds.
+enum SimEventType { SIM_ARRIVE, SIM_REGISTER, SIM_DROP, SIM_STAFF, SIM_SAMPLE };
+
+struct SimEvent {
+    unsigned long long time;
+    int type;
+    int student;
+    int course;
+    long long ticket; // SIM_DROP: queue ticket of the registration being dropped
+    SimEvent* next;
+};
+
+// Four levels of 256 slots cover 2^32 ms (about 49 days) ahead of the current time; later events
+// wait in an overflow list. An event sits at the lowest level whose higher time bits match the
+// current time, and moves down a level each time the wheel below it completes a turn.
+class TimingWheel {
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    SimEvent* slots[LEVELS][SLOTS];
+    unsigned long long occupied[SLOTS / 64]; // level 0 slots that hold events
+    SimEvent* overflow;
+    unsigned long long now;
+    long long pending;
+    vector<SimEvent*> blocks;
+    SimEvent* freeList;
+
+    void place(SimEvent* e) {
+        unsigned long long t = e->time < now ? now : e->time;
+        for (int level = 0; level < LEVELS; level++) {
+            int shift = SLOT_BITS * (level + 1);
+            if ((t >> shift) == (now >> shift)) {
+                int slot = (t >> (SLOT_BITS * level)) & (SLOTS - 1);
+                e->next = slots[level][slot];
+                slots[level][slot] = e;
+                if (level == 0) occupied[slot / 64] |= 1ULL << (slot % 64);
+                return;
+            }
+        }
+        e->next = overflow;
+        overflow = e;
+    }
+
+    // Re-places every event of one slot after the time has moved into its range
+    void cascade(SimEvent*& head) {
+        SimEvent* e = head;
+        head = NULL;
+        while (e != NULL) {
+            SimEvent* next = e->next;
+            place(e);
+            e = next;
+        }
+    }
+
+    int nextOccupied(int from) {
+        for (int word = from / 64; word < SLOTS / 64; word++) {
+            unsigned long long bits = occupied[word];
+            if (word == from / 64) bits &= ~0ULL << (from % 64);
+            if (bits != 0) return word * 64 + __builtin_ctzll(bits);
+        }
+        return -1;
+    }
+
+public:
+    TimingWheel() : overflow(NULL), now(0), pending(0), freeList(NULL) {
+        for (int level = 0; level < LEVELS; level++) {
+            for (int slot = 0; slot < SLOTS; slot++) slots[level][slot] = NULL;
+        }
+        for (int w = 0; w < SLOTS / 64; w++) occupied[w] = 0;
+    }
+
+    SimEvent* allocate() {
+        if (freeList == NULL) {
+            const int blockSize = 4096;
+            SimEvent* block = new SimEvent[blockSize];
+            blocks.push_back(block);
+            for (int i = 0; i < blockSize; i++) {
+                block[i].next = freeList;
+                freeList = &block[i];
+            }
+        }
+        SimEvent* e = freeList;
+        freeList = e->next;
+        return e;
+    }
+
+    void release(SimEvent* e) {
+        e->next = freeList;
+        freeList = e;
+    }
+
+    void schedule(unsigned long long time, int type, int student, int course, long long ticket = -1) {
+        SimEvent* e = allocate();
+        e->time = time;
+        e->type = type;
+        e->student = student;
+        e->course = course;
+        e->ticket = ticket;
+        place(e);
+        pending++;
+    }
+
+    // Moves the clock to the next occupied millisecond and unlinks every event due then.
+    // Returns NULL when nothing is scheduled.
+    SimEvent* advance() {
+        if (pending == 0) return NULL;
+        while (true) {
+            int slot = nextOccupied(now & (SLOTS - 1));
+            if (slot >= 0) {
+                now = (now & ~(unsigned long long)(SLOTS - 1)) | slot;
+                SimEvent* due = slots[0][slot];
+                slots[0][slot] = NULL;
+                occupied[slot / 64] &= ~(1ULL << (slot % 64));
+                for (SimEvent* e = due; e != NULL; e = e->next) pending--;
+                return due;
+            }
+
+            // Nothing left in this turn of level 0: jump to the next turn and pull the higher levels down
+            now = (now | (SLOTS - 1)) + 1;
+            if ((now & 0xFFFFFFFFULL) == 0) cascade(overflow);
+            for (int level = LEVELS - 1; level >= 1; level--) {
+                int shift = SLOT_BITS * level;
+                if ((now & ((1ULL << shift) - 1)) == 0) cascade(slots[level][(now >> shift) & (SLOTS - 1)]);
+            }
+        }
+    }
+
+    unsigned long long getNow() {
+        return now;
+    }
+
+    ~TimingWheel() {
+        for (size_t i = 0; i < blocks.size(); i++) delete[] blocks[i];
+    }
+};
+
+// xorshift64* in [0, 1); rand() is too coarse for millions of draws
+double simUniform(unsigned long long& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return ((state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+unsigned long long simExponential(unsigned long long& state, double mean) {
+    return (unsigned long long)(-mean * log(1.0 - simUniform(state)));
+}
+
+struct SimConfig {
+    int students;
+    int courses;
+    int requestsPerStudent;
+    double burstShare;          // fraction of students who arrive in the opening burst
+    double burstMeanMs;         // mean delay after opening for burst arrivals
+    double dayMs;               // everyone else arrives uniformly within this window
+    double thinkMeanMs;         // mean gap between one student's submissions
+    double dropProbability;     // chance a successful submission is later dropped
+    double dropDelayMeanMs;
+    int staffCount;
+    double serviceMeanMs;       // mean time for one staff member to decide one request
+    double rejectProbability;   // share of decisions that are manual rejections
+    unsigned long long sampleMs;
+    string outputPrefix;
+
+    SimConfig() : students(1000000), courses(20000), requestsPerStudent(6), burstShare(0.7), burstMeanMs(120000),
+                  dayMs(8 * 3600000.0), thinkMeanMs(20000), dropProbability(0.1), dropDelayMeanMs(1800000),
+                  staffCount(200), serviceMeanMs(800), rejectProbability(0.02), sampleMs(60000),
+                  outputPrefix("simulation") {}
+};
+
+// One queue entry as the simulator sees it, kept in the same order as regQueue
+struct SimTicket {
+    RegistrationRequest* req;
+    int student;
+    int course;
+    unsigned long long submitted;
+};
+
+class RegistrationSimulator {
+private:
+    SimConfig config;
+    TimingWheel wheel;
+    vector<Student*> students;
+    vector<Course*> courses;
+    vector<int> remaining; // submissions each student still plans to make
+    vector<SimTicket> tickets;
+    size_t ticketHead;     // index of the ticket at the front of regQueue
+    long long ticketBase;  // ticket number of tickets[0]
+    unsigned long long rng;
+    long long activeEvents; // arrivals, submissions and drops not yet handled
+    int idleStaff;
+
+    long long events;
+    long long submitted, refusedFull, refusedCredit, duplicates;
+    long long approved, autoRejected, rejected, droppedPending, droppedApproved;
+    vector<unsigned long long> waitBuckets;
+    unsigned long long waitCount, waitMax;
+
+    vector<int> trackedCourses;
+    FILE* queueCsv;
+    FILE* fillCsv;
+
+    double uniform() {
+        return simUniform(rng);
+    }
+
+    unsigned long long exponential(double mean) {
+        return simExponential(rng, mean);
+    }
+
+    // Same skew as the synthetic generator: most demand goes to a popular tenth of the catalog
+    int pickCourse() {
+        int popular = courses.size() / 10 + 1;
+        if (uniform() < 0.75) return (int)(uniform() * popular);
+        return (int)(uniform() * courses.size());
+    }
+
+    void submit(int s, unsigned long long now) {
+        Student* student = students[s];
+        int c = pickCourse();
+        Course* course = courses[c];
+        RegisterResult result = submitRegistration(student, course);
+        if (result == REGISTER_DUPLICATE) duplicates++;
+        else if (result == REGISTER_OVER_CREDIT) refusedCredit++;
+        else if (result == REGISTER_FULL) refusedFull++;
+        else {
+            submitted++;
+            SimTicket ticket = { regQueue.getRear(), s, c, now };
+            tickets.push_back(ticket);
+            if (idleStaff > 0) {
+                idleStaff--;
+                wheel.schedule(now + 1 + exponential(config.serviceMeanMs), SIM_STAFF, -1, -1);
+            }
+            if (uniform() < config.dropProbability) {
+                wheel.schedule(now + exponential(config.dropDelayMeanMs), SIM_DROP, s, c,
+                               ticketBase + (long long)tickets.size() - 1);
+                activeEvents++;
+            }
+        }
+    }
+
+    void drop(SimEvent* e) {
+        Student* student = students[e->student];
+        Course* course = courses[e->course];
+        CourseNode* courseNode = findCourseInStudent(student, course->codeKey, course->details->courseCode);
+        if (courseNode == NULL) return; // rejected before the student got round to dropping it
+
+        RegistrationRequest* req = NULL;
+        if (courseNode->status == "Pending") {
+            long long index = e->ticket - ticketBase;
+            if (index >= (long long)ticketHead && index < (long long)tickets.size()) req = tickets[index].req;
+            droppedPending++;
+        } else {
+            droppedApproved++;
+        }
+        dropRegisteredCourse(student, courseNode, course, req);
+    }
+
+    void popTicket() {
+        ticketHead++;
+        // Compact once the decided prefix is the larger half, so memory follows the queue length
+        if (ticketHead >= 65536 && ticketHead * 2 >= tickets.size()) {
+            tickets.erase(tickets.begin(), tickets.begin() + ticketHead);
+            ticketBase += ticketHead;
+            ticketHead = 0;
+        }
+    }
+
+    // One staff decision. Cancelled requests at the front are skipped without using up the decision,
+    // as in staffViewRequests. Returns false if nothing live was left to decide.
+    bool decide(unsigned long long now) {
+        while (!regQueue.isEmpty()) {
+            RegistrationRequest* req = regQueue.getFront();
+            SimTicket ticket = tickets[ticketHead];
+            bool live = !req->isCancelled;
+            if (live) {
+                Student* student = students[ticket.student];
+                Course* course = courses[ticket.course];
+                if (uniform() < config.rejectProbability) {
+                    if (rejectRequest(req, student, "Simulated rejection")) rejected++;
+                } else if (approveRequest(req, student, course)) {
+                    approved++;
+                    unsigned long long wait = now - ticket.submitted;
+                    waitBuckets[histogramBucket(wait)]++;
+                    waitCount++;
+                    waitMax = max(waitMax, wait);
+                } else {
+                    autoRejected++;
+                }
+            }
+            delete regQueue.dequeue();
+            popTicket();
+            if (live) return true;
+        }
+        return false;
+    }
+
+    void sample(unsigned long long now) {
+        int full = 0;
+        for (size_t c = 0; c < courses.size(); c++) {
+            if (courses[c]->currentCapacity >= courses[c]->capacity) full++;
+        }
+        if (regQueue.getLiveCount() > peakQueue) {
+            peakQueue = regQueue.getLiveCount();
+            peakQueueTime = now;
+        }
+        queueRows.push_back(now);
+        queueRows.push_back(regQueue.getLiveCount());
+        if (queueCsv != NULL) {
+            fprintf(queueCsv, "%.0f,%d,%d,%lld,%lld,%d\n", now / 1000.0, regQueue.getLiveCount(),
+                    regQueue.getLength(), approved, autoRejected + rejected, full);
+        }
+        if (fillCsv != NULL) {
+            fprintf(fillCsv, "%.0f", now / 1000.0);
+            for (size_t k = 0; k < trackedCourses.size(); k++) {
+                Course* course = courses[trackedCourses[k]];
+                fprintf(fillCsv, ",%.1f", 100.0 * course->currentCapacity / course->capacity);
+            }
+            fprintf(fillCsv, "\n");
+        }
+    }
+
+    void handle(SimEvent* e) {
+        unsigned long long now = e->time;
+        switch (e->type) {
+            case SIM_ARRIVE:
+                arrivals++;
+                remaining[e->student] = config.requestsPerStudent;
+                // The first submission happens on arrival
+                [[fallthrough]];
+            case SIM_REGISTER:
+                activeEvents--;
+                if (remaining[e->student] > 0) {
+                    remaining[e->student]--;
+                    submit(e->student, now);
+                }
+                if (remaining[e->student] > 0) {
+                    wheel.schedule(now + 1 + exponential(config.thinkMeanMs), SIM_REGISTER, e->student, -1);
+                    activeEvents++;
+                }
+                break;
+            case SIM_DROP:
+                activeEvents--;
+                drop(e);
+                break;
+            case SIM_STAFF:
+                if (decide(now)) {
+                    wheel.schedule(now + 1 + exponential(config.serviceMeanMs), SIM_STAFF, -1, -1);
+                } else {
+                    idleStaff++; // woken by the next submission
+                }
+                break;
+            case SIM_SAMPLE:
+                sample(now);
+                if (activeEvents > 0 || regQueue.getLiveCount() > 0) {
+                    wheel.schedule(now + config.sampleMs, SIM_SAMPLE, -1, -1);
+                }
+                break;
+        }
+    }
+
+public:
+    long long arrivals;
+    int peakQueue;
+    unsigned long long peakQueueTime;
+    vector<unsigned long long> queueRows; // time, live length pairs from each sample
+
+    RegistrationSimulator(const SimConfig& cfg)
+        : config(cfg), ticketHead(0), ticketBase(0), rng(0x9E3779B97F4A7C15ULL), activeEvents(0), idleStaff(0),
+          events(0), submitted(0), refusedFull(0), refusedCredit(0), duplicates(0), approved(0), autoRejected(0),
+          rejected(0), droppedPending(0), droppedApproved(0), waitBuckets(HISTOGRAM_BUCKETS, 0), waitCount(0),
+          waitMax(0), queueCsv(NULL), fillCsv(NULL), arrivals(0), peakQueue(0), peakQueueTime(0) {}
+
+    // Runs the whole day on the loaded trees (which must already hold the students and courses).
+    // Returns the number of events handled.
+    long long run() {
+        for (TreeCursor<Student> cursor(studentTree.getRoot()); cursor.hasNext();) students.push_back(cursor.next());
+        for (TreeCursor<Course> cursor(courseTree.getRoot()); cursor.hasNext();) courses.push_back(cursor.next());
+        if (students.empty() || courses.empty()) return 0;
+        remaining.assign(students.size(), 0);
+
+        // Fill curves for the most popular courses and a few from the long tail
+        int n = courses.size();
+        int picks[] = { 0, 1, 2, 3, 4, n / 10 + 1, n / 4, n / 2, n - 1 };
+        for (int k = 0; k < 9; k++) {
+            if (picks[k] < n && find(trackedCourses.begin(), trackedCourses.end(), picks[k]) == trackedCourses.end()) {
+                trackedCourses.push_back(picks[k]);
+            }
+        }
+
+        queueCsv = fopen((config.outputPrefix + "_queue.csv").c_str(), "w");
+        fillCsv = fopen((config.outputPrefix + "_fill.csv").c_str(), "w");
+        if (queueCsv != NULL) fprintf(queueCsv, "time_s,live_requests,queue_length,approved,rejected,full_courses\n");
+        if (fillCsv != NULL) {
+            fprintf(fillCsv, "time_s");
+            for (size_t k = 0; k < trackedCourses.size(); k++) {
+                fprintf(fillCsv, ",%s", courses[trackedCourses[k]]->details->courseCode.c_str());
+            }
+            fprintf(fillCsv, "\n");
+        }
+
+        // Superposing independent arrival times gives a Poisson stream whose rate decays after opening
+        for (size_t s = 0; s < students.size(); s++) {
+            unsigned long long at = uniform() < config.burstShare ? exponential(config.burstMeanMs)
+                                                                   : (unsigned long long)(uniform() * config.dayMs);
+            wheel.schedule(at, SIM_ARRIVE, s, -1);
+            activeEvents++;
+        }
+        for (int i = 0; i < config.staffCount; i++) {
+            wheel.schedule(exponential(config.serviceMeanMs), SIM_STAFF, -1, -1);
+        }
+        wheel.schedule(0, SIM_SAMPLE, -1, -1);
+
+        SimEvent* due;
+        while ((due = wheel.advance()) != NULL) {
+            while (due != NULL) {
+                SimEvent* next = due->next;
+                handle(due);
+                wheel.release(due);
+                events++;
+                due = next;
+            }
+        }
+        sample(wheel.getNow());
+
+        if (queueCsv != NULL) fclose(queueCsv);
+        if (fillCsv != NULL) fclose(fillCsv);
+        writeWaitCsv();
+        return events;
+    }
+
+    void writeWaitCsv() {
+        FILE* file = fopen((config.outputPrefix + "_wait.csv").c_str(), "w");
+        if (file == NULL) return;
+        fprintf(file, "wait_up_to_s,approvals\n");
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            if (waitBuckets[b] > 0) fprintf(file, "%.3f,%llu\n", histogramBucketLimit(b) / 1000.0, waitBuckets[b]);
+        }
+        fclose(file);
+    }
+
+    void printReport() {
+        int full = 0;
+        for (size_t c = 0; c < courses.size(); c++) {
+            if (courses[c]->currentCapacity >= courses[c]->capacity) full++;
+        }
+        cout << "Arrivals: " << arrivals << ", submissions: " << submitted << " (refused: " << refusedFull
+             << " full, " << refusedCredit << " over credit limit, " << duplicates << " duplicate)\n";
+        cout << "Decisions: " << approved << " approved, " << autoRejected << " auto-rejected (course full), "
+             << rejected << " rejected\n";
+        cout << "Drops: " << droppedPending << " pending, " << droppedApproved << " approved\n";
+        cout << "Courses full at end: " << full << "/" << courses.size() << "\n";
+        cout << fixed << setprecision(1);
+        cout << "Peak queue: " << peakQueue << " live request(s) at " << peakQueueTime / 60000.0 << " min\n";
+        cout << "Simulated time: " << wheel.getNow() / 3600000.0 << " h\n";
+        if (waitCount > 0) {
+            cout << "Time to approval (min): p50 " << histogramPercentile(waitBuckets, waitCount, waitMax, 50) / 60000.0
+                 << ", p90 " << histogramPercentile(waitBuckets, waitCount, waitMax, 90) / 60000.0
+                 << ", p99 " << histogramPercentile(waitBuckets, waitCount, waitMax, 99) / 60000.0
+                 << ", max " << waitMax / 60000.0 << "\n";
+        }
+
+        cout << "\nQueue length over time:\n";
+        size_t rows = queueRows.size() / 2;
+        size_t step = max((size_t)1, rows / 12);
+        for (size_t r = 0; r < rows; r += step) {
+            cout << setw(8) << queueRows[2 * r] / 60000.0 << " min  " << setw(9) << queueRows[2 * r + 1] << "\n";
+        }
+        cout << "\nFull series: " << config.outputPrefix << "_queue.csv, " << config.outputPrefix
+             << "_fill.csv (course fill curves), " << config.outputPrefix << "_wait.csv (time to approval)\n";
+    }
+};
+
+void runSimulation(const SimConfig& config) {
+    cout << "Generating " << config.students << " students x " << config.courses << " courses...\n";
+    generateSyntheticData(config.students, config.courses, 0, 2043);
+
+    RegistrationSimulator simulator(config);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    long long events = simulator.run();
+    double ms = elapsedMs(start);
+
+    cout << "\n=== Registration-Day Simulation ===\n";
+    cout << config.staffCount << " staff, " << config.requestsPerStudent << " submissions per student, "
+         << (int)(config.burstShare * 100) << "% of arrivals in the opening burst\n";
+    simulator.printReport();
+    cout << setprecision(2) << "\n" << events << " events in " << ms / 1000 << " s ("
+         << events / (ms / 1000) / 1e6 << " M events/s)\n";
+}
+
+// Scheduler cost alone, using a hold model: a fixed number of events stay pending and each one
+// handled schedules another an exponential delay later. The same workload then runs on a sorted multimap.
+void benchTimingWheel(long long totalEvents, int outstanding) {
+    const double meanMs = 60000;
+    unsigned long long rng = 2043;
+    TimingWheel wheel;
+    for (int i = 0; i < outstanding; i++) wheel.schedule(simExponential(rng, meanMs), SIM_REGISTER, i, -1);
+
+    long long handled = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (handled < totalEvents) {
+        SimEvent* due = wheel.advance();
+        while (due != NULL) {
+            SimEvent* next = due->next;
+            wheel.schedule(due->time + 1 + simExponential(rng, meanMs), SIM_REGISTER, due->student, -1);
+            wheel.release(due);
+            handled++;
+            due = next;
+        }
+    }
+    double wheelMs = elapsedMs(start);
+
+    rng = 2043;
+    multimap<unsigned long long, int> sorted;
+    for (int i = 0; i < outstanding; i++) sorted.insert(make_pair(simExponential(rng, meanMs), i));
+    start = chrono::steady_clock::now();
+    for (long long i = 0; i < totalEvents; i++) {
+        multimap<unsigned long long, int>::iterator first = sorted.begin();
+        unsigned long long time = first->first;
+        int student = first->second;
+        sorted.erase(first);
+        sorted.insert(make_pair(time + 1 + simExponential(rng, meanMs), student));
+    }
+    double sortedMs = elapsedMs(start);
+
+    cout << totalEvents << " events with " << outstanding << " pending:\n";
+    cout << fixed << setprecision(1);
+    cout << "Timing wheel: " << wheelMs << " ms (" << wheelMs * 1e6 / handled << " ns/event)\n";
+    cout << "Sorted map:   " << sortedMs << " ms (" << sortedMs * 1e6 / totalEvents << " ns/event)\n";
+}
+
+// Network Server
+// Serves the student and staff operations to many clients at once over a line protocol on a
+// localhost TCP socket. One request per line, one response line per request, starting with OK or ERR.
+// All sessions share a single epoll loop, so the trees and queue are only touched from one thread.
+const char* SERVER_HELP = "LOGIN id | COURSE code | SEARCH text | REGISTER code [code...] | DROP code | MYCOURSES"
+                          " | NEXT | APPROVE | REJECT reason | PENDING code | RETRACT matric code | CAPACITY code n"
+                          " | ADDCOURSE code;name;lecturer;credit;capacity | DELCOURSE code | STATUS | PROMOTE | SHUTDOWN | QUIT";
+
+class MenuSession;
+
+// What is on the other end of a connection
+enum SessionPeer {
+    PEER_CLIENT,   // a user speaking the line protocol or running the menus
+    PEER_LISTENER, // the socket replicas connect to
+    PEER_FOLLOWER, // a replica following this node
+    PEER_UPSTREAM  // the node this replica follows
+};
+
+struct ServerSession {
+    int fd;
+    string input;
+    string output;
+    size_t outputSent;
+    bool wantWrite; // waiting for the socket to drain
+    bool closing;   // close once the output is sent
+    Student* student;
+    Staff* staff;
+    MenuSession* menu; // set when the connection runs the menus instead of the line protocol
+    SessionPeer peer;
+    long long shipped; // ops sent to a follower (-1 until it says where to start) or acknowledged to the upstream
+    long long acked;   // ops a follower has applied
+    chrono::steady_clock::time_point ackedAt;
+
+    ServerSession(int socket) : fd(socket), outputSent(0), wantWrite(false), closing(false), student(NULL), staff(NULL), menu(NULL),
+                                peer(PEER_CLIENT), shipped(-1), acked(0), ackedAt(chrono::steady_clock::now()) {}
+};
+
+volatile sig_atomic_t serverStopRequested = 0;
+
+// Replication
+// A primary ships its op log to any number of replicas over localhost TCP; each replica applies
+// it in order and serves read-only queries. Every node ships its own log onwards, so a promoted
+// replica keeps serving the others, and a replica can follow another replica. Shipping is
+// asynchronous: the primary answers before its replicas have applied a change.
+enum ReplicationRole { REPLICATION_OFF, REPLICATION_PRIMARY, REPLICATION_REPLICA };
+
+struct ReplicationState {
+    ReplicationRole role;
+    int port;                      // where followers connect; 0 for none
+    int upstreamPort;              // the node a replica follows
+    unsigned long long baseDigest; // the data before the first logged op, which every node must start from
+    ServerSession* upstream;
+    vector<ServerSession*> followers;
+    bool diverged;                 // applying the log failed, so following has stopped
+    chrono::steady_clock::time_point lastAttempt;
+    long long applied;             // ops applied from the upstream
+    double lastLagMs, maxLagMs, totalLagMs;
+
+    ReplicationState() : role(REPLICATION_OFF), port(0), upstreamPort(0), baseDigest(0), upstream(NULL), diverged(false),
+                         applied(0), lastLagMs(0), maxLagMs(0), totalLagMs(0) {}
+};
+
+ReplicationState replication;
+
+void digestText(unsigned long long& hash, const string& text) {
+    for (size_t i = 0; i < text.size(); i++) hash = (hash ^ (unsigned char)text[i]) * 1099511628211ULL;
+    hash = (hash ^ 0xFF) * 1099511628211ULL;
+}
+
+// FNV-1a over everything nodes must agree on: each student's credits and courses, each course's
+// details, seats and student list, and the live queue in order. Notifications and timestamps are
+// left out because every node stamps them with its own clock.
+unsigned long long stateDigest() {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (TreeCursor<Student> cursor(studentTree.getRoot()); cursor.hasNext();) {
+        Student* student = cursor.next();
+        digestText(hash, student->profile->matricNo + " " + to_string(student->maxCredit) + " " + to_string(student->currentCredit));
+        for (CourseNode* node = student->courseList; node != NULL; node = node->next) digestText(hash, node->courseCode + node->status);
+    }
+    for (TreeCursor<Course> cursor(courseTree.getRoot()); cursor.hasNext();) {
+        Course* course = cursor.next();
+        digestText(hash, course->details->courseCode + "\t" + course->details->courseName + "\t" + course->details->lecturerName + "\t" +
+                         to_string(course->credit) + " " + to_string(course->capacity) + " " + to_string(course->currentCapacity));
+        for (StudentNode* node = course->studentList; node != NULL; node = node->next) digestText(hash, node->matricNo);
+    }
+    for (RegistrationRequest* req = regQueue.getFront(); req != NULL; req = req->next) {
+        if (!req->isCancelled) digestText(hash, req->matricNo + " " + req->allCodes());
+    }
+    return hash;
+}
+
+string digestHex(unsigned long long digest) {
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", digest);
+    return text;
+}
+
+// Applies one logged op through the function that logged it, which logs it again on this node.
+// Returns false if it does not apply, meaning this node's data no longer matches the log.
+bool applyOp(const string& line) {
+    vector<string> field;
+    stringstream in(line);
+    string part;
+    while (getline(in, part, '\t')) field.push_back(part);
+    if (field.size() < 2) return false;
+    const string& verb = field[0];
+
+    if (verb == "ADDCOURSE") {
+        return field.size() == 6 && insertCourseRecord(field[1], field[2], field[3], atoi(field[4].c_str()), atoi(field[5].c_str())) != NULL;
+    }
+    if (verb == "DELCOURSE" || verb == "LECTURER" || verb == "CAPACITY") {
+        Course* course = courseTree.search(field[1]);
+        if (course == NULL) return false;
+        if (verb == "DELCOURSE") return deleteCourseRecord(course);
+        if (field.size() != 3) return false;
+        if (verb == "LECTURER") updateCourseLecturer(course, field[2]);
+        else updateCourseCapacity(course, atoi(field[2].c_str()));
+        return true;
+    }
+
+    Student* student = studentTree.search(field[1]);
+    if (student == NULL || field.size() < 3) return false;
+    if (verb == "REGISTER") {
+        vector<Course*> courses;
+        for (size_t i = 2; i < field.size(); i++) {
+            courses.push_back(courseTree.search(field[i]));
+            if (courses.back() == NULL) return false;
+        }
+        int failed;
+        if (courses.size() == 1) return submitRegistration(student, courses[0]) == REGISTER_OK;
+        return submitPackage(student, courses, failed) == REGISTER_OK;
+    }
+    if (verb == "DROP" || verb == "RETRACT") {
+        CourseNode* courseNode = findCourseInStudent(student, field[2]);
+        if (courseNode == NULL) return false;
+        if (verb == "DROP") dropRegisteredCourse(student, courseNode, courseTree.search(field[2]), NULL);
+        else retractStudentCourse(student, courseNode);
+        return true;
+    }
+
+    RegistrationRequest* entry = regQueue.findPending(field[1], field[2]);
+    if (entry == NULL) return false;
+    RegistrationRequest* req = entry->owner;
+    if (verb == "TAKE") {
+        regQueue.remove(req);
+        delete req;
+        return true;
+    }
+    Course* course = courseTree.search(req->courseCode);
+    if (req->package == NULL && course == NULL) return false;
+    if (verb == "APPROVE") {
+        approveRequest(req, student, course);
+        return true;
+    }
+    if (verb == "REJECT") {
+        // The reason is the rest of the line, tabs and all
+        size_t reason = line.find('\t', verb.size() + field[1].size() + field[2].size() + 2);
+        rejectRequest(req, student, reason == string::npos ? "" : line.substr(reason + 1));
+        return true;
+    }
+    return false;
+}
+
+// One-line summary for STATUS: role, ops in the log, data digest and how far behind replicas are
+string replicationStatus() {
+    string role = replication.role == REPLICATION_PRIMARY ? "primary" : replication.role == REPLICATION_REPLICA ? "replica" : "standalone";
+    string status = "OK " + role + " ops=" + to_string(opLog.size()) + " digest=" + digestHex(stateDigest());
+    if (replication.role == REPLICATION_REPLICA) {
+        status += string(" upstream=") + (replication.diverged ? "diverged" : replication.upstream != NULL ? "connected" : "down");
+        ostringstream lag;
+        lag << fixed << setprecision(3) << " applied=" << replication.applied << " lag_ms=" << replication.lastLagMs << "/"
+            << (replication.applied > 0 ? replication.totalLagMs / replication.applied : 0.0) << "/" << replication.maxLagMs;
+        status += lag.str();
+    }
+    status += " followers=" + to_string(replication.followers.size());
+    for (size_t i = 0; i < replication.followers.size(); i++) {
+        ServerSession* follower = replication.followers[i];
+        long long idleMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - follower->ackedAt).count();
+        status += (i == 0 ? " behind=" : ",") + to_string((long long)opLog.size() - follower->acked) + "@" + to_string(idleMs) + "ms";
+    }
+    return status + "\n";
+}
+
+// Takes the live request at the front of the queue, dropping cancelled ones on the way
+RegistrationRequest* frontLiveRequest() {
+    while (!regQueue.isEmpty() && regQueue.getFront()->isCancelled) {
+        delete regQueue.dequeue();
+    }
+    return regQueue.getFront();
+}
+
+// Staff changes to students and the catalog, and promoting a replica
+void serverStaffChange(const string& verb, const string& arg, string& out) {
+    if (verb == "PROMOTE") {
+        if (replication.role != REPLICATION_REPLICA) {
+            out += "ERR Not a replica\n";
+            return;
+        }
+        replication.role = REPLICATION_PRIMARY;
+        out += "OK Promoted to primary at op " + to_string(opLog.size()) + "\n";
+    } else if (verb == "RETRACT") {
+        size_t space = arg.find(' ');
+        Student* student = studentTree.search(arg.substr(0, space));
+        CourseNode* courseNode = student == NULL || space == string::npos ? NULL : findCourseInStudent(student, arg.substr(space + 1));
+        if (courseNode == NULL) {
+            out += "ERR Student or registered course not found\n";
+            return;
+        }
+        retractStudentCourse(student, courseNode);
+        out += "OK Retracted\n";
+    } else if (verb == "CAPACITY") {
+        size_t space = arg.find(' ');
+        Course* course = courseTree.search(arg.substr(0, space));
+        int capacity = space == string::npos ? -1 : atoi(arg.c_str() + space + 1);
+        if (course == NULL || capacity < 0) {
+            out += "ERR Usage: CAPACITY code n\n";
+            return;
+        }
+        updateCourseCapacity(course, capacity);
+        out += "OK Capacity " + to_string(capacity) + "\n";
+    } else if (verb == "ADDCOURSE") {
+        vector<string> field;
+        stringstream in(arg);
+        string part;
+        while (getline(in, part, ';')) field.push_back(part);
+        if (field.size() != 5 || field[0].empty()) {
+            out += "ERR Usage: ADDCOURSE code;name;lecturer;credit;capacity\n";
+            return;
+        }
+        if (insertCourseRecord(field[0], field[1], field[2], atoi(field[3].c_str()), atoi(field[4].c_str())) == NULL) out += "ERR Course already exists\n";
+        else out += "OK Added\n";
+    } else {
+        Course* course = courseTree.search(arg);
+        if (course == NULL) out += "ERR Course not found\n";
+        else if (!deleteCourseRecord(course)) out += "ERR Course has enrolled students\n";
+        else out += "OK Deleted\n";
+    }
+}
+
+// Credits reserved for each student whose home is this shard worker: every pending and approved
+// course on any shard. A worker's own Student records only count its own courses, so maxCredit is
+// checked against this ledger instead.
+unordered_map<string, int> creditLedger;
+
+// The commands a shard worker takes from the router, which names the student in each one.
+// Returns false for any other verb.
+bool shardCommand(const string& verb, const string& arg, string& out) {
+    if (verb != "WHO" && verb != "RESERVE" && verb != "UNRESERVE" && verb != "CREDITS" &&
+        verb != "ENROL" && verb != "UNENROL" && verb != "COURSES" && verb != "MATCH") return false;
+    if (verb == "MATCH") {
+        // SEARCH for the router, saying which kind of match it found so the router can merge like one server would
+        vector<Course*> found = courseIndex.searchPrefix(arg, 10);
+        bool prefix = !found.empty();
+        if (!prefix) found = courseIndex.searchSubstring(arg, 10);
+        out += prefix ? "OK PREFIX" : "OK SUBSTRING";
+        for (size_t i = 0; i < found.size(); i++) out += (i == 0 ? " " : ",") + found[i]->details->courseCode;
+        out += "\n";
+        return true;
+    }
+    size_t space = arg.find(' ');
+    string id = arg.substr(0, space);
+    string rest = space == string::npos ? "" : arg.substr(space + 1);
+    if (verb == "WHO") {
+        Student* student = studentTree.search(id);
+        if (student != NULL) {
+            out += "OK STUDENT " + student->profile->name + "\n";
+            return true;
+        }
+        Staff* staff = findStaff(id);
+        if (staff != NULL) {
+            out += "OK STAFF " + staff->name + "\n";
+            return true;
+        }
+        out += "ERR Unknown matric no or staff ID\n";
+        return true;
+    }
+
+    Student* student = studentTree.search(id);
+    if (student == NULL) {
+        out += "ERR Student not found\n";
+        return true;
+    }
+    int& reserved = creditLedger[student->profile->matricNo];
+    if (verb == "RESERVE") {
+        int credit = atoi(rest.c_str());
+        if (reserved + credit > student->maxCredit) {
+            out += "ERR Exceeds maximum credit limit\n";
+            return true;
+        }
+        reserved += credit;
+        out += "OK\n";
+    } else if (verb == "UNRESERVE") {
+        reserved -= atoi(rest.c_str());
+        out += "OK\n";
+    } else if (verb == "CREDITS") {
+        out += "OK " + to_string(reserved) + "/" + to_string(student->maxCredit) + "\n";
+    } else if (verb == "COURSES") {
+        out += "OK";
+        for (CourseNode* node = student->courseList; node != NULL; node = node->next) {
+            out += (node == student->courseList ? " " : ",") + node->courseCode + ":" + node->status;
+        }
+        out += "\n";
+    } else {
+        Course* course = courseTree.search(rest);
+        CourseNode* courseNode = findCourseInStudent(student, rest);
+        if (course == NULL) {
+            out += "ERR Course not found\n";
+        } else if (verb == "UNENROL") {
+            if (courseNode == NULL) {
+                out += "ERR Course not found in your registered courses\n";
+                return true;
+            }
+            dropRegisteredCourse(student, courseNode, course, NULL);
+            out += "OK " + to_string(course->credit) + "\n";
+        } else if (courseNode != NULL) {
+            out += "ERR Already registered\n";
+        } else if (course->currentCapacity >= course->capacity) {
+            out += "ERR Course is already full\n";
+        } else {
+            queueRegistration(student, course);
+            out += "OK Pending\n";
+        }
+    }
+    return true;
+}
+
+// Runs one protocol line for a session and appends the response line to out
+void serverCommand(ServerSession& session, const string& line, string& out) {
+    STAT_SCOPE(OP_SERVER_REQUEST);
+    size_t space = line.find(' ');
+    string verb = toUpperCopy(line.substr(0, space));
+    string arg = space == string::npos ? "" : line.substr(space + 1);
+    if (shardCount > 0 && session.staff != NULL && shardCommand(verb, arg, out)) return;
+
+    if (verb == "LOGIN") {
+        session.student = studentTree.search(arg);
+        session.staff = NULL;
+        if (session.student != NULL) {
+            out += "OK STUDENT " + session.student->profile->name + "\n";
+            return;
+        }
+        session.staff = findStaff(arg);
+        if (session.staff != NULL) out += "OK STAFF " + session.staff->name + "\n";
+        else out += "ERR Unknown matric no or staff ID\n";
+    } else if (verb == "COURSE") {
+        Course* course = courseTree.search(arg);
+        if (course == NULL) {
+            out += "ERR Course not found\n";
+            return;
+        }
+        out += "OK " + course->details->courseCode + ";" + course->details->courseName + ";" + course->details->lecturerName + ";" +
+               to_string(course->credit) + ";" + to_string(course->currentCapacity) + "/" + to_string(course->capacity) + "\n";
+    } else if (verb == "SEARCH") {
+        vector<Course*> found = courseIndex.searchPrefix(arg, 10);
+        if (found.empty()) found = courseIndex.searchSubstring(arg, 10);
+        out += "OK";
+        for (size_t i = 0; i < found.size(); i++) out += (i == 0 ? " " : ",") + found[i]->details->courseCode;
+        out += "\n";
+    } else if (verb == "QUIT") {
+        out += "OK Bye\n";
+        session.closing = true;
+    } else if (verb == "HELP") {
+        out += string("OK ") + SERVER_HELP + "\n";
+    } else if (verb == "STATUS") {
+        out += replicationStatus();
+    } else if (replication.role == REPLICATION_REPLICA &&
+               (verb == "REGISTER" || verb == "DROP" || verb == "APPROVE" || verb == "REJECT" || verb == "RETRACT" ||
+                verb == "CAPACITY" || verb == "ADDCOURSE" || verb == "DELCOURSE")) {
+        out += "ERR Read-only replica; send changes to the primary\n";
+    } else if (verb == "REGISTER" || verb == "DROP" || verb == "MYCOURSES") {
+        Student* student = session.student;
+        if (student == NULL) {
+            out += "ERR Log in as a student first\n";
+            return;
+        }
+        if (verb == "MYCOURSES") {
+            out += "OK";
+            for (CourseNode* node = student->courseList; node != NULL; node = node->next) {
+                out += (node == student->courseList ? " " : ",") + node->courseCode + ":" + node->status;
+            }
+            out += "\n";
+            return;
+        }
+
+        Course* course = courseTree.search(arg);
+        vector<string> codes = splitCodes(arg);
+        if (verb == "REGISTER" && codes.size() > 1) {
+            vector<Course*> courses;
+            for (size_t i = 0; i < codes.size(); i++) {
+                courses.push_back(courseTree.search(codes[i]));
+                if (courses.back() == NULL) {
+                    out += "ERR Course not found: " + codes[i] + "\n";
+                    return;
+                }
+            }
+            TRACE_SPAN(TRACE_REGISTER, "server");
+            int failed;
+            RegisterResult result = submitPackage(student, courses, failed);
+            if (result == REGISTER_OK) {
+                out += "OK Pending\n";
+                return;
+            }
+            string code = codes[failed];
+            if (result == REGISTER_DUPLICATE) out += "ERR Already registered or listed twice: " + code + "\n";
+            else if (result == REGISTER_OVER_CREDIT) out += "ERR Exceeds maximum credit limit at " + code + "\n";
+            else out += "ERR Course is already full: " + code + "\n";
+        } else if (verb == "REGISTER") {
+            if (course == NULL) {
+                out += "ERR Course not found\n";
+                return;
+            }
+            TRACE_SPAN(TRACE_REGISTER, "server");
+            RegisterResult result = submitRegistration(student, course);
+            if (result == REGISTER_DUPLICATE) out += "ERR Already registered\n";
+            else if (result == REGISTER_OVER_CREDIT) out += "ERR Exceeds maximum credit limit\n";
+            else if (result == REGISTER_FULL) out += "ERR Course is already full\n";
+            else out += "OK Pending\n";
+        } else {
+            CourseNode* courseNode = findCourseInStudent(student, arg);
+            if (courseNode == NULL) {
+                out += "ERR Course not found in your registered courses\n";
+                return;
+            }
+            TRACE_SPAN(TRACE_DROP, "server");
+            dropRegisteredCourse(student, courseNode, course, NULL);
+            out += "OK Dropped\n";
+        }
+    } else if (verb == "RETRACT" || verb == "CAPACITY" || verb == "ADDCOURSE" || verb == "DELCOURSE" || verb == "PROMOTE") {
+        if (session.staff == NULL) {
+            out += "ERR Log in as staff first\n";
+            return;
+        }
+        serverStaffChange(verb, arg, out);
+    } else if (verb == "NEXT" || verb == "APPROVE" || verb == "REJECT" || verb == "PENDING" || verb == "SHUTDOWN") {
+        if (session.staff == NULL) {
+            out += "ERR Log in as staff first\n";
+            return;
+        }
+        if (verb == "PENDING") {
+            Course* course = courseTree.search(arg);
+            if (course == NULL) out += "ERR Course not found\n";
+            else out += "OK " + to_string(regQueue.getPendingFor(course->details->courseCode)) + "\n";
+            return;
+        }
+        if (verb == "SHUTDOWN") {
+            out += "OK Shutting down\n";
+            serverStopRequested = 1;
+            return;
+        }
+
+        RegistrationRequest* req = frontLiveRequest();
+        if (req == NULL) {
+            out += "OK No pending requests\n";
+            return;
+        }
+        string request = req->matricNo + " " + req->allCodes();
+        if (verb == "NEXT") {
+            out += "OK " + request + "\n";
+            return;
+        }
+
+        Student* student = studentTree.search(req->matricNo);
+        Course* course = courseTree.search(req->courseCode);
+        if (student == NULL || course == NULL) {
+            out += "OK Skipped " + request + "\n";
+        } else if (verb == "REJECT") {
+            // false when the student no longer holds the course: nothing was released
+            if (rejectRequest(req, student, arg.empty() ? "Rejected by staff" : arg)) out += "OK Rejected " + request + "\n";
+            else out += "OK Skipped " + request + "\n";
+        } else if (findCourseInStudent(student, req->courseCode) == NULL) {
+            out += "OK Skipped " + request + "\n";
+        } else if (approveRequest(req, student, course)) {
+            out += "OK Approved " + request + "\n";
+        } else {
+            out += "OK Auto-rejected (course full) " + request + "\n";
+        }
+        delete regQueue.dequeue();
+    } else {
+        out += "ERR Unknown command. Commands: " + string(SERVER_HELP) + "\n";
+    }
+}
+
+// Menu Sessions
+// Runs the console menus for a remote user as a C++20 coroutine that suspends whenever it needs a line
+// of input, so an idle session holds no thread and costs only its coroutine frames. A single-threaded
+// executor resumes a session when its next line arrives. Every step between two inputs runs to
+// completion, so sessions see the same trees and queue the console does without any locking.
+#if COROUTINE_SESSIONS
+long long sessionFrameBytes = 0; // coroutine frames currently allocated
+
+class SessionTask {
+public:
+    struct promise_type {
+        coroutine_handle<> continuation;
+
+        SessionTask get_return_object() {
+            return SessionTask(coroutine_handle<promise_type>::from_promise(*this));
+        }
+        suspend_always initial_suspend() noexcept { return suspend_always(); }
+
+        // Resumes the coroutine that awaited this one, if any
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            coroutine_handle<> await_suspend(coroutine_handle<promise_type> self) noexcept {
+                coroutine_handle<> parent = self.promise().continuation;
+                return parent ? parent : noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return FinalAwaiter(); }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+
+        static void* operator new(size_t size) {
+            sessionFrameBytes += size;
+            return ::operator new(size);
+        }
+        static void operator delete(void* frame, size_t size) {
+            sessionFrameBytes -= size;
+            ::operator delete(frame);
+        }
+    };
+
+    SessionTask() : handle(nullptr) {}
+    SessionTask(SessionTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    SessionTask& operator=(SessionTask&& other) noexcept {
+        if (handle) handle.destroy();
+        handle = other.handle;
+        other.handle = nullptr;
+        return *this;
+    }
+    ~SessionTask() {
+        if (handle) handle.destroy();
+    }
+
+    // co_await on a task runs it and continues once it finishes
+    bool await_ready() { return false; }
+    coroutine_handle<> await_suspend(coroutine_handle<> parent) {
+        handle.promise().continuation = parent;
+        return handle;
+    }
+    void await_resume() {}
+
+    coroutine_handle<> getHandle() { return handle; }
+
+private:
+    coroutine_handle<promise_type> handle;
+
+    explicit SessionTask(coroutine_handle<promise_type> h) : handle(h) {}
+};
+
+class SessionExecutor {
+private:
+    vector<coroutine_handle<> > ready;
+
+public:
+    void post(coroutine_handle<> session) {
+        ready.push_back(session);
+    }
+
+    // Resumes sessions until none is runnable
+    void run() {
+        while (!ready.empty()) {
+            vector<coroutine_handle<> > batch;
+            batch.swap(ready);
+            for (size_t i = 0; i < batch.size(); i++) batch[i].resume();
+        }
+    }
+};
+
+SessionExecutor sessionExecutor;
+
+class MenuSession {
+private:
+    vector<string> lines; // input received but not read yet
+    coroutine_handle<> waiting;
+    SessionTask task;
+    bool finished;
+
+public:
+    string output; // text for the client, taken by the caller after each run
+
+    struct LineAwaiter {
+        MenuSession* session;
+
+        bool await_ready() { return !session->lines.empty(); }
+        void await_suspend(coroutine_handle<> reader) { session->waiting = reader; }
+        string await_resume() {
+            string line = session->lines.front();
+            session->lines.erase(session->lines.begin());
+            return line;
+        }
+    };
+
+    MenuSession() : waiting(nullptr), finished(false) {}
+
+    void start(SessionTask flow) {
+        task = std::move(flow);
+        sessionExecutor.post(task.getHandle());
+    }
+
+    void deliver(const string& line) {
+        lines.push_back(line);
+        if (waiting) {
+            sessionExecutor.post(waiting);
+            waiting = nullptr;
+        }
+    }
+
+    LineAwaiter readLine() {
+        LineAwaiter awaiter = { this };
+        return awaiter;
+    }
+
+    LineAwaiter prompt(const string& text) {
+        output += text;
+        return readLine();
+    }
+
+    void finish() {
+        finished = true;
+    }
+
+    bool isFinished() {
+        return finished;
+    }
+};
+
+// Sends cout to a session while alive, so the console display functions can be reused.
+// Never keep one alive across a co_await: another session would write into it.
+class CoutToSession {
+private:
+    string& target;
+    stringbuf buffer;
+    streambuf* saved;
+
+public:
+    CoutToSession(MenuSession& session) : target(session.output), saved(cout.rdbuf(&buffer)) {}
+    ~CoutToSession() {
+        cout.rdbuf(saved);
+        target += buffer.str();
+    }
+};
+
+int sessionChoice(const string& line) {
+    return atoi(line.c_str());
+}
+
+bool sessionYes(const string& line) {
+    for (size_t i = 0; i < line.size(); i++) {
+        if (!isspace((unsigned char)line[i])) return line[i] == 'y' || line[i] == 'Y';
+    }
+    return false;
+}
+
+SessionTask listingSession(MenuSession& session, bool students) {
+    if (students ? studentTree.getRoot() == NULL : CatalogRead()->entries.empty()) {
+        session.output += students ? "No students in system.\n" : "No courses available.\n";
+        co_return;
+    }
+    session.output += students ? "\n=== All Students ===\n" : "\n=== All Courses ===\n";
+    string key = "";
+    while (true) {
+        string next;
+        {
+            CoutToSession to(session);
+            next = students ? studentTree.displayPage(key, LIST_PAGE_SIZE) : displayCatalogPage(key, LIST_PAGE_SIZE);
+        }
+        if (next.empty()) co_return;
+        key = nextPageKey(next, co_await session.prompt(PAGE_PROMPT));
+        if (key.empty()) co_return;
+    }
+}
+
+SessionTask studentMenuSession(MenuSession& session, Student* student) {
+    while (true) {
+        {
+            CoutToSession to(session);
+            printStudentMenu(student);
+        }
+        int choice = sessionChoice(co_await session.readLine());
+
+        if (choice == 1) {
+            co_await listingSession(session, false);
+        } else if (choice == 2) {
+            string query = co_await session.prompt("Enter Course Code, Name or Lecturer: ");
+            CoutToSession to(session);
+            searchCourseQuery(query);
+        } else if (choice == 3) {
+            string code = co_await session.prompt("Enter Course Code (or several, separated by spaces, to register all or none): ");
+            CoutToSession to(session);
+            registerCourseCode(student, code);
+        } else if (choice == 4) {
+            CoutToSession to(session);
+            viewRegisteredCourses(student);
+        } else if (choice == 5) {
+            {
+                CoutToSession to(session);
+                viewRegisteredCourses(student);
+            }
+            if (student->courseList == NULL) continue;
+            string code = co_await session.prompt("Enter Course Code to delete: ");
+            CoutToSession to(session);
+            deleteCourseCode(student, code);
+        } else if (choice == 6) {
+            while (true) {
+                bool shown;
+                {
+                    CoutToSession to(session);
+                    shown = showLatestNotification(student);
+                }
+                if (!shown) break;
+                int pick = sessionChoice(co_await session.readLine());
+                CoutToSession to(session);
+                if (!applyNotificationChoice(student, pick)) break;
+            }
+        } else if (choice == 7) {
+            string slip = renderRegistrationSlip(student);
+            session.output += "\n" + slip;
+            if (sessionYes(co_await session.prompt("\nDownload slip? (y/n): "))) {
+                CoutToSession to(session);
+                downloadRegistrationSlip(student, slip);
+            }
+        } else if (choice == 8) {
+            string code = co_await session.prompt("Enter Course Code: ");
+            CoutToSession to(session);
+            viewStudentsInCourseCode(student, code);
+        } else if (choice == 9) {
+            co_return; // the server saves the data files when it stops
+        } else {
+            session.output += "Invalid choice.\n";
+        }
+    }
+}
+
+// True if req is still the live request at the front, i.e. no other session decided it meanwhile
+bool frontRequestIs(const string& matric, const string& code) {
+    RegistrationRequest* front = regQueue.getFront();
+    return front != NULL && !front->isCancelled && front->matricNo == matric && front->courseCode == code;
+}
+
+SessionTask staffRequestsSession(MenuSession& session) {
+    if (regQueue.isEmpty()) {
+        session.output += "No pending requests.\n";
+        co_return;
+    }
+
+    while (true) {
+        RegistrationRequest* req;
+        {
+            CoutToSession to(session);
+            req = showNextRequest();
+        }
+        if (req == NULL) {
+            session.output += "All requests processed.\n";
+            co_return;
+        }
+        string matric = req->matricNo, code = req->courseCode;
+
+        int choice = sessionChoice(co_await session.readLine());
+        if (choice == 3) co_return;
+
+        string reason;
+        if (choice == 2 && frontRequestIs(matric, code) && requestNeedsReason(regQueue.getFront())) {
+            reason = co_await session.prompt("Enter rejection reason: ");
+        }
+        if (!frontRequestIs(matric, code)) {
+            session.output += "Request was already handled in another session.\n";
+            continue;
+        }
+
+        bool decided;
+        {
+            CoutToSession to(session);
+            decided = decideFrontRequest(regQueue.getFront(), choice, reason);
+        }
+        if (!decided) continue;
+
+        if (!sessionYes(co_await session.prompt("\nContinue processing? (y/n): "))) co_return;
+    }
+}
+
+SessionTask staffMenuSession(MenuSession& session) {
+    while (true) {
+        {
+            CoutToSession to(session);
+            printStaffMenu();
+        }
+        int choice = sessionChoice(co_await session.readLine());
+
+        if (choice == 1) {
+            co_await staffRequestsSession(session);
+        } else if (choice == 2) {
+            co_await listingSession(session, true);
+        } else if (choice == 3) {
+            string matric = co_await session.prompt("Enter Matric No: ");
+            CoutToSession to(session);
+            showStudentDetails(matric);
+        } else if (choice == 8) {
+            string code = co_await session.prompt("Enter Course Code: ");
+            bool found;
+            {
+                CoutToSession to(session);
+                found = showCourseStudentList(code) != NULL;
+            }
+            if (!found) continue;
+            bool download = sessionYes(co_await session.prompt("\nDownload list? (y/n): "));
+            Course* course = courseTree.search(code);
+            if (download && course != NULL) {
+                CoutToSession to(session);
+                downloadCourseStudentList(course);
+            }
+        } else if (choice == 9) {
+            co_await listingSession(session, false);
+        } else if (choice == 14) {
+            CoutToSession to(session);
+            printPerformanceStats();
+        } else if (choice == 19) {
+            AnalyticsSnapshot snapshot;
+            snapshot.build();
+            {
+                CoutToSession to(session);
+                printAnalyticsTables(snapshot);
+            }
+            while (true) {
+                string query = co_await session.prompt("\nQuery (blank to return): ");
+                if (query.empty()) break;
+                runAnalyticsQuery(snapshot, query, session.output);
+            }
+        } else if (choice == 20) {
+            co_return;
+        } else if (choice >= 4 && choice <= 18) {
+            session.output += "This option is only available at the console.\n";
+        } else {
+            session.output += "Invalid choice.\n";
+        }
+    }
+}
+
+SessionTask mainMenuSession(MenuSession& session) {
+    while (true) {
+        {
+            CoutToSession to(session);
+            printMainMenu();
+        }
+        int choice = sessionChoice(co_await session.readLine());
+
+        if (choice == 1) {
+            string matric = co_await session.prompt("Enter Matric No: ");
+            Student* student = studentTree.search(matric);
+            if (student == NULL) {
+                session.output += "You are not eligible for course registration.\n";
+            } else {
+                co_await studentMenuSession(session, student);
+            }
+        } else if (choice == 2) {
+            string staffID = co_await session.prompt("Enter Staff ID: ");
+            Staff* foundStaff = findStaff(staffID);
+            if (foundStaff == NULL) {
+                session.output += "Prohibited access.\n";
+            } else {
+                session.output += "Welcome " + foundStaff->name + "!\n";
+                co_await staffMenuSession(session);
+            }
+        } else if (choice == 3) {
+            session.finish();
+            co_return;
+        } else {
+            session.output += "Invalid choice.\n";
+        }
+    }
+}
+
+// Glue for the server: a menu session per connection, fed one line at a time
+MenuSession* openMenuSession(string& out) {
+    MenuSession* session = new MenuSession();
+    session->start(mainMenuSession(*session));
+    sessionExecutor.run();
+    out += session->output;
+    session->output.clear();
+    return session;
+}
+
+// Returns false once the user has chosen Exit
+bool menuSessionInput(MenuSession* session, const string& line, string& out) {
+    session->deliver(line);
+    sessionExecutor.run();
+    out += session->output;
+    session->output.clear();
+    return !session->isFinished();
+}
+
+void closeMenuSession(MenuSession* session) {
+    delete session;
+}
+
+// One thread per session for comparison: the thread sleeps on a condition variable until its next line
+struct ThreadSession {
+    mutex lock;
+    condition_variable wake;
+    string line;
+    string output;
+    bool hasLine;
+    bool stop;
+
+    ThreadSession() : hasLine(false), stop(false) {}
+};
+
+void threadSessionLoop(ThreadSession* session) {
+    unique_lock<mutex> guard(session->lock);
+    while (true) {
+        session->wake.wait(guard, [session]() { return session->hasLine || session->stop; });
+        if (session->stop) return;
+        session->output += session->line;
+        session->hasLine = false;
+        session->wake.notify_all();
+    }
+}
+
+SessionTask echoSession(MenuSession& session) {
+    while (true) {
+        session.output += co_await session.readLine();
+    }
+}
+
+// Memory per idle session and cost of handing one line to a session, coroutines against threads
+void benchSessions(int sessions, int threads) {
+    generateSyntheticData(1000, 100, 0, 2043);
+    cout << fixed << setprecision(0);
+
+    // Coroutine sessions, each logged in and waiting at the student menu
+    long long rssBefore = residentBytes();
+    long long framesBefore = sessionFrameBytes;
+    vector<MenuSession*> idle(sessions);
+    for (int i = 0; i < sessions; i++) {
+        idle[i] = new MenuSession();
+        idle[i]->start(mainMenuSession(*idle[i]));
+        idle[i]->deliver("1");
+        idle[i]->deliver(syntheticMatric(i % 1000));
+        sessionExecutor.run();
+        string().swap(idle[i]->output);
+    }
+    double frameBytes = (double)(sessionFrameBytes - framesBefore) / sessions;
+    double coroutineBytes = frameBytes + sizeof(MenuSession);
+    double coroutineRss = rssBefore > 0 ? (double)(residentBytes() - rssBefore) / sessions : 0;
+    cout << sessions << " idle coroutine sessions: " << frameBytes << " bytes of frames + "
+         << sizeof(MenuSession) << " bytes of session each";
+    if (coroutineRss > 0) cout << ", " << coroutineRss << " bytes resident each";
+    cout << "\n";
+
+    // Round trip: deliver a line, resume the session, let it suspend again
+    const int rounds = 1000000;
+    MenuSession echo;
+    echo.start(echoSession(echo));
+    sessionExecutor.run();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        echo.deliver("x");
+        sessionExecutor.run();
+        echo.output.clear();
+    }
+    double coroutineSwitchNs = elapsedMs(start) * 1e6 / rounds;
+
+    // Thread-per-session
+    rssBefore = residentBytes();
+    vector<ThreadSession*> parked(threads);
+    vector<thread> pool;
+    for (int i = 0; i < threads; i++) {
+        parked[i] = new ThreadSession();
+        pool.push_back(thread(threadSessionLoop, parked[i]));
+    }
+    this_thread::sleep_for(chrono::milliseconds(200)); // let every thread reach its wait
+    double threadRss = rssBefore > 0 ? (double)(residentBytes() - rssBefore) / threads : 0;
+    size_t stackBytes = 0;
+#ifdef __linux__
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_getstacksize(&attr, &stackBytes);
+    pthread_attr_destroy(&attr);
+#endif
+    cout << threads << " idle session threads: ";
+    if (threadRss > 0) cout << threadRss << " bytes resident each, ";
+    cout << stackBytes / 1024 << " KB of stack reserved each\n";
+
+    const int threadRounds = 100000;
+    ThreadSession* target = parked[0];
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < threadRounds; i++) {
+        unique_lock<mutex> guard(target->lock);
+        target->line = "x";
+        target->hasLine = true;
+        target->wake.notify_all();
+        target->wake.wait(guard, [target]() { return !target->hasLine; });
+        target->output.clear();
+    }
+    double threadSwitchNs = elapsedMs(start) * 1e6 / threadRounds;
+
+    for (int i = 0; i < threads; i++) {
+        {
+            lock_guard<mutex> guard(parked[i]->lock);
+            parked[i]->stop = true;
+        }
+        parked[i]->wake.notify_all();
+        pool[i].join();
+        delete parked[i];
+    }
+    for (int i = 0; i < sessions; i++) delete idle[i];
+
+    const double gb = 1024.0 * 1024 * 1024;
+    double coroutinePerSession = coroutineRss > coroutineBytes ? coroutineRss : coroutineBytes;
+    cout << "\nSessions per GB: coroutines " << gb / coroutinePerSession;
+    if (threadRss > 0) cout << ", threads " << gb / threadRss << " (resident)";
+    if (stackBytes > 0) cout << ", " << gb / stackBytes << " (reserved stack)";
+    cout << "\n" << setprecision(1);
+    cout << "Handing a line to a session: coroutine " << coroutineSwitchNs << " ns, thread " << threadSwitchNs << " ns\n";
+}
+#else
+MenuSession* openMenuSession(string&) {
+    return NULL;
+}
+
+bool menuSessionInput(MenuSession*, const string&, string&) {
+    return false;
+}
+
+void closeMenuSession(MenuSession*) {}
+
+void benchSessions(int, int) {
+    cout << "Coroutine sessions need a C++20 build (g++ -std=c++20).\n";
+}
+#endif
+
+#ifdef __linux__
+const int SERVER_MAX_LINE = 4096;
+
+void raiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+void onServerSignal(int) {
+    serverStopRequested = 1;
+}
+
+// Writes as much pending output as the socket takes. Returns false if the connection failed.
+bool flushSocket(int fd, string& output, size_t& sent) {
+    while (sent < output.size()) {
+        ssize_t n = send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    output.clear();
+    sent = 0;
+    return true;
+}
+
+// Reads everything available. Returns false once the peer has closed or the connection failed.
+bool readSocket(int fd, string& input) {
+    char buffer[16384];
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            input.append(buffer, n);
+        } else if (n == 0) {
+            return false;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+void closeSession(int epfd, unordered_map<int, ServerSession*>& sessions, ServerSession* session) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, session->fd, NULL);
+    close(session->fd);
+    sessions.erase(session->fd);
+    if (session->menu != NULL) closeMenuSession(session->menu);
+    if (session == replication.upstream) replication.upstream = NULL;
+    vector<ServerSession*>& followers = replication.followers;
+    followers.erase(remove(followers.begin(), followers.end(), session), followers.end());
+    delete session;
+}
+
+// Sends what the socket takes and waits for it to drain if anything is left. Returns false if the connection failed.
+bool flushSession(int epfd, ServerSession* session) {
+    if (!flushSocket(session->fd, session->output, session->outputSent)) return false;
+    bool pending = !session->output.empty();
+    if (pending != session->wantWrite) {
+        session->wantWrite = pending;
+        epoll_event changed;
+        changed.events = pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        changed.data.ptr = session;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, session->fd, &changed);
+    }
+    return true;
+}
+
+ServerSession* addPeer(int epfd, unordered_map<int, ServerSession*>& sessions, int fd, SessionPeer peer) {
+    ServerSession* session = new ServerSession(fd);
+    session->peer = peer;
+    session->wantWrite = true;
+    sessions[fd] = session;
+    epoll_event added;
+    added.events = EPOLLIN | EPOLLOUT;
+    added.data.ptr = session;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &added);
+    return session;
+}
+
+// Replicas connect to 127.0.0.1:replication.port. Returns false if the port cannot be opened.
+bool openReplicationListener(int epfd, unordered_map<int, ServerSession*>& sessions) {
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(replication.port);
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+        cout << "Cannot listen for replicas on port " << replication.port << ": " << strerror(errno) << "\n";
+        if (listener >= 0) close(listener);
+        return false;
+    }
+    addPeer(epfd, sessions, listener, PEER_LISTENER)->wantWrite = false;
+    epoll_event changed;
+    changed.events = EPOLLIN;
+    changed.data.ptr = sessions[listener];
+    epoll_ctl(epfd, EPOLL_CTL_MOD, listener, &changed);
+    return true;
+}
+
+// Starts following the upstream from the next op this node has not applied
+void connectUpstream(int epfd, unordered_map<int, ServerSession*>& sessions) {
+    replication.lastAttempt = chrono::steady_clock::now();
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(replication.upstreamPort);
+    if (fd < 0 || (connect(fd, (sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS)) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+    ServerSession* upstream = addPeer(epfd, sessions, fd, PEER_UPSTREAM);
+    upstream->shipped = opLog.size();
+    upstream->output = "FOLLOW\t" + to_string(opLog.size()) + "\t" + digestHex(replication.baseDigest) + "\n";
+    replication.upstream = upstream;
+}
+
+// One line from a replication connection. A follower sends FOLLOW (where to start, and the digest
+// of its starting data) and then ACKs; the upstream sends ops as "seq<TAB>logged-us<TAB>op".
+void replicationLine(ServerSession& session, const string& line) {
+    if (session.peer == PEER_FOLLOWER) {
+        vector<string> field;
+        stringstream in(line);
+        string part;
+        while (getline(in, part, '\t')) field.push_back(part);
+        if (field.size() == 3 && field[0] == "FOLLOW" && session.shipped < 0) {
+            long long from = atoll(field[1].c_str());
+            if (field[2] != digestHex(replication.baseDigest)) {
+                session.output += "ERR\tDifferent starting data\n";
+                session.closing = true;
+            } else if (from < 0 || from > (long long)opLog.size()) {
+                session.output += "ERR\tFollower is ahead of this node\n";
+                session.closing = true;
+            } else {
+                session.shipped = session.acked = from;
+                session.ackedAt = chrono::steady_clock::now();
+                replication.followers.push_back(&session);
+            }
+        } else if (field.size() == 2 && field[0] == "ACK") {
+            session.acked = atoll(field[1].c_str());
+            session.ackedAt = chrono::steady_clock::now();
+        }
+        return;
+    }
+
+    if (line.compare(0, 4, "ERR\t") == 0) {
+        cout << "Upstream refused to replicate: " << line.substr(4) << "\n";
+        replication.diverged = true;
+        session.closing = true;
+        return;
+    }
+    size_t first = line.find('\t'), second = first == string::npos ? first : line.find('\t', first + 1);
+    if (second == string::npos || replication.diverged) return;
+    long long seq = atoll(line.c_str());
+    if (seq <= (long long)opLog.size()) return; // already applied before a reconnect
+    if (seq != (long long)opLog.size() + 1 || !applyOp(line.substr(second + 1)) || (long long)opLog.size() != seq) {
+        cout << "Replica diverged at op " << seq << ": " << line.substr(second + 1) << "\n";
+        replication.diverged = true;
+        session.closing = true;
+        return;
+    }
+    long long loggedUs = atoll(line.c_str() + first + 1);
+    opLog.back().loggedUs = loggedUs;
+    double lagMs = (steadyMicros() - loggedUs) / 1000.0;
+    replication.applied++;
+    replication.lastLagMs = lagMs;
+    replication.totalLagMs += lagMs;
+    replication.maxLagMs = max(replication.maxLagMs, lagMs);
+}
+
+// Runs after every wakeup of the server loop: follows or stops following the upstream,
+// acknowledges what was applied, and ships new ops to every follower.
+void replicationTick(int epfd, unordered_map<int, ServerSession*>& sessions) {
+    if (replication.role == REPLICATION_OFF) return;
+    ServerSession* upstream = replication.upstream;
+    if (replication.role == REPLICATION_PRIMARY && upstream != NULL) {
+        closeSession(epfd, sessions, upstream); // promoted
+        upstream = NULL;
+    }
+    if (replication.role == REPLICATION_REPLICA && upstream == NULL && !replication.diverged &&
+        chrono::steady_clock::now() - replication.lastAttempt > chrono::seconds(1)) {
+        connectUpstream(epfd, sessions);
+        upstream = replication.upstream;
+    }
+    if (upstream != NULL && upstream->shipped != (long long)opLog.size()) {
+        upstream->shipped = opLog.size();
+        upstream->output += "ACK\t" + to_string(opLog.size()) + "\n";
+        if (!flushSession(epfd, upstream)) closeSession(epfd, sessions, upstream);
+    }
+
+    vector<ServerSession*> followers = replication.followers;
+    for (size_t i = 0; i < followers.size(); i++) {
+        ServerSession* follower = followers[i];
+        // A follower catching up takes the log a megabyte at a time, as fast as it reads it
+        while (follower->shipped < (long long)opLog.size() && follower->output.size() < (1 << 20)) {
+            const LoggedOp& entry = opLog[follower->shipped++];
+            follower->output += to_string(follower->shipped) + "\t" + to_string(entry.loggedUs) + "\t" + entry.op + "\n";
+        }
+        if (!flushSession(epfd, follower)) closeSession(epfd, sessions, follower);
+    }
+}
+
+// Serves clients on 127.0.0.1:port until SIGINT/SIGTERM or a staff SHUTDOWN. Returns 0 on a clean stop.
+// With menus set, each connection gets the console menus as a coroutine session instead of the line protocol.
+int runServer(int port, bool menus) {
+    raiseFileLimit();
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+        cout << "Cannot listen on port " << port << ": " << strerror(errno) << "\n";
+        if (listener >= 0) close(listener);
+        return 1;
+    }
+
+    int epfd = epoll_create1(0);
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; // the listener
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &event);
+
+    serverStopRequested = 0;
+    signal(SIGINT, onServerSignal);
+    signal(SIGTERM, onServerSignal);
+    cout << "Listening on 127.0.0.1:" << port << " (Ctrl+C to stop)\n" << flush;
+
+    unordered_map<int, ServerSession*> sessions;
+    if (replication.port != 0 && !openReplicationListener(epfd, sessions)) serverStopRequested = 1;
+    vector<epoll_event> ready(1024);
+    while (!serverStopRequested) {
+        int count = epoll_wait(epfd, &ready[0], ready.size(), 500);
+        if (count < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < count; i++) {
+            ServerSession* session = (ServerSession*)ready[i].data.ptr;
+            if (session != NULL && session->peer == PEER_LISTENER) {
+                int fd;
+                while ((fd = accept4(session->fd, NULL, NULL, SOCK_NONBLOCK)) >= 0) addPeer(epfd, sessions, fd, PEER_FOLLOWER);
+                continue;
+            }
+            if (session == NULL) {
+                int fd;
+                while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+                    ServerSession* accepted = new ServerSession(fd);
+                    sessions[fd] = accepted;
+                    if (menus) {
+                        accepted->menu = openMenuSession(accepted->output);
+                        flushSocket(fd, accepted->output, accepted->outputSent);
+                        accepted->wantWrite = !accepted->output.empty();
+                    }
+                    epoll_event added;
+                    added.events = accepted->wantWrite ? EPOLLIN | EPOLLOUT : EPOLLIN;
+                    added.data.ptr = accepted;
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &added);
+                }
+                continue;
+            }
+
+            bool open = true;
+            if (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                open = readSocket(session->fd, session->input);
+                size_t start = 0, end;
+                while (!session->closing && (end = session->input.find('\n', start)) != string::npos) {
+                    string line = session->input.substr(start, end - start);
+                    if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+                    if (session->peer != PEER_CLIENT) {
+                        replicationLine(*session, line);
+                    } else if (session->menu != NULL) {
+                        if (!menuSessionInput(session->menu, line, session->output)) session->closing = true;
+                    } else {
+                        serverCommand(*session, line, session->output);
+                    }
+                    start = end + 1;
+                }
+                session->input.erase(0, start);
+                if (session->input.size() > SERVER_MAX_LINE && session->peer != PEER_UPSTREAM) open = false;
+            }
+
+            if (open && !flushSession(epfd, session)) open = false;
+            if (!open || (session->closing && session->output.empty())) {
+                closeSession(epfd, sessions, session);
+                continue;
+            }
+        }
+        replicationTick(epfd, sessions);
+    }
+
+    cout << "Server stopped, closing " << sessions.size() << " session(s).\n";
+    for (unordered_map<int, ServerSession*>::iterator it = sessions.begin(); it != sessions.end(); ++it) {
+        close(it->first);
+        delete it->second;
+    }
+    replication.upstream = NULL;
+    replication.followers.clear();
+    close(epfd);
+    close(listener);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    return 0;
+}
+
+// Load generator: each connection logs in, then sends one request at a time and times the response.
+// Every twentieth connection is a staff member approving the queue; the others are students.
+struct LoadClient {
+    int fd;
+    string input;
+    string output;
+    size_t outputSent;
+    int remaining;
+    bool staff;
+    bool wantWrite;
+    chrono::steady_clock::time_point sentAt;
+};
+
+void loadClientSend(LoadClient& client, unsigned long long& rng, int students, int courses) {
+    string command;
+    if (client.remaining < 0) {
+        command = client.staff ? "LOGIN S001" : "LOGIN " + syntheticMatric((int)(simUniform(rng) * students));
+    } else if (client.staff) {
+        command = "APPROVE";
+    } else {
+        string code = syntheticCourseCode((int)(simUniform(rng) * courses));
+        double pick = simUniform(rng);
+        if (pick < 0.40) command = "COURSE " + code;
+        else if (pick < 0.60) command = "SEARCH " + code.substr(0, 6);
+        else if (pick < 0.85) command = "REGISTER " + code;
+        else if (pick < 0.95) command = "MYCOURSES";
+        else command = "DROP " + code;
+    }
+    client.output += command + "\n";
+    client.sentAt = chrono::steady_clock::now();
+}
+
+// Connects clients to 127.0.0.1:port and runs requestsPerClient requests on each.
+// Assumes the server holds synthetic data of the given size. Returns 0 if every client finished.
+int runLoadTest(int port, int clients, int requestsPerClient, int students, int courses) {
+    raiseFileLimit();
+    int epfd = epoll_create1(0);
+    vector<LoadClient> pool(clients);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    int active = 0;
+    for (int i = 0; i < clients; i++) {
+        LoadClient& client = pool[i];
+        client.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        client.outputSent = 0;
+        client.remaining = -1; // login first
+        client.staff = i % 20 == 19;
+        client.wantWrite = true;
+        if (client.fd < 0 || (connect(client.fd, (sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS)) {
+            cout << "Connect failed after " << i << " client(s): " << strerror(errno) << "\n";
+            if (client.fd >= 0) close(client.fd);
+            client.fd = -1;
+            break;
+        }
+        int yes = 1;
+        setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.u32 = i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, client.fd, &event);
+        active++;
+    }
+    int connected = active;
+
+    unsigned long long rng = 2043;
+    vector<unsigned long long> latency(HISTOGRAM_BUCKETS, 0);
+    unsigned long long completed = 0, refused = 0, maxNs = 0;
+    int failed = 0;
+    vector<epoll_event> ready(1024);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < connected; i++) loadClientSend(pool[i], rng, students, courses);
+
+    while (active > 0) {
+        int count = epoll_wait(epfd, &ready[0], ready.size(), 5000);
+        if (count == 0) {
+            cout << "No response for 5 s, giving up on " << active << " client(s).\n";
+            failed += active;
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            LoadClient& client = pool[ready[i].data.u32];
+            if (client.fd < 0) continue;
+            bool open = readSocket(client.fd, client.input);
+
+            size_t end;
+            while (open && (end = client.input.find('\n')) != string::npos) {
+                unsigned long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - client.sentAt).count();
+                if (client.input.compare(0, 3, "ERR") == 0) refused++;
+                client.input.erase(0, end + 1);
+                if (client.remaining >= 0) {
+                    latency[histogramBucket(ns)]++;
+                    maxNs = max(maxNs, ns);
+                    completed++;
+                }
+                if (++client.remaining >= requestsPerClient) {
+                    open = false;
+                    break;
                 }
+                loadClientSend(client, rng, students, courses);
             }
-            current = current->next;
-        }
-        int approvedCredit = 0;
-        CourseNode* cur = student->courseList;
-        while (cur) {
-            if (cur->status == "Approved") {
-                Course* c = courseTree.search(cur->courseCode);
-                if (c) approvedCredit += c->credit;
+
+            if (open && !flushSocket(client.fd, client.output, client.outputSent)) {
+                open = false;
+                failed++;
+            }
+            if (!open) {
+                if (client.remaining < requestsPerClient) failed++;
+                epoll_ctl(epfd, EPOLL_CTL_DEL, client.fd, NULL);
+                close(client.fd);
+                client.fd = -1;
+                active--;
+            } else if (client.output.empty() == client.wantWrite) {
+                client.wantWrite = !client.wantWrite;
+                epoll_event event;
+                event.events = client.wantWrite ? EPOLLIN | EPOLLOUT : EPOLLIN;
+                event.data.u32 = ready[i].data.u32;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, client.fd, &event);
             }
-            cur = cur->next;
         }
-        file << "========================================\n";
-        file << "Total Approved Credits: " << approvedCredit
-            << "/" << student->maxCredit << "\n";
-        file.close();
-        cout << "Slip downloaded as " << filename << "\n";
     }
+    double seconds = elapsedMs(start) / 1000;
+    for (int i = 0; i < connected; i++) {
+        if (pool[i].fd >= 0) close(pool[i].fd);
+    }
+    close(epfd);
+
+    cout << connected << " client(s), " << completed << " request(s) in " << fixed << setprecision(2) << seconds
+         << " s: " << setprecision(0) << completed / seconds << " requests/s (" << refused << " answered ERR, "
+         << failed << " client(s) failed)\n";
+    if (completed > 0) {
+        cout << "Latency (us): p50 " << formatMicros(histogramPercentile(latency, completed, maxNs, 50))
+             << ", p90 " << formatMicros(histogramPercentile(latency, completed, maxNs, 90))
+             << ", p99 " << formatMicros(histogramPercentile(latency, completed, maxNs, 99))
+             << ", p99.9 " << formatMicros(histogramPercentile(latency, completed, maxNs, 99.9))
+             << ", max " << formatMicros(maxNs) << "\n";
+    }
+    return failed == 0 && connected == clients ? 0 : 1;
 }
 
-void viewStudentsInCourse(Student* student) {
-    cout << "Enter Course Code: ";
-    string code;
-    getline(cin, code);
-    
-    Course* course = courseTree.search(code);
-    if (course == NULL) {
-        cout << "Course not found.\n";
-        return;
+// Waits up to 30 s for a child to finish generating its data and start listening on port
+bool waitForServer(int port) {
+    bool up = false;
+    for (int attempt = 0; attempt < 600 && !up; attempt++) {
+        usleep(50000);
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        up = connect(fd, (sockaddr*)&address, sizeof(address)) == 0;
+        close(fd);
     }
-    
-    bool isApproved = false;
-    CourseNode* current = student->courseList;
-    while (current != NULL) {
-        if (current->courseCode == code && current->status == "Approved") {
-            isApproved = true;
-            break;
-        }
-        current = current->next;
+    return up;
+}
+
+// Server on synthetic data in a child process, load generator in this one
+int benchServer(int clients, int requestsPerClient) {
+    const int port = 55555, students = 100000, courses = 3000;
+    cout << flush;
+    pid_t child = fork();
+    if (child == 0) {
+        generateSyntheticData(students, courses, 0, 2043);
+        Staff staff = { "Load Test Staff", "S001" };
+        staffList.push_back(staff);
+        cout.setstate(ios::failbit);
+        _exit(runServer(port, false));
     }
-    
-    if (!isApproved) {
-        cout << "You are not approved in this course.\n";
-        return;
+
+    int code = 1;
+    if (waitForServer(port)) {
+        cout << "Server up with " << students << " students x " << courses << " courses\n";
+        code = runLoadTest(port, clients, requestsPerClient, students, courses);
+    } else {
+        cout << "Server did not start.\n";
     }
-    
-    cout << "\n=== Students in " << course->courseCode << " ===\n";
-    if (course->studentList == NULL) {
-        cout << "No students in this course.\n";
+    kill(child, SIGTERM);
+    waitpid(child, NULL, 0);
+    return code;
+}
+#else
+int runServer(int port, bool menus) {
+    cout << "Server mode needs Linux (epoll).\n";
+    return 1;
+}
+
+int runLoadTest(int port, int clients, int requestsPerClient, int students, int courses) {
+    cout << "The load generator needs Linux (epoll).\n";
+    return 1;
+}
+
+int benchServer(int clients, int requestsPerClient) {
+    return runLoadTest(0, clients, requestsPerClient, 0, 0);
+}
+#endif
+
+// Serves the data files, or synthetic data of the given size (kept in memory and never saved).
+// With replication on, the op log starts from the data as loaded here.
+int serveData(int port, bool menus, int syntheticStudents, int syntheticCourses) {
+    if (syntheticStudents > 0) {
+        generateSyntheticData(syntheticStudents, syntheticCourses, 0, 2043);
+        Staff staff = { "Load Test Staff", "S001" };
+        staffList.push_back(staff);
     } else {
-        StudentNode* temp = course->studentList;
-        int count = 1;
-        while (temp != NULL) {
-            cout << count++ << ". " << temp->name << " (" << temp->matricNo << ")\n";
-            temp = temp->next;
-        }
+        loadStudents();
+        loadCourses();
+        loadStaff();
+        loadPendingRequests();
+        initCreditTotals();
     }
+    if (replication.role != REPLICATION_OFF) {
+        replication.baseDigest = stateDigest();
+        opLogging = true;
+    }
+    int code = runServer(port, menus);
+    if (syntheticStudents == 0) saveAllData();
+    return code;
 }
 
-void staffViewRequests() {
-    if (regQueue.isEmpty()) {
-        cout << "No pending requests.\n";
-        return;
+#ifdef __linux__
+// Sends lines to the server on port and returns its replies, one per line, or fewer if the connection fails
+vector<string> askServer(int port, const vector<string>& lines) {
+    vector<string> replies;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        if (fd >= 0) close(fd);
+        return replies;
     }
-    
-    while (!regQueue.isEmpty()) {
-        cout << "\n=== Pending Requests ===\n";
-        regQueue.display();
-        
-        RegistrationRequest* req = regQueue.getFront();
-        
-        if (req->isCancelled) {
-            cout << "\nRequest cancelled by student - skipping...\n";
-            regQueue.dequeue();
-            continue;
-        }
-        
-        cout << "\nProcessing request for " << req->studentName 
-             << " (" << req->matricNo << ")\n";
-        cout << "Course: " << req->courseCode << " - " << req->courseName << "\n";
-        cout << "1. Approve\n";
-        cout << "2. Reject\n";
-        cout << "3. Stop\n";
-        cout << "Choice: ";
-        
-        int choice;
-        cin >> choice;
-        cin.ignore();
-        
-        if (choice == 3) return;
-        
-        Student* student = studentTree.search(req->matricNo);
-        Course* course = courseTree.search(req->courseCode);
-        
-        if (student != NULL && course != NULL) {
-            CourseNode* courseNode = findCourseInStudent(student, req->courseCode);
-            
-            if (choice == 1) {
-                if (courseNode != NULL) {
-                    if (course->currentCapacity >= course->capacity) {
-                        cout << "Approval failed: Course is full.\n";
-                        student->currentCredit -= req->credit;
-                        removeCourseFromStudent(student, req->courseCode);
-                        string notifMsg = req->courseCode + " " + req->courseName + " auto-rejected (course full) at " + getCurrentTimestamp();
-                        student->notifications.push(notifMsg);
-                        regQueue.dequeue();
-                        continue;
-                    }
-                    courseNode->status = "Approved";
-                    course->currentCapacity++;
-                    insertStudentInCourseList(course, student->matricNo, student->name);
-                    string notifMsg = req->courseCode + " " + req->courseName + 
-                                    " approved at " + getCurrentTimestamp();
-                    student->notifications.push(notifMsg);
-                    cout << "Request approved.\n";
-                }
-            } else if (choice == 2) {
-                cout << "Enter rejection reason: ";
-                string reason;
-                getline(cin, reason);
-                
-                if (courseNode != NULL) {
-                    student->currentCredit -= req->credit;
-                    removeCourseFromStudent(student, req->courseCode);
-                    string notifMsg = req->courseCode + " " + req->courseName + 
-                                    " rejected at " + getCurrentTimestamp() + 
-                                    ". Reason: " + reason;
-                    student->notifications.push(notifMsg);
-                    cout << "Request rejected.\n";
-                }
-            }
+    string request;
+    for (size_t i = 0; i < lines.size(); i++) request += lines[i] + "\n";
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += n;
+    }
+    string input;
+    char buffer[4096];
+    while (replies.size() < lines.size()) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        input.append(buffer, n);
+        size_t end;
+        while ((end = input.find('\n')) != string::npos) {
+            replies.push_back(input.substr(0, end));
+            input.erase(0, end + 1);
         }
-        
-        regQueue.dequeue();
-        
-        cout << "\nContinue processing? (y/n): ";
-        char cont;
-        cin >> cont;
-        cin.ignore();
-        
-        if (cont != 'y' && cont != 'Y') return;
     }
-    
-    cout << "All requests processed.\n";
+    close(fd);
+    return replies;
 }
 
-void staffViewAllStudents() {
-    studentTree.displayAll();
+// The value of name=value in a STATUS reply from the server on port, or "" if there is none
+string statusField(int port, const string& name) {
+    vector<string> replies = askServer(port, vector<string>(1, "STATUS"));
+    if (replies.empty()) return "";
+    size_t at = replies[0].find(" " + name + "=");
+    if (at == string::npos) return "";
+    at += name.size() + 2;
+    return replies[0].substr(at, replies[0].find(' ', at) - at);
 }
 
-void staffSearchStudent() {
-    cout << "Enter Matric No: ";
-    string matric;
-    getline(cin, matric);
-    
-    Student* student = studentTree.search(matric);
-    if (student == NULL) {
-        cout << "Student not found.\n";
-    } else {
-        cout << "\n=== Student Details ===\n";
-        cout << "Name: " << student->name << "\n";
-        cout << "Matric No: " << student->matricNo << "\n";
-        cout << "Program: " << student->program << "\n";
-        cout << "Year: " << student->year << "\n";
-        cout << "Credits: " << student->currentCredit << "/" << student->maxCredit << "\n";
-        
-        cout << "\n=== Registered Courses ===\n";
-        if (student->courseList == NULL) {
-            cout << "No courses registered.\n";
-        } else {
-            CourseNode* current = student->courseList;
-            while (current != NULL) {
-                Course* course = courseTree.search(current->courseCode);
-                if (course != NULL) {
-                    cout << course->courseCode << " - " << course->courseName 
-                         << " [" << current->status << "]\n";
-                }
-                current = current->next;
-            }
-        }
+pid_t startNode(ReplicationRole role, int port, int replicationPort, int upstreamPort, int students, int courses) {
+    cout << flush;
+    pid_t child = fork();
+    if (child == 0) {
+        replication.role = role;
+        replication.port = replicationPort;
+        replication.upstreamPort = upstreamPort;
+        cout.setstate(ios::failbit);
+        _exit(serveData(port, false, students, courses));
     }
+    return child;
 }
 
-void staffInsertStudent() {
-    string studentName, matricNo, program;
-    int maxCredit, currentCredit, year;
-    cout << "Enter Student Name: ";
-    getline(cin, studentName);
-    cout << "Enter Matric No: ";
-    getline(cin, matricNo);
-    cout << "Enter Max Credit: ";
-    cin >> maxCredit;
-    cout << "Enter Year: ";
-    cin >> year;
-    cin.ignore();
-    cout << "Enter Program: ";
-    getline(cin, program);
-    currentCredit = 0;
-    Student* newStudent = new Student(studentName, matricNo, maxCredit, currentCredit, year, program);
-    
-    // cannot insert duplicate matric no
-    if (studentTree.search(newStudent->matricNo) != NULL) {
-        cout << "Student with this Matric No already exists.\n";
-        delete newStudent;
-        return;
+// Waits up to 10 s for the node on port to hold ops ops. Returns the wait in ms, or -1 on timeout.
+double waitForOps(int port, const string& ops) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (elapsedMs(start) < 10000) {
+        if (statusField(port, "ops") == ops) return elapsedMs(start);
+        usleep(1000);
     }
-    studentTree.insert(newStudent);
-    cout << "Student inserted successfully.\n";
+    return -1;
 }
 
-void staffUpdateCourse() {
-    cout << "Enter Course Code: ";
+void stopNode(int port, pid_t child) {
+    vector<string> lines;
+    lines.push_back("LOGIN S001");
+    lines.push_back("SHUTDOWN");
+    askServer(port, lines);
+    waitpid(child, NULL, 0);
+}
+
+// A primary and a replica on synthetic data in child processes. The load generator writes to the
+// primary and the replica is checked against it; then the primary is killed, the replica promoted,
+// and a new replica rebuilds everything from the promoted one's log.
+int benchReplication(int clients, int requestsPerClient) {
+    const int students = 20000, courses = 1000;
+    const int primaryPort = 25561, replicaPort = 25563, rebuiltPort = 25565; // each replicates on port + 1, below the ephemeral range
+    pid_t primary = startNode(REPLICATION_PRIMARY, primaryPort, primaryPort + 1, 0, students, courses);
+    pid_t replica = startNode(REPLICATION_REPLICA, replicaPort, replicaPort + 1, primaryPort + 1, students, courses);
+    if (!waitForServer(primaryPort) || !waitForServer(replicaPort)) {
+        cout << "Servers did not start.\n";
+        kill(primary, SIGKILL);
+        kill(replica, SIGKILL);
+        waitpid(primary, NULL, 0);
+        waitpid(replica, NULL, 0);
+        return 1;
+    }
+    cout << "Primary and replica up with " << students << " students x " << courses << " courses\n";
+    int code = runLoadTest(primaryPort, clients, requestsPerClient, students, courses);
+
+    string ops = statusField(primaryPort, "ops");
+    double catchUpMs = waitForOps(replicaPort, ops);
+    bool same = statusField(primaryPort, "digest") == statusField(replicaPort, "digest");
+    cout << fixed << setprecision(1);
+    cout << "Primary logged " << ops << " ops; the replica had applied them all " << catchUpMs << " ms after the load ended\n";
+    cout << "Replica lag per op (ms, last/avg/max): " << statusField(replicaPort, "lag_ms") << "\n";
+    cout << "Primary and replica data identical: " << (same ? "yes" : "NO") << "\n";
+    if (catchUpMs < 0 || !same) code = 1;
+
+    kill(primary, SIGKILL);
+    waitpid(primary, NULL, 0);
+    vector<string> lines;
+    lines.push_back("LOGIN S001");
+    lines.push_back("PROMOTE");
+    lines.push_back("ADDCOURSE ZREP1001;Replication Check;Promoted Primary;3;40");
+    vector<string> replies = askServer(replicaPort, lines);
+    cout << "Primary killed. Replica: " << (replies.size() == 3 ? replies[1] + ", write after promotion: " + replies[2] : "no reply") << "\n";
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    pid_t rebuilt = startNode(REPLICATION_REPLICA, rebuiltPort, rebuiltPort + 1, replicaPort + 1, students, courses);
+    ops = statusField(replicaPort, "ops");
+    double rebuildMs = waitForServer(rebuiltPort) ? waitForOps(rebuiltPort, ops) : -1;
+    same = rebuildMs >= 0 && statusField(replicaPort, "digest") == statusField(rebuiltPort, "digest");
+    cout << "New replica generated its data and replayed " << ops << " ops from the promoted primary in "
+         << elapsedMs(start) << " ms; data identical: " << (same ? "yes" : "NO") << "\n";
+    if (!same) code = 1;
+
+    stopNode(rebuiltPort, rebuilt);
+    stopNode(replicaPort, replica);
+    return code;
+}
+#else
+int benchReplication(int clients, int requestsPerClient) {
+    cout << "Replication needs Linux (epoll).\n";
+    return 1;
+}
+#endif
+
+// Sharding
+// --shard-router splits the courses across worker processes by a hash of the course code. Every
+// worker holds all student records but only its own courses, with their rosters and queue, and
+// keeps the credit ledger of the students whose matric hashes to it (their home shard). The router
+// owns the client connections, keeps one connection to each worker and turns each command into
+// worker commands. maxCredit is the only rule that spans shards: REGISTER reserves the credit at
+// the home shard before asking the course's shard for a place and gives it back if that fails,
+// while drops and rejections give it back only once the place is gone. The ledger can run ahead
+// of what the student holds but never behind, so the limit holds without locking two shards.
+#ifdef __linux__
+enum RouteStep { ROUTE_IGNORE, ROUTE_REPLY, ROUTE_LOGIN, ROUTE_CREDIT, ROUTE_RESERVE, ROUTE_ENROL, ROUTE_UNENROL, ROUTE_GATHER, ROUTE_DECIDE };
+
+// A command sent to a worker and what to do with its reply. It carries everything the next step
+// needs, so a reservation is still given back when its client has gone.
+struct RoutedCommand {
+    RouteStep step;
+    long long client;
+    string matric;
     string code;
-    getline(cin, code);
-    
-    Course* course = courseTree.search(code);
-    if (course == NULL) {
-        cout << "Course not found.\n";
-        return;
+    int credit;
+    string command; // ROUTE_DECIDE: the staff command, passed on while shards have nothing pending
+    int tried;
+};
+
+struct ShardLink {
+    int fd;
+    string input;
+    string output;
+    size_t outputSent;
+    bool wantWrite;
+    deque<RoutedCommand> waiting; // workers answer in order
+};
+
+struct RouterClient {
+    int fd;
+    long long id;
+    string input;
+    string output;
+    size_t outputSent;
+    bool wantWrite;
+    string user;
+    bool staff;
+    bool busy;    // one command at a time; later lines wait in input
+    bool closing;
+    int gathering; // fan-out replies still to come
+    vector<string> gathered;
+};
+
+class ShardRouter {
+public:
+    ShardRouter(int epfd, int shards);
+    ~ShardRouter();
+    bool connectShard(int index, int port);
+    void accept(int fd);
+    // Handles readiness on a client or worker connection (epoll data: worker index + 1, or client id)
+    void ready(long long id, unsigned events);
+
+private:
+    int epfd;
+    vector<ShardLink> links;
+    unordered_map<long long, RouterClient*> clients;
+    unordered_map<string, int> creditOf; // course credits seen so far
+    vector<long long> touched; // clients with new input or replies since the last flush
+    long long nextId;
+    int turn; // the shard staff commands start at
+
+    void send(int shard, const RoutedCommand& routed, const string& line);
+    void fanOut(RouterClient* client, const string& line);
+    void answer(RouterClient* client, const string& line);
+    void reserve(const RoutedCommand& routed);
+    void release(const string& matric, int credit);
+    void command(RouterClient* client, const string& line);
+    void shardReply(int shard, const string& line);
+    void serveClient(RouterClient* client);
+    void watch(int fd, long long id, bool& wantWrite, bool pending);
+    void closeClient(RouterClient* client);
+    RouterClient* findClient(long long id);
+};
+
+ShardRouter::ShardRouter(int epfd, int shards) : epfd(epfd), links(shards), nextId(1LL << 32), turn(0) {
+    for (int i = 0; i < shards; i++) links[i].fd = -1;
+}
+
+ShardRouter::~ShardRouter() {
+    for (unordered_map<long long, RouterClient*>::iterator it = clients.begin(); it != clients.end(); ++it) {
+        close(it->second->fd);
+        delete it->second;
     }
-    
-    cout << "\nCurrent Details:\n";
-    cout << "Lecturer: " << course->lecturerName << "\n";
-    cout << "Capacity: " << course->capacity << "\n";
-    
-    cout << "\n1. Update Lecturer\n";
-    cout << "2. Update Capacity\n";
-    cout << "3. Update Both\n";
-    cout << "Choice: ";
-    
-    int choice;
-    cin >> choice;
-    cin.ignore();
-    
-    if (choice == 1 || choice == 3) {
-        cout << "Enter New Lecturer Name: ";
-        getline(cin, course->lecturerName);
+    for (size_t i = 0; i < links.size(); i++) {
+        if (links[i].fd >= 0) close(links[i].fd);
     }
-    
-    if (choice == 2 || choice == 3) {
-        cout << "Enter New Capacity: ";
-        cin >> course->capacity;
-        cin.ignore();
+}
+
+// Connects to a worker that is already listening and logs in as staff
+bool ShardRouter::connectShard(int index, int port) {
+    ShardLink& link = links[index];
+    link.fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (link.fd < 0 || connect(link.fd, (sockaddr*)&address, sizeof(address)) < 0) return false;
+    int yes = 1;
+    setsockopt(link.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    fcntl(link.fd, F_SETFL, fcntl(link.fd, F_GETFL) | O_NONBLOCK);
+    link.outputSent = 0;
+    link.wantWrite = true;
+    epoll_event added;
+    added.events = EPOLLIN | EPOLLOUT;
+    added.data.u64 = index + 1;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, link.fd, &added);
+    RoutedCommand login = { ROUTE_IGNORE, 0, "", "", 0, "", 0 };
+    send(index, login, "LOGIN S001");
+    return true;
+}
+
+void ShardRouter::accept(int fd) {
+    RouterClient* client = new RouterClient();
+    client->fd = fd;
+    client->id = nextId++;
+    client->outputSent = 0;
+    client->wantWrite = false;
+    client->staff = client->busy = client->closing = false;
+    client->gathering = 0;
+    clients[client->id] = client;
+    epoll_event added;
+    added.events = EPOLLIN;
+    added.data.u64 = client->id;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &added);
+}
+
+void ShardRouter::watch(int fd, long long id, bool& wantWrite, bool pending) {
+    if (pending == wantWrite) return;
+    wantWrite = pending;
+    epoll_event changed;
+    changed.events = pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    changed.data.u64 = id;
+    epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &changed);
+}
+
+RouterClient* ShardRouter::findClient(long long id) {
+    unordered_map<long long, RouterClient*>::iterator it = clients.find(id);
+    return it == clients.end() ? NULL : it->second;
+}
+
+void ShardRouter::send(int shard, const RoutedCommand& routed, const string& line) {
+    ShardLink& link = links[shard];
+    link.waiting.push_back(routed);
+    link.output += line + "\n";
+}
+
+void ShardRouter::fanOut(RouterClient* client, const string& line) {
+    client->gathering = links.size();
+    client->gathered.clear();
+    RoutedCommand gather = { ROUTE_GATHER, client->id, "", "", 0, line, 0 };
+    for (size_t i = 0; i < links.size(); i++) send(i, gather, line);
+}
+
+// Ends the client's current command with one reply line, if the client is still connected
+void ShardRouter::answer(RouterClient* client, const string& line) {
+    if (client == NULL) return;
+    client->output += line + "\n";
+    client->busy = false;
+    touched.push_back(client->id);
+}
+
+void ShardRouter::reserve(const RoutedCommand& routed) {
+    RoutedCommand next = routed;
+    next.step = ROUTE_RESERVE;
+    send(shardOf(routed.matric, links.size()), next, "RESERVE " + routed.matric + " " + to_string(routed.credit));
+}
+
+void ShardRouter::release(const string& matric, int credit) {
+    RoutedCommand ignored = { ROUTE_IGNORE, 0, "", "", 0, "", 0 };
+    send(shardOf(matric, links.size()), ignored, "UNRESERVE " + matric + " " + to_string(credit));
+}
+
+void ShardRouter::command(RouterClient* client, const string& line) {
+    size_t space = line.find(' ');
+    string verb = toUpperCopy(line.substr(0, space));
+    string arg = space == string::npos ? "" : line.substr(space + 1);
+    int shards = links.size();
+    RoutedCommand routed = { ROUTE_REPLY, client->id, client->user, arg, 0, line, 0 };
+    client->busy = true;
+
+    if (verb == "LOGIN") {
+        routed.step = ROUTE_LOGIN;
+        send(shardOf(arg, shards), routed, "WHO " + arg);
+    } else if (verb == "COURSE") {
+        send(shardOf(arg, shards), routed, line);
+    } else if (verb == "SEARCH") {
+        fanOut(client, "MATCH " + arg);
+    } else if (verb == "QUIT") {
+        answer(client, "OK Bye");
+        client->closing = true;
+    } else if (verb == "HELP") {
+        answer(client, string("OK ") + SERVER_HELP);
+    } else if (verb == "STATUS") {
+        answer(client, "OK role=router shards=" + to_string(shards));
+    } else if (verb == "REGISTER" || verb == "DROP" || verb == "MYCOURSES") {
+        if (client->user.empty() || client->staff) {
+            answer(client, "ERR Log in as a student first");
+        } else if (verb == "MYCOURSES") {
+            fanOut(client, "COURSES " + client->user);
+        } else if (verb == "DROP") {
+            routed.step = ROUTE_UNENROL;
+            send(shardOf(arg, shards), routed, "UNENROL " + client->user + " " + arg);
+        } else if (splitCodes(arg).size() > 1) {
+            answer(client, "ERR Packages cannot be registered on a sharded server");
+        } else if (creditOf.count(arg) > 0) {
+            routed.credit = creditOf[arg];
+            reserve(routed);
+        } else {
+            routed.step = ROUTE_CREDIT;
+            send(shardOf(arg, shards), routed, "COURSE " + arg);
+        }
+    } else if (verb == "NEXT" || verb == "APPROVE" || verb == "REJECT" || verb == "PENDING" || verb == "CAPACITY" || verb == "SHUTDOWN") {
+        if (!client->staff) {
+            answer(client, "ERR Log in as staff first");
+        } else if (verb == "PENDING" || verb == "CAPACITY") {
+            send(shardOf(arg.substr(0, arg.find(' ')), shards), routed, line);
+        } else if (verb == "SHUTDOWN") {
+            answer(client, "OK Shutting down");
+            serverStopRequested = 1;
+        } else {
+            // Each shard keeps its own queue, so requests are decided oldest first within a shard
+            // and staff move round the shards in turn
+            routed.step = ROUTE_DECIDE;
+            send(turn, routed, line);
+        }
+    } else if (verb == "RETRACT" || verb == "ADDCOURSE" || verb == "DELCOURSE" || verb == "PROMOTE") {
+        answer(client, "ERR Not available on a sharded server");
+    } else {
+        answer(client, "ERR Unknown command. Commands: " + string(SERVER_HELP));
     }
-    
-    cout << "Course updated successfully.\n";
 }
 
-void staffInsertCourse() {
-    string courseCode, courseName, lecturerName;
-    int credit, capacity, currentCapacity;
-    cout << "Enter Course Code: ";
-    getline(cin, courseCode);
-    cout << "Enter Course Name: ";
-    getline(cin, courseName);
-    cout << "Enter Lecturer Name: ";
-    getline(cin, lecturerName);
-    cout << "Enter Credit: ";
-    cin >> credit;
-    cout << "Enter Capacity: ";
-    cin >> capacity;
-    cin.ignore();
-    currentCapacity = 0;
-    Course* newCourse = new Course(courseCode, courseName, lecturerName, credit, capacity, currentCapacity);
-    // cannot insert duplicate course code
-    if (courseTree.search(newCourse->courseCode) != NULL) {
-        cout << "Course with this code already exists.\n";
-        delete newCourse;
-        return;
+void ShardRouter::shardReply(int shard, const string& line) {
+    ShardLink& link = links[shard];
+    if (link.waiting.empty()) return;
+    RoutedCommand done = link.waiting.front();
+    link.waiting.pop_front();
+    RouterClient* client = findClient(done.client);
+    bool ok = line.compare(0, 2, "OK") == 0;
+
+    switch (done.step) {
+    case ROUTE_IGNORE:
+        break;
+    case ROUTE_REPLY:
+        answer(client, line);
+        break;
+    case ROUTE_LOGIN:
+        if (client != NULL) {
+            client->staff = line.compare(0, 8, "OK STAFF") == 0;
+            client->user = ok ? done.code : "";
+        }
+        answer(client, line);
+        break;
+    case ROUTE_CREDIT:
+        if (!ok) {
+            answer(client, line);
+        } else {
+            // OK code;name;lecturer;credit;seats
+            size_t at = 0;
+            for (int field = 0; field < 3 && at != string::npos; field++) at = line.find(';', at + 1);
+            done.credit = at == string::npos ? 0 : atoi(line.c_str() + at + 1);
+            creditOf[done.code] = done.credit;
+            reserve(done);
+        }
+        break;
+    case ROUTE_RESERVE:
+        if (!ok) {
+            answer(client, line);
+        } else {
+            done.step = ROUTE_ENROL;
+            send(shardOf(done.code, links.size()), done, "ENROL " + done.matric + " " + done.code);
+        }
+        break;
+    case ROUTE_ENROL:
+        if (!ok) release(done.matric, done.credit);
+        answer(client, line);
+        break;
+    case ROUTE_UNENROL:
+        if (ok) {
+            release(done.matric, atoi(line.c_str() + 3));
+            answer(client, "OK Dropped");
+        } else {
+            answer(client, line);
+        }
+        break;
+    case ROUTE_GATHER:
+        if (client == NULL) break;
+        // A shard that could not answer adds nothing
+        if (line.size() > 3 && line.compare(0, 3, "OK ") == 0) client->gathered.push_back(line.substr(3));
+        if (--client->gathering == 0) {
+            string merged;
+            if (done.command.compare(0, 6, "MATCH ") == 0) {
+                // Every shard sends its best ten, prefix matches if it has any; like one server, prefix
+                // matches from any shard win over substring matches. Keep the first ten codes.
+                bool anyPrefix = false;
+                for (size_t i = 0; i < client->gathered.size(); i++) {
+                    if (client->gathered[i].compare(0, 7, "PREFIX ") == 0) anyPrefix = true;
+                }
+                vector<string> codes;
+                for (size_t i = 0; i < client->gathered.size(); i++) {
+                    const string& reply = client->gathered[i];
+                    bool prefix = reply.compare(0, 6, "PREFIX") == 0;
+                    size_t space = reply.find(' ');
+                    if (prefix != anyPrefix || space == string::npos) continue;
+                    stringstream found(reply.substr(space + 1));
+                    string code;
+                    while (getline(found, code, ',')) codes.push_back(code);
+                }
+                sort(codes.begin(), codes.end());
+                for (size_t i = 0; i < codes.size() && i < 10; i++) merged += (i == 0 ? "" : ",") + codes[i];
+            } else {
+                for (size_t i = 0; i < client->gathered.size(); i++) merged += (i == 0 ? "" : ",") + client->gathered[i];
+            }
+            answer(client, merged.empty() ? "OK" : "OK " + merged);
+        }
+        break;
+    case ROUTE_DECIDE:
+        if (line == "OK No pending requests" && ++done.tried < (int)links.size()) {
+            send((shard + 1) % links.size(), done, done.command);
+            break;
+        }
+        // NEXT shows what the following APPROVE or REJECT will decide
+        turn = toUpperCopy(done.command.substr(0, 4)) == "NEXT" ? shard : (shard + 1) % links.size();
+        if (line.compare(0, 12, "OK Rejected ") == 0 || line.compare(0, 13, "OK Auto-rejec") == 0) {
+            // ... matric code
+            size_t codeAt = line.rfind(' ');
+            size_t matricAt = line.rfind(' ', codeAt - 1);
+            release(line.substr(matricAt + 1, codeAt - matricAt - 1), creditOf[line.substr(codeAt + 1)]);
+        }
+        answer(client, line);
+        break;
     }
-    courseTree.insert(newCourse);
-    cout << "Course inserted successfully.\n";
 }
 
-void staffDeleteCourse() {
-    cout << "Enter Course Code: ";
-    string code;
-    getline(cin, code);
-    
-    Course* course = courseTree.search(code);
-    if (course == NULL) {
-        cout << "Course not found.\n";
-        return;
-    }
-    // if course have student cannot delete
-    if (course->studentList != NULL) {
-        cout << "Cannot delete course with enrolled students.\n";
-        return;
+// Runs the client's buffered lines until one has to wait for the workers
+void ShardRouter::serveClient(RouterClient* client) {
+    size_t end;
+    while (!client->busy && !client->closing && (end = client->input.find('\n')) != string::npos) {
+        string line = client->input.substr(0, end);
+        client->input.erase(0, end + 1);
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        command(client, line);
     }
-    courseTree.deleteCourse(code);
-    cout << "Course deleted successfully.\n";
 }
 
-void staffViewStudentListInCourse() {
-    cout << "Enter Course Code: ";
-    string code;
-    getline(cin, code);
-    
-    Course* course = courseTree.search(code);
-    if (course == NULL) {
-        cout << "Course not found.\n";
-        return;
-    }
-    
-    cout << "\n=== Students in " << course->courseCode << " - " << course->courseName << " ===\n";
-    
-    if (course->studentList == NULL) {
-        cout << "No students in this course.\n";
+void ShardRouter::closeClient(RouterClient* client) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    clients.erase(client->id);
+    delete client;
+}
+
+void ShardRouter::ready(long long id, unsigned events) {
+    if (id <= (long long)links.size()) {
+        int shard = id - 1;
+        ShardLink& link = links[shard];
+        if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            bool open = readSocket(link.fd, link.input);
+            size_t start = 0, end;
+            while ((end = link.input.find('\n', start)) != string::npos) {
+                shardReply(shard, link.input.substr(start, end - start));
+                start = end + 1;
+            }
+            link.input.erase(0, start);
+            if (!open) {
+                cout << "Shard " << shard << " closed its connection; stopping.\n";
+                serverStopRequested = 1;
+            }
+        }
     } else {
-        StudentNode* temp = course->studentList;
-        int count = 1;
-        while (temp != NULL) {
-            cout << count++ << ". " << temp->name << " (" << temp->matricNo << ")\n";
-            temp = temp->next;
+        RouterClient* client = findClient(id);
+        if (client == NULL) return;
+        bool open = true;
+        if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            open = readSocket(client->fd, client->input);
+            if (client->input.size() > SERVER_MAX_LINE && client->input.find('\n') == string::npos) open = false;
         }
+        if (!open) {
+            closeClient(client);
+            return;
+        }
+        touched.push_back(id);
     }
-    
-    cout << "\nDownload list? (y/n): ";
-    char choice;
-    cin >> choice;
-    cin.ignore();
-    
-    if (choice == 'y' || choice == 'Y') {
-        string filename = course->courseCode + "_StudentList.txt";
-        ofstream file(filename.c_str());
-        
-        file << "=== Students in " << course->courseCode << " - " << course->courseName << " ===\n\n";
-        
-        StudentNode* temp = course->studentList;
-        int count = 1;
-        while (temp != NULL) {
-            file << count++ << ". " << temp->name << " (" << temp->matricNo << ")\n";
-            temp = temp->next;
+
+    // Worker replies may have finished commands for other clients, and their next lines can run now
+    for (size_t i = 0; i < touched.size(); i++) {
+        RouterClient* client = findClient(touched[i]);
+        if (client == NULL) continue;
+        serveClient(client);
+        if (!flushSocket(client->fd, client->output, client->outputSent) || (client->closing && client->output.empty())) {
+            closeClient(client);
+        } else {
+            watch(client->fd, client->id, client->wantWrite, !client->output.empty());
         }
-        
-        file.close();
-        cout << "List downloaded as " << filename << "\n";
+    }
+    touched.clear();
+    for (size_t i = 0; i < links.size(); i++) {
+        if (!flushSocket(links[i].fd, links[i].output, links[i].outputSent)) serverStopRequested = 1;
+        watch(links[i].fd, i + 1, links[i].wantWrite, !links[i].output.empty());
     }
 }
 
-void staffViewAllCourses() {
-    courseTree.displayAll();
+// One worker of a sharded server: every student of the synthetic data, but only the courses that
+// hash to index. Workers start with no registrations, so every credit they hold went through a router.
+int runShard(int index, int count, int port, int students, int courses) {
+    shardIndex = index;
+    shardCount = count;
+    generateSyntheticData(students, courses, 0, 2043);
+    Staff staff = { "Load Test Staff", "S001" };
+    staffList.push_back(staff);
+    return runServer(port, false);
 }
 
-void staffRetractCourse() {
-    cout << "Enter Student Matric No: ";
-    string matric;
-    getline(cin, matric);
-    
-    Student* student = studentTree.search(matric);
-    if (student == NULL) {
-        cout << "Student not found.\n";
-        return;
-    }
-    
-    cout << "\n=== Student: " << student->name << " (" << student->matricNo << ") ===\n";
-    cout << "Registered Courses:\n";
-    
-    if (student->courseList == NULL) {
-        cout << "No courses registered.\n";
-        return;
-    }
-    
-    int count = 1;
-    CourseNode* current = student->courseList;
-    while (current != NULL) {
-        Course* course = courseTree.search(current->courseCode);
-        if (course != NULL) {
-            cout << count++ << ". " << course->courseCode << " - " 
-                 << course->courseName << " [" << current->status << "]\n";
+// Serves synthetic data on 127.0.0.1:port from shards worker processes on port + 1 ... port + shards.
+// Returns 0 on a clean stop; the workers stop with the router.
+int runShardRouter(int port, int shards, int students, int courses) {
+    raiseFileLimit();
+    vector<pid_t> workers;
+    cout << "Starting " << shards << " shard worker(s) on ports " << port + 1 << "-" << port + shards << "...\n" << flush;
+    for (int i = 0; i < shards; i++) {
+        pid_t child = fork();
+        if (child == 0) {
+            cout.setstate(ios::failbit);
+            _exit(runShard(i, shards, port + 1 + i, students, courses));
         }
-        current = current->next;
-    }
-    
-    cout << "\nEnter Course Code to retract: ";
-    string code;
-    getline(cin, code);
-    
-    CourseNode* courseNode = findCourseInStudent(student, code);
-    if (courseNode == NULL) {
-        cout << "Course not found in student's registered courses.\n";
-        return;
+        workers.push_back(child);
     }
-    
-    Course* course = courseTree.search(code);
-    if (course != NULL) {
-        student->currentCredit -= course->credit;
-        
-        if (courseNode->status == "Approved") {
-            removeStudentFromCourseList(course, matric);
-            course->currentCapacity--;
+
+    int epfd = epoll_create1(0);
+    int listener = -1, yes = 1;
+    ShardRouter* router = new ShardRouter(epfd, shards);
+    bool up = true;
+    for (int i = 0; i < shards && up; i++) up = waitForServer(port + 1 + i) && router->connectShard(i, port + 1 + i);
+    if (up) {
+        listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+            cout << "Cannot listen on port " << port << ": " << strerror(errno) << "\n";
+            up = false;
         }
-    }
-    
-    removeCourseFromStudent(student, code);
-    
-    cout << "Course retracted successfully.\n";
-    cout << "\nUpdated Registered Courses:\n";
-    
-    if (student->courseList == NULL) {
-        cout << "No courses registered.\n";
     } else {
-        CourseNode* current = student->courseList;
-        while (current != NULL) {
-            Course* c = courseTree.search(current->courseCode);
-            if (c != NULL) {
-                cout << c->courseCode << " - " << c->courseName 
-                     << " [" << current->status << "]\n";
+        cout << "Shard workers did not start.\n";
+    }
+
+    int code = 1;
+    if (up) {
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = 0; // the listener
+        epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &event);
+        serverStopRequested = 0;
+        signal(SIGINT, onServerSignal);
+        signal(SIGTERM, onServerSignal);
+        cout << "Routing 127.0.0.1:" << port << " to " << shards << " shard(s) (Ctrl+C to stop)\n" << flush;
+
+        vector<epoll_event> ready(1024);
+        while (!serverStopRequested) {
+            int count = epoll_wait(epfd, &ready[0], ready.size(), 500);
+            if (count < 0 && errno != EINTR) break;
+            for (int i = 0; i < count; i++) {
+                if (ready[i].data.u64 != 0) {
+                    router->ready(ready[i].data.u64, ready[i].events);
+                    continue;
+                }
+                int fd;
+                while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+                    router->accept(fd);
+                }
             }
-            current = current->next;
         }
+        cout << "Router stopped.\n";
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        code = 0;
     }
+
+    delete router;
+    if (listener >= 0) close(listener);
+    close(epfd);
+    for (int i = 0; i < shards; i++) kill(workers[i], SIGTERM);
+    for (int i = 0; i < shards; i++) waitpid(workers[i], NULL, 0);
+    return code;
 }
 
-void staffInsertCourseForStudent() {
-    cout << "Enter Student Matric No: ";
-    string matric;
-    getline(cin, matric);
-    
-    Student* student = studentTree.search(matric);
-    if (student == NULL) {
-        cout << "Student not found.\n";
-        return;
-    }
-    
-    cout << "\n=== Student: " << student->name << " (" << student->matricNo << ") ===\n";
-    cout << "Current Registered Courses:\n";
-    
-    if (student->courseList == NULL) {
-        cout << "No courses registered.\n";
-    } else {
-        CourseNode* current = student->courseList;
-        while (current != NULL) {
-            Course* c = courseTree.search(current->courseCode);
-            if (c != NULL) {
-                cout << c->courseCode << " - " << c->courseName 
-                     << " [" << current->status << "]\n";
-            }
-            current = current->next;
+// The same load against an unsharded server, then routers over 1, 2, 4 and 8 workers
+int benchShards(int clients, int requestsPerClient) {
+    const int students = 100000, courses = 3000;
+    int code = 0;
+    for (int shards = 0; shards <= 8; shards = shards == 0 ? 1 : shards * 2) {
+        const int port = 25600 + shards * 10; // workers take the next ports, all below the ephemeral range
+        cout << flush;
+        pid_t child = fork();
+        if (child == 0) {
+            cout.setstate(ios::failbit);
+            _exit(shards == 0 ? serveData(port, false, students, courses) : runShardRouter(port, shards, students, courses));
+        }
+        cout << (shards == 0 ? string("Unsharded server") : to_string(shards) + " shard(s) behind a router") << ", "
+             << students << " students x " << courses << " courses:\n";
+        if (!waitForServer(port)) {
+            cout << "Server did not start.\n";
+            kill(child, SIGTERM);
+            waitpid(child, NULL, 0);
+            code = 1;
+            continue;
         }
+        if (runLoadTest(port, clients, requestsPerClient, students, courses) != 0) code = 1;
+        stopNode(port, child);
     }
-    
-    cout << "\nEnter Course Code to insert: ";
-    string code;
-    getline(cin, code);
-    
-    Course* course = courseTree.search(code);
-    if (course == NULL) {
-        cout << "Course not found.\n";
-        return;
+    return code;
+}
+#else
+int runShardRouter(int port, int shards, int students, int courses) {
+    cout << "Sharding needs Linux (epoll).\n";
+    return 1;
+}
+
+int benchShards(int clients, int requestsPerClient) {
+    return runShardRouter(0, 0, 0, 0);
+}
+#endif
+
+// Command-line modes that run without the interactive menus and never save the data files
+int runCommandLine(int argc, char* argv[]) {
+    string mode = argv[1];
+    if (mode == "--bench-allocation") {
+        int numStudents = argc > 2 ? atoi(argv[2]) : 100000;
+        int numCourses = argc > 3 ? atoi(argv[3]) : 3000;
+        benchAllocation(numStudents, numCourses);
+        return 0;
     }
-    
-    if (findCourseInStudent(student, code) != NULL) {
-        cout << "Student already registered for this course.\n";
-        return;
+    if (mode == "--bench-student-index") {
+        benchStudentIndex(argc > 2 ? atoi(argv[2]) : 100000);
+        return 0;
     }
-    
-    if (student->currentCredit + course->credit > student->maxCredit) {
-        cout << "Cannot insert: Exceeds maximum credit limit.\n";
-        return;
+    if (mode == "--bench-packed-keys") {
+        benchPackedKeys(argc > 2 ? atoi(argv[2]) : 1000000);
+        return 0;
     }
-    
-    if (course->currentCapacity >= course->capacity) {
-        cout << "Cannot insert: Course is full.\n";
-        return;
+    if (mode == "--bench-queue-position") {
+        benchQueuePosition(argc > 2 ? atoi(argv[2]) : 100000, argc > 3 ? atoi(argv[3]) : 3000);
+        return 0;
     }
-    
-    addCourseToStudent(student, code, "Approved");
-    student->currentCredit += course->credit;
-    insertStudentInCourseList(course, student->matricNo, student->name);
-    course->currentCapacity++;
-    
-    cout << "Course inserted successfully for student.\n";
-    cout << "\nUpdated Registered Courses:\n";
-    
-    CourseNode* current = student->courseList;
-    while (current != NULL) {
-        Course* c = courseTree.search(current->courseCode);
-        if (c != NULL) {
-            cout << c->courseCode << " - " << c->courseName 
-                 << " [" << current->status << "]\n";
+    if (mode == "--bench-course-queue") {
+        benchCourseQueue(argc > 2 ? atoi(argv[2]) : 100000, argc > 3 ? atoi(argv[3]) : 3000);
+        return 0;
+    }
+    if (mode == "--bench-cohort") {
+        benchCohort(argc > 2 ? atoi(argv[2]) : 100000);
+        return 0;
+    }
+    if (mode == "--bench-packages") {
+        benchPackages(argc > 2 ? atoi(argv[2]) : 100000, argc > 3 ? atoi(argv[3]) : 3000);
+        return 0;
+    }
+    if (mode == "--bench-drain") {
+        benchDrain(argc > 2 ? atoi(argv[2]) : 1000000, argc > 3 ? atoi(argv[3]) : 20000);
+        return 0;
+    }
+    if (mode == "--bench-listing") {
+        benchListing(argc > 2 ? atoi(argv[2]) : 100000);
+        return 0;
+    }
+    if (mode == "--stress-deep-trees") {
+        stressDeepTrees(argc > 2 ? atoi(argv[2]) : 1000000);
+        return 0;
+    }
+    if (mode == "--bench-trace") {
+        benchTrace();
+        return 0;
+    }
+    if (mode == "--bench-export") {
+        int numStudents = argc > 2 ? atoi(argv[2]) : 100000;
+        int threads = argc > 3 ? atoi(argv[3]) : defaultExportThreads();
+        benchExport(numStudents, max(1, threads));
+        return 0;
+    }
+    if (mode == "--bench-analytics") {
+        benchAnalytics(argc > 2 ? atoi(argv[2]) : 200000, argc > 3 ? atoi(argv[3]) : 40000);
+        return 0;
+    }
+    if (mode == "--bench-lazy-students") {
+        benchLazyStudents(argc > 2 ? atoi(argv[2]) : 200000, argc > 3 ? atoi(argv[3]) : 5000);
+        return 0;
+    }
+    if (mode == "--fuzz-records") {
+        return fuzzRecords(argc > 2 ? atoi(argv[2]) : 200000, argc > 3 ? atoi(argv[3]) : 1);
+    }
+    if (mode == "--bench-records") {
+        benchRecords(argc > 2 ? atoi(argv[2]) : 1000000);
+        return 0;
+    }
+    if (mode == "--bench-change-feed") {
+        benchChangeFeed(argc > 2 ? atoi(argv[2]) : 1000000, argc > 3 ? atoi(argv[3]) : CHANGE_RING_EVENTS);
+        return 0;
+    }
+    if (mode == "--simulate") {
+        SimConfig config;
+        if (argc > 2) config.students = atoi(argv[2]);
+        if (argc > 3) config.courses = atoi(argv[3]);
+        if (argc > 4) config.staffCount = atoi(argv[4]);
+        if (config.students < 1 || config.courses < 1 || config.staffCount < 1) {
+            cout << "Students, courses and staff must be positive.\n";
+            return 1;
         }
-        current = current->next;
+        runSimulation(config);
+        return 0;
     }
-}
-
-void insertStudentInCourseList(Course* course, string matric, string name) {
-    StudentNode* newNode = new StudentNode(matric, name);
-    
-    if (course->studentList == NULL || course->studentList->matricNo > matric) {
-        newNode->next = course->studentList;
-        course->studentList = newNode;
-    } else {
-        StudentNode* temp = course->studentList;
-        while (temp->next != NULL && temp->next->matricNo < matric) {
-            temp = temp->next;
+    if (mode == "--bench-timing-wheel") {
+        benchTimingWheel(argc > 2 ? atoll(argv[2]) : 10000000, argc > 3 ? atoi(argv[3]) : 1000000);
+        return 0;
+    }
+    if (mode == "--serve" || mode == "--serve-menus") {
+        bool menus = mode == "--serve-menus";
+        if (menus && !COROUTINE_SESSIONS) {
+            cout << "Menu sessions need a C++20 build (g++ -std=c++20).\n";
+            return 1;
         }
-        newNode->next = temp->next;
-        temp->next = newNode;
+        return serveData(argc > 2 ? atoi(argv[2]) : 5555, menus, argc > 3 ? atoi(argv[3]) : 0, argc > 4 ? atoi(argv[4]) : 3000);
     }
-}
-
-void removeStudentFromCourseList(Course* course, string matric) {
-    if (course->studentList == NULL) return;
-    
-    if (course->studentList->matricNo == matric) {
-        StudentNode* temp = course->studentList;
-        course->studentList = course->studentList->next;
-        delete temp;
-        return;
+    if (mode == "--primary") {
+        replication.role = REPLICATION_PRIMARY;
+        replication.port = argc > 3 ? atoi(argv[3]) : 6555;
+        return serveData(argc > 2 ? atoi(argv[2]) : 5555, false, argc > 4 ? atoi(argv[4]) : 0, argc > 5 ? atoi(argv[5]) : 3000);
     }
-    
-    StudentNode* temp = course->studentList;
-    while (temp->next != NULL && temp->next->matricNo != matric) {
-        temp = temp->next;
+    if (mode == "--replica") {
+        replication.role = REPLICATION_REPLICA;
+        replication.upstreamPort = argc > 3 ? atoi(argv[3]) : 6555;
+        replication.port = argc > 4 ? atoi(argv[4]) : 6556;
+        return serveData(argc > 2 ? atoi(argv[2]) : 5556, false, argc > 5 ? atoi(argv[5]) : 0, argc > 6 ? atoi(argv[6]) : 3000);
     }
-    
-    if (temp->next != NULL) {
-        StudentNode* toDelete = temp->next;
-        temp->next = temp->next->next;
-        delete toDelete;
+    if (mode == "--bench-replication") {
+        return benchReplication(argc > 2 ? atoi(argv[2]) : 200, argc > 3 ? atoi(argv[3]) : 100);
+    }
+    if (mode == "--shard-router") {
+        int shards = argc > 3 ? atoi(argv[3]) : 4;
+        if (shards < 1) {
+            cout << "Shards must be positive.\n";
+            return 1;
+        }
+        return runShardRouter(argc > 2 ? atoi(argv[2]) : 5555, shards, argc > 4 ? atoi(argv[4]) : 100000, argc > 5 ? atoi(argv[5]) : 3000);
+    }
+    if (mode == "--bench-shards") {
+        return benchShards(argc > 2 ? atoi(argv[2]) : 1000, argc > 3 ? atoi(argv[3]) : 100);
+    }
+    if (mode == "--load-test") {
+        return runLoadTest(argc > 2 ? atoi(argv[2]) : 5555, argc > 3 ? atoi(argv[3]) : 1000,
+                           argc > 4 ? atoi(argv[4]) : 100, argc > 5 ? atoi(argv[5]) : 100000,
+                           argc > 6 ? atoi(argv[6]) : 3000);
+    }
+    if (mode == "--bench-server") {
+        return benchServer(argc > 2 ? atoi(argv[2]) : 1000, argc > 3 ? atoi(argv[3]) : 100);
+    }
+    if (mode == "--bench-sessions") {
+        benchSessions(argc > 2 ? atoi(argv[2]) : 100000, argc > 3 ? atoi(argv[3]) : 1000);
+        return 0;
+    }
+    if (mode == "--bench-catalog") {
+        benchCatalog(argc > 2 ? atoi(argv[2]) : 3000);
+        return 0;
+    }
+    if (mode == "--bench-search") {
+        benchSearch(argc > 2 ? atoi(argv[2]) : 10000);
+        return 0;
     }
-}
 
-string getCurrentTimestamp(time_t t) {
-    time_t now = (t == 0) ? std::time(nullptr) : t;
-    tm* local = std::localtime(&now);
-    char buffer[20];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", local);
-    return buffer;
+    cout << "Usage: " << argv[0] << " [--stats] [--trace file.json [--trace-sample N]] [--lazy-students [cache]]"
+         << " [--change-feed file] [--change-feed-port port] [mode]\n"
+         << "       " << argv[0] << " [--bench-allocation [students] [courses]]\n"
+         << "       " << argv[0] << " [--bench-search [courses]]\n"
+         << "       " << argv[0] << " [--bench-catalog [courses]]\n"
+         << "       " << argv[0] << " [--bench-student-index [students]]\n"
+         << "       " << argv[0] << " [--bench-packed-keys [students]]\n"
+         << "       " << argv[0] << " [--bench-drain [students] [courses]]\n"
+         << "       " << argv[0] << " [--bench-packages [students] [courses]]\n"
+         << "       " << argv[0] << " [--bench-cohort [students]]\n"
+         << "       " << argv[0] << " [--bench-course-queue [students] [courses]]\n"
+         << "       " << argv[0] << " [--bench-queue-position [students] [courses]]\n"
+         << "       " << argv[0] << " [--bench-listing [students]]\n"
+         << "       " << argv[0] << " [--stress-deep-trees [records]]\n"
+         << "       " << argv[0] << " [--bench-trace]\n"
+         << "       " << argv[0] << " [--bench-export [students] [threads]]\n"
+         << "       " << argv[0] << " [--bench-analytics [students] [courses]]\n"
+         << "       " << argv[0] << " [--bench-lazy-students [students] [cache]]\n"
+         << "       " << argv[0] << " [--fuzz-records [iterations] [seed]]\n"
+         << "       " << argv[0] << " [--bench-records [records]]\n"
+         << "       " << argv[0] << " [--bench-change-feed [changes] [ring events]]\n"
+         << "       " << argv[0] << " [--simulate [students] [courses] [staff]]\n"
+         << "       " << argv[0] << " [--bench-timing-wheel [events] [pending]]\n"
+         << "       " << argv[0] << " [--serve [port] [synthetic students] [synthetic courses]]\n"
+         << "       " << argv[0] << " [--serve-menus [port] [synthetic students] [synthetic courses]]\n"
+         << "       " << argv[0] << " [--primary [port] [replication port] [synthetic students] [synthetic courses]]\n"
+         << "       " << argv[0] << " [--replica [port] [upstream port] [replication port] [synthetic students] [synthetic courses]]\n"
+         << "       " << argv[0] << " [--bench-replication [clients] [requests]]\n"
+         << "       " << argv[0] << " [--shard-router [port] [shards] [synthetic students] [synthetic courses]]\n"
+         << "       " << argv[0] << " [--bench-shards [clients] [requests]]\n"
+         << "       " << argv[0] << " [--load-test [port] [clients] [requests] [students] [courses]]\n"
+         << "       " << argv[0] << " [--bench-server [clients] [requests]]\n"
+         << "       " << argv[0] << " [--bench-sessions [sessions] [threads]]\n";
+    return 1;
 }
-
-void easterEgg() {
-    int num=0;
-    if (rand() % 100000 == 0) {
-        cout << "500 Internal Server Error\n";
-        exit(0);
-    }
-}
\ No newline at end of file